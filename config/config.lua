@@ -35,12 +35,22 @@ local default_settings = {
         enable_uptime = true,
         enable_memory = true,
         enable_cpu_temp = true,
+        -- All hwmon channels: per-core temps, fans, voltages, power
+        enable_sensors = true,
         enable_cpuinfo = true,
+        -- Per-core C-state residency and wakeups (needs enable_cpuinfo)
+        enable_cpu_idle = true,
+        -- Run-queue wait and scheduling latency per core (needs enable_cpuinfo)
+        enable_schedstat = true,
 
         -- Stats
         enable_load_and_process_stats = true,
         enable_network_stats = true,
         enable_diskstat = true,
+        -- Per-CPU /proc/interrupts and /proc/softirqs rates
+        enable_interrupts = true,
+        -- Top cgroup v2 groups by CPU, memory and I/O
+        enable_cgroups = true,
         processes = {
             enable_avg_cpu = true,
             enable_avg_mem = true,
@@ -53,6 +63,13 @@ local default_settings = {
             -- Filter out specific process names?
             ignore_list = { "kworker", "rtkit-daemon" },
             only_user_processes = false,
+
+            -- PSS/USS/swap of the top memory processes from smaps_rollup,
+            -- read off the polling thread every smaps_interval_ms. A result
+            -- is reused until the RSS moves by more than this percentage.
+            enable_smaps = true,
+            smaps_interval_ms = 5000,
+            smaps_rss_change_percent = 10,
         },
     },
     batteries = {
@@ -63,9 +80,47 @@ local default_settings = {
             icon = "⚡",
         }
     },
+    -- [MEMORY]
+    memory = {
+        -- /proc/meminfo labels to report under meminfo_fields ("*" = all)
+        fields = {
+            "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached",
+            "Dirty", "Writeback", "Slab", "Shmem", "AnonHugePages",
+            "HugePages_Total", "HugePages_Free"
+        },
+        -- Free pages per migrate type from /proc/pagetypeinfo (root only)
+        enable_pagetypeinfo = false,
+        -- Report compact_* rates from /proc/vmstat with the zone fragmentation
+        enable_compaction = true
+    },
+    -- [VMSTAT]
+    vmstat = {
+        -- /proc/vmstat counters reported as per-second rates ("*" = all)
+        counters = {
+            "pgfault", "pgmajfault", "pswpin", "pswpout",
+            "pgscan_kswapd", "pgscan_direct", "pgsteal_kswapd",
+            "pgsteal_direct", "allocstall_normal", "compact_stall",
+            "oom_kill"
+        }
+    },
+    -- [INTERRUPTS]
+    interrupts = {
+        -- Emit only the K busiest IRQ lines plus an "other" row (0 = all)
+        top_k = 10
+    },
+    -- [CGROUPS]
+    cgroups = {
+        -- Mount point of the cgroup v2 hierarchy
+        root = "/sys/fs/cgroup",
+        -- Length of each of the CPU, memory and I/O lists (0 = every cgroup)
+        top_k = 10
+    },
     -- [NETWORKING]
     network = {
+        -- Exact names or globs ("eth*", "wlp?s0"); empty means all
         interfaces = {},
+        -- Emit only the K busiest interfaces plus an "other" bucket (0 = all)
+        top_k = 0,
         -- Ping a target to check latency?
         ping_target = "8.8.8.8",
         enable_ping = false
@@ -80,6 +135,15 @@ local default_settings = {
         -- If empty, might default to auto-detect
         io_devices = {},
 
+        -- Without io_devices, emit only the K busiest devices plus an
+        -- "other" entry (0 = no limit)
+        top_k = 16,
+
+        -- Filesystem usage refresh cadence; a mount slower than the
+        -- timeout (e.g. dead NFS) is reported as stale
+        usage_interval_ms = 30000,
+        usage_timeout_ms = 2000,
+
         filters = {
             enable_loopback = false,
             enable_mapper = true,     -- Enable dm-0, etc
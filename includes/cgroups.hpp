@@ -0,0 +1,110 @@
+// cgroups.hpp
+#ifndef CGROUPS_HPP
+#define CGROUPS_HPP
+
+#include <string_view>
+#include <unordered_map>
+
+#include "pcn.hpp"
+#include "system_stability.hpp"
+
+namespace telemetry {
+
+/**
+ * @brief The directories of a cgroup v2 hierarchy, held open up to a limit.
+ * open() walks the tree once and puts an inotify watch on every directory.
+ * refresh() then only rescans the directories that reported a created,
+ * deleted or moved subdirectory. Without inotify every directory is
+ * rescanned instead. Node slots are reused; id tells a reused slot apart.
+ * Past the dirfd limit, or once the process runs out of descriptors,
+ * further nodes keep dirfd = -1 and are opened by path when read.
+ */
+class CgroupTree {
+public:
+  static constexpr size_t NO_PARENT = static_cast<size_t>(-1);
+
+  struct Node {
+    uint64_t id = 0;  // 0 for a free slot
+    std::string path; // "/system.slice/sshd.service", "" for the root
+    int dirfd = -1;   // -1 past the limit: use root() + path instead
+    int watch = -1;
+    size_t parent = NO_PARENT;
+    std::vector<size_t> children;
+  };
+
+  CgroupTree() = default;
+  ~CgroupTree();
+  CgroupTree(const CgroupTree &) = delete;
+  CgroupTree &operator=(const CgroupTree &) = delete;
+
+  // max_dirfds = 0 holds up to half of the RLIMIT_NOFILE soft limit
+  bool open(const std::string &root, size_t max_dirfds = 0);
+  void close();
+  // Applies pending inotify events; true when cgroups came or went
+  bool refresh();
+
+  // Indexed by slot, including free ones
+  const std::vector<Node> &nodes() const { return slots; }
+  size_t size() const { return slots.size() - free_slots.size(); }
+  const std::string &root() const { return root_path; }
+
+private:
+  std::string root_path;
+  int inotify_fd = -1;
+  size_t dirfd_limit = 0;
+  size_t held_dirfds = 0;
+  bool unwatched = false; // A watch failed; rescan everything instead
+  uint64_t next_id = 1;
+  std::vector<Node> slots;
+  std::vector<size_t> free_slots;
+  std::unordered_map<int, size_t> watches;
+  std::vector<std::pair<size_t, uint64_t>> dirty; // Slot and its id
+  std::vector<std::pair<size_t, uint64_t>> retry; // Listing hit EMFILE
+
+  size_t add(size_t parent, int dirfd, std::string path);
+  int open_child(size_t parent, const std::string &name);
+  void remove(size_t index);
+  bool scan(size_t index);
+  void read_events();
+};
+
+// Cumulative counters of one cgroup
+struct CgroupSample {
+  uint64_t id = 0; // CgroupTree::Node::id the values belong to
+  unsigned long long usage_usec = 0;
+  unsigned long long throttled_usec = 0;
+  unsigned long long memory_bytes = 0;
+  unsigned long long io_read_bytes = 0;
+  unsigned long long io_write_bytes = 0;
+  PsiResource memory_pressure;
+};
+
+// "usage_usec 123\nuser_usec ..."; throttling needs the cpu controller
+void parse_cgroup_cpu_stat(std::string_view text, CgroupSample &sample);
+// "8:0 rbytes=1 wbytes=2 rios=3 ...", summed over every device
+void parse_cgroup_io_stat(std::string_view text, CgroupSample &sample);
+
+struct CgroupStats {
+  std::string path;
+  double cpu_percent = 0.0; // 100 per fully used core
+  double cpu_throttled_ms_per_sec = 0.0;
+  unsigned long long memory_kb = 0;
+  double io_read_bytes_per_sec = 0.0;
+  double io_write_bytes_per_sec = 0.0;
+  PsiResource memory_pressure;
+};
+
+struct Cgroups {
+  // Mount point of the cgroup v2 hierarchy
+  std::string root = "/sys/fs/cgroup";
+  // Length of each of the CPU, memory and I/O lists (0 = every cgroup)
+  unsigned top_k = 10;
+};
+
+struct LuaCgroups : public Cgroups {
+  std::string serialize(unsigned indentation_level = 0) const;
+  void deserialize(sol::table cgroups);
+};
+
+}; // namespace telemetry
+#endif
@@ -2,6 +2,8 @@
 #ifndef CORESTAT_HPP
 #define CORESTAT_HPP
 
+#include <string_view>
+
 #include "pcn.hpp"
 
 namespace telemetry {
@@ -20,22 +22,170 @@ struct CpuSnapshot {
   unsigned long long irq = 0;
   unsigned long long softirq = 0;
   unsigned long long steal = 0;
+  size_t cpu = 0; // N of a "cpuN" row; unused for the aggregate
 
   unsigned long long get_total_time() const {
     return user + nice + system + idle + iowait + irq + softirq + steal;
   }
 };
 
+/**
+ * @brief /proc/stat counters for every row, one array per column.
+ * Row 0 is the aggregate "cpu" line, followed by one row per online CPU in
+ * ascending CPU order. Offline CPUs are not listed, so the cpu column and
+ * not the row index identifies a CPU. Keeping each column contiguous lets
+ * compute_cpu_usage() cover all cores in one pass.
+ */
+struct CpuSnapshotList {
+  std::vector<unsigned long long> user;
+  std::vector<unsigned long long> nice;
+  std::vector<unsigned long long> system;
+  std::vector<unsigned long long> idle;
+  std::vector<unsigned long long> iowait;
+  std::vector<unsigned long long> irq;
+  std::vector<unsigned long long> softirq;
+  std::vector<unsigned long long> steal;
+  std::vector<size_t> cpu;
+
+  CpuSnapshotList() = default;
+  CpuSnapshotList(std::initializer_list<CpuSnapshot> rows);
+
+  size_t size() const { return user.size(); }
+  bool empty() const { return user.empty(); }
+  void clear();
+  void reserve(size_t rows);
+  void push_back(const CpuSnapshot &row);
+  // Row of the given CPU number, or size() when it is not listed
+  size_t find_row(size_t cpu_number) const;
+};
+
+// Per-row percentages from compute_cpu_usage(), one array per field
+struct CpuUsageArrays {
+  std::vector<float> user;
+  std::vector<float> nice;
+  std::vector<float> system;
+  std::vector<float> iowait;
+  std::vector<float> idle;
+  std::vector<float> irq;
+  std::vector<float> softirq;
+  std::vector<float> steal;
+  std::vector<float> total; // user + nice + system
+  std::vector<float> scale; // Scratch: 100 / jiffies, 0 for invalid rows
+
+  void resize(size_t rows);
+};
+
+// Cumulative counters of one cpuN/cpuidle/stateM directory
+struct CpuIdleSnapshot {
+  unsigned long long time_us = 0; // Total time spent in the state
+  unsigned long long usage = 0;   // Number of times the state was entered
+};
+
+using CpuIdleSnapshotList = std::vector<CpuIdleSnapshot>;
+
+/**
+ * @brief Scheduler counters of one /proc/schedstat "cpuN" line: the time
+ * tasks spent running and runnable-but-waiting on the CPU, and the number
+ * of timeslices run. Row 0 of a list is the sum over all CPUs.
+ */
+struct SchedstatSnapshot {
+  size_t cpu = 0;
+  unsigned long long run_ns = 0;
+  unsigned long long wait_ns = 0;
+  unsigned long long timeslices = 0;
+};
+
+using SchedstatSnapshotList = std::vector<SchedstatSnapshot>;
+
+// Replaces rows with the aggregate followed by one row per listed CPU
+bool parse_schedstat(std::string_view text, SchedstatSnapshotList &rows);
+
+struct IdleStateResidency {
+  std::string name; // cpuidle state name: "POLL", "C1", "C6", ...
+  float residency_percent = 0.0f;
+};
+
 struct CoreStats {
-  size_t core_id = 0; // 0 will be aggregate, 1 will be Core 0, etc.
+  size_t core_id = 0; // 0 will be aggregate, 1 the first online CPU, etc.
+  size_t cpu = 0;     // CPU number of a per-core entry, as in "cpuN"
   float user_percent = 0.0f;
   float nice_percent = 0.0f;
   float system_percent = 0.0f;
   float iowait_percent = 0.0f;
   float idle_percent = 0.0f;
+  float irq_percent = 0.0f;
+  float softirq_percent = 0.0f;
+  float steal_percent = 0.0f;       // Taken by the hypervisor
   float total_usage_percent = 0.0f; // user + nice + system
+  // Filled in by CpuFrequencyPollingTask. The aggregate entry holds the
+  // mean frequency and the throttle events summed over cores/packages.
+  double frequency_mhz = 0.0;
+  unsigned long long core_throttle_events = 0;    // Since the last tick
+  unsigned long long package_throttle_events = 0; // Since the last tick
+  // Filled in by CpuIdlePollingTask; the aggregate holds the mean
+  // residency per state and the wakeups summed over cores.
+  std::vector<IdleStateResidency> idle_states = {};
+  double wakeups_per_sec = 0.0;
+  // Filled in by SchedstatPollingTask; the aggregate sums the deltas of
+  // every CPU before dividing.
+  double runqueue_wait_ms_per_sec = 0.0; // Runnable but not running
+  double timeslices_per_sec = 0.0;
+  double sched_latency_us = 0.0; // Mean wait per timeslice
 };
 
+/**
+ * @brief Utilization of a set of CPUs, from their summed counter deltas.
+ * id is the physical_package_id for packages, the node number for NUMA
+ * nodes, and the lowest CPU number (first SMT sibling) for physical cores.
+ */
+struct CpuGroupStats {
+  size_t id = 0;
+  size_t cpu_count = 0;
+  float user_percent = 0.0f;
+  float nice_percent = 0.0f;
+  float system_percent = 0.0f;
+  float iowait_percent = 0.0f;
+  float idle_percent = 0.0f;
+  float irq_percent = 0.0f;
+  float softirq_percent = 0.0f;
+  float steal_percent = 0.0f;
+  float total_usage_percent = 0.0f; // user + nice + system
+};
+
+/**
+ * @brief CPU topology from /sys/devices/system/cpu/cpuN/{topology,nodeM},
+ * loaded once. Groups list CPU numbers, which sum_cpu_groups() resolves
+ * through CpuSnapshotList::find_row().
+ */
+struct CpuTopology {
+  struct Group {
+    size_t id = 0;
+    std::vector<size_t> cpus;
+  };
+  std::vector<Group> packages;
+  std::vector<Group> physical_cores;
+  std::vector<Group> numa_nodes;
+
+  void load(const std::string &cpu_base = "/sys/devices/system/cpu");
+};
+
+/**
+ * @brief Computes usage percentages for the first rows of two snapshots.
+ * Rows whose counters went backwards (wrap or CPU hotplug), did not
+ * advance, or moved 2^31 jiffies or more in one tick report 100% idle.
+ */
+void compute_cpu_usage(const CpuSnapshotList &prev,
+                       const CpuSnapshotList &curr, size_t rows,
+                       CpuUsageArrays &out);
+
+// "cpu12" -> 12; false for other entries such as cpufreq or cpuidle
+bool parse_cpu_dirname(const std::string &dirname, size_t &cpu);
+
+// Sums the /proc/stat rows of each group's CPUs into one row per group
+void sum_cpu_groups(const CpuSnapshotList &rows,
+                    const std::vector<CpuTopology::Group> &groups,
+                    CpuSnapshotList &out);
+
 std::vector<CPUCore> read_cpu_times(std::istream &);
 std::string format_cpu_times(const CPUCore &, size_t);
 }; // namespace telemetry
@@ -6,8 +6,23 @@
 
 namespace telemetry {
 
+/**
+ * @brief One logical CPU's clock and cumulative throttle counters, as read
+ * from cpufreq/ and thermal_throttle/ under /sys/devices/system/cpu/cpuN.
+ */
+struct CpuFrequencySnapshot {
+  double frequency_mhz = 0.0;
+  unsigned long long core_throttles = 0;
+  unsigned long long package_throttles = 0;
+};
+
+// Indexed by CPU number (the N in cpuN / "processor : N")
+using CpuFrequencySnapshotList = std::vector<CpuFrequencySnapshot>;
+
 float get_cpu_freq_mhz(std::istream &);
 float get_cpu_freq_ghz(std::istream &);
+// Every "cpu MHz" line, indexed by the preceding "processor" number
+std::vector<double> get_core_freqs_mhz(std::istream &);
 
 }; // namespace telemetry
 #endif
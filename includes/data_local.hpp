@@ -2,6 +2,7 @@
 #ifndef DATA_LOCAL_HPP
 #define DATA_LOCAL_HPP
 
+#include "hwmonitor.hpp"
 #include "pcn.hpp"
 #include "provider.hpp"
 
@@ -28,6 +29,7 @@ struct LocalDataStreams : public DataStreamProvider {
   std::stringstream battery;
   std::stringstream top_mem_procs;
   std::stringstream top_cpu_procs;
+  HwmonSensors hwmon;
 
   /* DataStreamProvider functions */
   std::istream &get_cpuinfo_stream() override;
@@ -49,6 +51,7 @@ struct LocalDataStreams : public DataStreamProvider {
   DiskUsage get_disk_usage(const std::string &) override;
 
   double get_cpu_temperature() override;
+  void get_sensors(std::vector<SensorReading> &) override;
 
   /* LocalDataStreams functions */
   std::ifstream &create_stream_from_file(std::ifstream &stream,
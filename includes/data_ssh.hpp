@@ -2,6 +2,7 @@
 #ifndef DATA_SSH_HPP
 #define DATA_SSH_HPP
 
+#include "hwmonitor.hpp"
 #include "pcn.hpp"
 #include "provider.hpp"
 
@@ -44,6 +45,9 @@ struct ProcDataStreams : public DataStreamProvider {
   ProcDataStreams(const std::string &host, const std::string &user);
   ProcDataStreams();
   double get_cpu_temperature() override { return -1.0; }
+  void get_sensors(std::vector<SensorReading> &sensors) override {
+    sensors.clear();
+  }
   std::stringstream &create_stream_from_command(std::stringstream &stream,
                                                 const char *cmd);
   std::stringstream &create_stream_from_command(std::stringstream &stream,
@@ -18,26 +18,88 @@ enum DiskStatSettings {
   Partitions,
 };
 
+/**
+ * @brief One device line of /proc/diskstats. Times are in milliseconds.
+ * Discard fields exist since 4.18 and flush fields since 5.5; they stay zero
+ * on older kernels.
+ */
 struct DiskIoSnapshot {
   uint64_t bytes_read = 0;
   uint64_t bytes_written = 0;
+  uint64_t reads_completed = 0;
+  uint64_t reads_merged = 0;
+  uint64_t time_reading_ms = 0;
+  uint64_t writes_completed = 0;
+  uint64_t writes_merged = 0;
+  uint64_t time_writing_ms = 0;
+  uint64_t ios_in_progress = 0;
+  uint64_t io_ticks_ms = 0;
+  uint64_t weighted_io_ms = 0;
+  uint64_t discards_completed = 0;
+  uint64_t discards_merged = 0;
+  uint64_t sectors_discarded = 0;
+  uint64_t time_discarding_ms = 0;
+  uint64_t flushes_completed = 0;
+  uint64_t time_flushing_ms = 0;
 };
 
+/**
+ * @brief Per-device rates derived from two snapshots, following iostat:
+ * await is the mean time per completed request (queue + service), and
+ * util_percent is the share of wall time the device had I/O in flight.
+ */
 struct DiskIoStats {
   uint64_t read_bytes_per_sec = 0;
   uint64_t write_bytes_per_sec = 0;
+  double read_iops = 0.0;
+  double write_iops = 0.0;
+  double discard_iops = 0.0;
+  double flush_iops = 0.0;
+  double util_percent = 0.0;
+  double await_ms = 0.0;
+  double read_await_ms = 0.0;
+  double write_await_ms = 0.0;
+  double avg_queue_size = 0.0;
+  uint64_t in_flight = 0;
+
+  // Folds another device in: rates add up, await is IOPS-weighted and
+  // util_percent keeps the busiest device.
+  void accumulate(const DiskIoStats &other);
 };
 
-struct HdIoStats {
+struct HdIoStats : public DiskIoStats {
   std::string device_name;
-  uint64_t read_bytes_per_sec = 0;
-  uint64_t write_bytes_per_sec = 0;
+  // Number of devices folded into this entry (top-K "other" bucket)
+  uint32_t aggregated_devices = 0;
+
+  // DiskIoStats::accumulate, also counting the devices folded in
+  void accumulate(const HdIoStats &other);
 };
 
+/**
+ * @brief Parses the counter columns of a /proc/diskstats line (everything
+ * after the device name). /sys/class/block/<dev>/stat uses the same layout.
+ */
+void parse_disk_counters(const char *text, DiskIoSnapshot &snap);
+
+DiskIoStats calculate_disk_io(const DiskIoSnapshot &prev,
+                              const DiskIoSnapshot &curr,
+                              double time_delta_seconds);
+
 struct DiskUsage {
   uint64_t used_bytes = 0;
   uint64_t size_bytes = 0;
+  uint64_t inodes_used = 0;
+  uint64_t inodes_total = 0;
+  // The last statvfs() did not return in time; values are from before
+  bool stale = false;
 };
+
+/**
+ * @brief statvfs() of a local mount point. May block on dead network or
+ * FUSE mounts, so periodic callers go through UsageRefresher.
+ */
+DiskUsage query_disk_usage(const std::string &mount_point);
 struct DeviceInfo {
   std::string device_path;
   std::string mount_point;
@@ -63,6 +125,13 @@ struct Storage {
   std::vector<std::string> filesystems;
   std::vector<std::string> io_devices;
   Filters filters;
+  // Auto-discovered devices emitted in disk_io; the rest share an "other"
+  // entry (0 = no limit)
+  unsigned top_k = 16;
+  // Filesystem usage is refreshed off the polling thread on this cadence;
+  // a mount that takes longer than usage_timeout_ms is reported stale
+  unsigned usage_interval_ms = 30000;
+  unsigned usage_timeout_ms = 2000;
   Storage();
 
 private:
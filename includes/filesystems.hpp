@@ -2,7 +2,98 @@
 #ifndef FILESYSTEMS_HPP
 #define FILESYSTEMS_HPP
 
+#include <gtest/gtest_prod.h>
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
+#include "diskstat.hpp"
 #include "pcn.hpp"
+#include "proc_file.hpp"
 #include "stream_provider.hpp"
 
+namespace telemetry {
+
+/**
+ * @brief Block device (major:minor) -> mount point, built from
+ * /proc/self/mountinfo. The kernel flags the open mountinfo fd with POLLPRI
+ * whenever the mount table changes, so poll() is a single non-blocking
+ * syscall per tick and the file is only re-parsed after a mount/umount.
+ * btrfs and other filesystems listed under an anonymous 0:NN device are
+ * found by their mount source (the device path after the fstype) instead.
+ */
+class MountTable {
+public:
+  bool open();
+  /**
+   * @brief Reloads the table if the kernel reported a change.
+   * @return true if the table was reloaded.
+   */
+  bool poll();
+  void load(const std::string &mountinfo);
+  // device_path should be canonical; it is only used when device misses
+  std::string find(dev_t device, const std::string &device_path = "") const;
+
+private:
+  struct MountEntry {
+    std::string mount_point;
+    bool is_root = false; // Mounts the filesystem root, not a bind subtree
+  };
+
+  ProcFile file;
+  std::string buffer;
+  std::unordered_map<dev_t, MountEntry> mounts;
+  std::unordered_map<std::string, MountEntry> sources; // Canonical /dev paths
+};
+
+/**
+ * @brief Refreshes filesystem usage on a helper thread, on its own cadence.
+ * Each statvfs() runs in a short-lived detached thread so the helper can
+ * give up after the timeout: a hung NFS/FUSE mount is reported stale with
+ * its last known values, and no new probe is started for it until the stuck
+ * one returns.
+ */
+class UsageRefresher {
+public:
+  UsageRefresher() = default;
+  ~UsageRefresher();
+
+  UsageRefresher(const UsageRefresher &) = delete;
+  UsageRefresher &operator=(const UsageRefresher &) = delete;
+
+  void start(std::chrono::milliseconds interval,
+             std::chrono::milliseconds timeout);
+  void stop();
+  bool is_running() const { return thread.joinable(); }
+
+  // Replaces the watched set and triggers an immediate refresh
+  void set_mount_points(const std::vector<std::string> &mount_points);
+  // Latest result for mount_point; false if none is available yet
+  bool get(const std::string &mount_point, DiskUsage &usage) const;
+
+private:
+  void run();
+  DiskUsage probe(const std::string &mount_point);
+  void prune_pending(const std::vector<std::string> &mounts);
+
+  std::chrono::milliseconds interval{30000};
+  std::chrono::milliseconds timeout{2000};
+
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+  bool mounts_changed = false;
+  std::vector<std::string> mount_points;
+  std::map<std::string, DiskUsage> results;
+
+  // Probes still in flight, only touched by the helper thread
+  std::map<std::string, std::future<DiskUsage>> pending;
+  std::thread thread;
+
+  FRIEND_TEST(UsageRefresherTest, PrunesProbesOfUnwatchedMounts);
+};
+
+}; // namespace telemetry
 #endif
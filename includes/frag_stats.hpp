@@ -1,32 +1,65 @@
 // includes/frag_stats.hpp
 #ifndef FRAG_STATS_HPP
 #define FRAG_STATS_HPP
-#include "polling.hpp"
+
+#include <array>
+#include <string_view>
+
+#include "pcn.hpp"
 
 namespace telemetry {
 
-class SystemMetrics;
-class DataStreamProvider;
-class MetricsContext;
+// Upper bound on buddy allocator orders (11 on x86, up to 14 elsewhere)
+constexpr size_t BUDDY_MAX_ORDERS = 16;
 
-struct FragStats {
-  int node_id;
-  std::string zone;
-  std::vector<int> free_chunks_by_order; // Order 0 (4k) to Order 10 (4M)
+using BuddyOrders = std::array<unsigned long long, BUDDY_MAX_ORDERS>;
+
+/**
+ * @brief /proc/buddyinfo as a node x zone x order matrix of free blocks.
+ * Parsing into an existing matrix reuses its rows; a zone name is only
+ * rewritten when the layout changes.
+ */
+struct BuddyMatrix {
+  struct Zone {
+    size_t node = 0;
+    std::string name; // "DMA", "DMA32", "Normal", ...
+  };
+  std::vector<Zone> zones;
+  std::vector<BuddyOrders> free_blocks; // One row per zone
+  size_t orders = 0;                    // Columns the kernel reported
 };
 
-class MemoryFragmentationTask : public IPollingTask {
-public:
-  MemoryFragmentationTask(DataStreamProvider &p, SystemMetrics &m,
-                          MetricsContext &ctx);
+bool parse_buddyinfo(std::string_view text, BuddyMatrix &matrix);
 
-  void configure() override;
-  void take_initial_snapshot() override;
+// Free pages of one migrate type ("Movable", "Unmovable", ...)
+struct MigrateTypeFree {
+  std::string type;
+  unsigned long long free_pages = 0;
+};
 
-  void take_new_snapshot() override;
-  void calculate() override;
-  void commit() override;
+struct ZoneFragmentation {
+  size_t node = 0;
+  std::string zone;
+  // 0 when the free memory sits in the largest blocks, 1 when it is all
+  // single pages
+  double fragmentation_index = 0.0;
+  unsigned long long free_pages = 0;
+  std::vector<unsigned long long> free_pages_by_order;
+  // Only filled when /proc/pagetypeinfo is enabled (and readable)
+  std::vector<MigrateTypeFree> migrate_types;
 };
 
+// Weights each block's pages by its order: 0 when every free page sits in
+// the largest order, 1 when all of them are single pages
+double fragmentation_index(const unsigned long long *free_blocks,
+                           size_t orders);
+
+/**
+ * @brief Sums the "Free pages count per migrate type" section of
+ * /proc/pagetypeinfo into the migrate_types of the matching zones.
+ */
+void parse_pagetypeinfo(std::string_view text,
+                        std::vector<ZoneFragmentation> &zones);
+
 }; // namespace telemetry
 #endif
@@ -1 +1,61 @@
 // hwmonitor.hpp
+#ifndef HWMONITOR_HPP
+#define HWMONITOR_HPP
+
+#include "netlink.hpp"
+#include "pcn.hpp"
+#include "proc_file.hpp"
+
+namespace telemetry {
+
+enum class SensorKind { Temperature, Fan, Voltage, Power, Current };
+
+/**
+ * @brief One hwmon channel, already scaled to °C, RPM, V, W or A.
+ */
+struct SensorReading {
+  std::string chip;  // hwmon "name", e.g. coretemp, nvme, amdgpu
+  std::string label; // *_label contents, or the channel id ("temp3")
+  SensorKind kind = SensorKind::Temperature;
+  double value = 0.0;
+};
+
+const char *sensor_kind_name(SensorKind kind);
+
+/**
+ * @brief Cached view of /sys/class/hwmon.
+ * Discovery walks the hwmon directories once and keeps every *_input file
+ * open; each read is then one pread() per channel. A NETLINK_KOBJECT_UEVENT
+ * socket reports hwmon devices being added or removed, which triggers a new
+ * discovery on the next refresh().
+ */
+class HwmonSensors {
+public:
+  // Discovers on first use and again after a hwmon hotplug event
+  void refresh();
+  void read(std::vector<SensorReading> &out);
+  // CPU package temperature, or the first CPU sensor; -1.0 if none
+  double read_cpu_temperature();
+
+  void discover(const std::string &hwmon_base = "/sys/class/hwmon");
+
+private:
+  struct Channel {
+    SensorReading reading;
+    ProcFile input;
+    double scale = 1.0;
+  };
+
+  bool hotplug_pending();
+  bool read_channel(const Channel &channel, double &value);
+
+  std::vector<Channel> channels;
+  int cpu_channel = -1;
+  bool discovered = false;
+  NetlinkSocket uevents;
+  std::vector<char> uevent_buffer;
+  std::string buffer;
+};
+
+}; // namespace telemetry
+#endif
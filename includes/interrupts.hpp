@@ -0,0 +1,61 @@
+// interrupts.hpp
+#ifndef INTERRUPTS_HPP
+#define INTERRUPTS_HPP
+
+#include <string_view>
+
+#include "pcn.hpp"
+
+namespace telemetry {
+
+/**
+ * @brief Counters from /proc/interrupts or /proc/softirqs: one row per IRQ
+ * line (or softirq type), one column per online CPU, stored row-major.
+ * Parsing into an existing matrix reuses its storage; a label is only
+ * rewritten when the kernel's row layout changes.
+ */
+struct CounterMatrix {
+  std::vector<size_t> cpus;              // CPU number of each column
+  std::vector<std::string> names;        // "24", "LOC", "NET_RX"
+  std::vector<std::string> descriptions; // "IR-PCI-MSI 524288-edge eth0"
+  std::vector<unsigned long long> counts;
+
+  size_t rows() const { return names.size(); }
+  size_t columns() const { return cpus.size(); }
+  // Same CPUs and rows, so the counts can be subtracted element-wise
+  bool same_layout(const CounterMatrix &other) const;
+  void clear();
+};
+
+bool parse_counter_matrix(std::string_view text, CounterMatrix &matrix);
+
+/**
+ * @brief Per-second rates for count contiguous counters.
+ * Counters that went backwards (CPU hotplug) report zero, as do deltas of
+ * 2^31 or more in one tick.
+ */
+void compute_counter_rates(const unsigned long long *prev,
+                           const unsigned long long *curr, size_t count,
+                           double seconds, float *out);
+
+struct InterruptRate {
+  std::string name;
+  std::string description;
+  double per_sec = 0.0;
+  // Indexed like interrupt_cpus (or softirq_cpus, which lists every
+  // possible CPU rather than the online ones)
+  std::vector<float> per_cpu;
+};
+
+struct Interrupts {
+  // Emit only the K busiest IRQ lines plus an "other" row (0 = all)
+  unsigned top_k = 10;
+};
+
+struct LuaInterrupts : public Interrupts {
+  std::string serialize(unsigned indentation_level = 0) const;
+  void deserialize(sol::table interrupts);
+};
+
+}; // namespace telemetry
+#endif
@@ -11,11 +11,23 @@ struct Time;
 struct DiskUsage;
 struct DiskIoStats;
 struct HdIoStats;
+struct SensorReading;
+struct CgroupStats;
 struct CoreStats;
+struct IdleStateResidency;
+struct CpuGroupStats;
+struct InterruptRate;
 struct NetworkInterfaceStats;
 struct MemInfo;
+struct NumaNodeMemory;
+struct MemInfoFields;
 struct ProcessInfo;
 struct SystemStability;
+struct PsiLine;
+struct VmstatRate;
+struct MigrateTypeFree;
+struct ZoneFragmentation;
+class ProcessListView;
 struct Time;
 
 class SystemMetrics;
@@ -43,10 +55,18 @@ void from_json(const json &j, DeviceInfo &s);
 
 void to_json(json &j, const HdIoStats &s);
 void from_json(const json &j, HdIoStats &s);
+void to_json(json &j, const SensorReading &s);
+void from_json(const json &j, SensorReading &s);
 
 // CPU
+void to_json(json &j, const IdleStateResidency &s);
+void from_json(const json &j, IdleStateResidency &s);
 void to_json(json &j, const CoreStats &s);
 void from_json(const json &j, CoreStats &s);
+void to_json(json &j, const CpuGroupStats &s);
+void from_json(const json &j, CpuGroupStats &s);
+void to_json(json &j, const InterruptRate &s);
+void from_json(const json &j, InterruptRate &s);
 
 // Network
 void to_json(json &j, const NetworkInterfaceStats &s);
@@ -55,10 +75,15 @@ void from_json(const json &j, NetworkInterfaceStats &s);
 // Memory
 void to_json(json &j, const MemInfo &s);
 void from_json(const json &j, MemInfo &s);
+void to_json(json &j, const MemInfoFields &s);
+void from_json(const json &j, MemInfoFields &s);
+void to_json(json &j, const NumaNodeMemory &s);
+void from_json(const json &j, NumaNodeMemory &s);
 
 // ProcessInfo
 void to_json(json &j, const ProcessInfo &p);
 void from_json(const json &j, ProcessInfo &p);
+void to_json(json &j, const ProcessListView &v);
 
 // Uptime
 void to_json(json &j, const Time &t);
@@ -70,7 +95,21 @@ void from_json(const json &j, SystemMetrics &s);
 void from_json(const json &j, SystemStability &s);
 
 // Stability & PSI Metrics
+void to_json(json &j, const PsiLine &s);
+void from_json(const json &j, PsiLine &s);
 void to_json(json &j, const SystemStability &s);
 void from_json(const json &j, SystemStability &s);
+void to_json(json &j, const VmstatRate &s);
+void from_json(const json &j, VmstatRate &s);
+
+// Cgroups
+void to_json(json &j, const CgroupStats &s);
+void from_json(const json &j, CgroupStats &s);
+
+// Memory fragmentation
+void to_json(json &j, const MigrateTypeFree &s);
+void from_json(const json &j, MigrateTypeFree &s);
+void to_json(json &j, const ZoneFragmentation &s);
+void from_json(const json &j, ZoneFragmentation &s);
 }; // namespace telemetry
 #endif
@@ -0,0 +1,77 @@
+// lru_cache.hpp
+#ifndef LRU_CACHE_HPP
+#define LRU_CACHE_HPP
+
+#include <list>
+#include <unordered_map>
+
+#include "pcn.hpp"
+
+namespace telemetry {
+
+/**
+ * @brief Fixed-capacity map that evicts the least recently used entry.
+ * Entries live in a list ordered by use; the hash map points into it.
+ * Once the cache is full, put() recycles the evicted list node, so a
+ * steady stream of new keys does not allocate list nodes.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+  explicit LruCache(size_t capacity = 1) : limit(capacity ? capacity : 1) {}
+
+  // Marks the entry most recently used; nullptr when it is not cached
+  Value *get(const Key &key) {
+    auto it = index.find(key);
+    if (it == index.end())
+      return nullptr;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->second;
+  }
+
+  Value &put(const Key &key, Value value) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+      it->second->second = std::move(value);
+      entries.splice(entries.begin(), entries, it->second);
+      return it->second->second;
+    }
+    if (entries.size() < limit) {
+      entries.emplace_front(key, std::move(value));
+    } else {
+      auto oldest = std::prev(entries.end());
+      index.erase(oldest->first);
+      oldest->first = key;
+      oldest->second = std::move(value);
+      entries.splice(entries.begin(), entries, oldest);
+    }
+    index.emplace(key, entries.begin());
+    return entries.front().second;
+  }
+
+  bool contains(const Key &key) const { return index.count(key) != 0; }
+  size_t size() const { return entries.size(); }
+  size_t capacity() const { return limit; }
+
+  void set_capacity(size_t capacity) {
+    limit = capacity ? capacity : 1;
+    while (entries.size() > limit) {
+      index.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+
+  void clear() {
+    index.clear();
+    entries.clear();
+  }
+
+private:
+  using Entry = std::pair<Key, Value>;
+  std::list<Entry> entries; // Most recently used first
+  std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+  size_t limit;
+};
+
+}; // namespace telemetry
+#endif
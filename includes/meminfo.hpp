@@ -2,6 +2,8 @@
 #ifndef MEMINFO_HPP
 #define MEMINFO_HPP
 
+#include <string_view>
+
 #include "pcn.hpp"
 
 namespace telemetry {
@@ -11,8 +13,157 @@ struct MemInfo {
   long total_kb;
   int percent;
 };
+
+// Every /proc/meminfo label we know about. Values are in kB, except the
+// HugePages_ entries, which are page counts.
+#define MEMINFO_FIELDS(X)                                                      \
+  X(MemTotal, "MemTotal")                                                      \
+  X(MemFree, "MemFree")                                                        \
+  X(MemAvailable, "MemAvailable")                                              \
+  X(Buffers, "Buffers")                                                        \
+  X(Cached, "Cached")                                                          \
+  X(SwapCached, "SwapCached")                                                  \
+  X(Active, "Active")                                                          \
+  X(Inactive, "Inactive")                                                      \
+  X(ActiveAnon, "Active(anon)")                                                \
+  X(InactiveAnon, "Inactive(anon)")                                            \
+  X(ActiveFile, "Active(file)")                                                \
+  X(InactiveFile, "Inactive(file)")                                            \
+  X(Unevictable, "Unevictable")                                                \
+  X(Mlocked, "Mlocked")                                                        \
+  X(SwapTotal, "SwapTotal")                                                    \
+  X(SwapFree, "SwapFree")                                                      \
+  X(Zswap, "Zswap")                                                            \
+  X(Zswapped, "Zswapped")                                                      \
+  X(Dirty, "Dirty")                                                            \
+  X(Writeback, "Writeback")                                                    \
+  X(AnonPages, "AnonPages")                                                    \
+  X(Mapped, "Mapped")                                                          \
+  X(Shmem, "Shmem")                                                            \
+  X(KReclaimable, "KReclaimable")                                              \
+  X(Slab, "Slab")                                                              \
+  X(SReclaimable, "SReclaimable")                                              \
+  X(SUnreclaim, "SUnreclaim")                                                  \
+  X(KernelStack, "KernelStack")                                                \
+  X(PageTables, "PageTables")                                                  \
+  X(SecPageTables, "SecPageTables")                                            \
+  X(NfsUnstable, "NFS_Unstable")                                               \
+  X(Bounce, "Bounce")                                                          \
+  X(WritebackTmp, "WritebackTmp")                                              \
+  X(CommitLimit, "CommitLimit")                                                \
+  X(CommittedAs, "Committed_AS")                                               \
+  X(VmallocTotal, "VmallocTotal")                                              \
+  X(VmallocUsed, "VmallocUsed")                                                \
+  X(VmallocChunk, "VmallocChunk")                                              \
+  X(Percpu, "Percpu")                                                          \
+  X(HardwareCorrupted, "HardwareCorrupted")                                    \
+  X(AnonHugePages, "AnonHugePages")                                            \
+  X(ShmemHugePages, "ShmemHugePages")                                          \
+  X(ShmemPmdMapped, "ShmemPmdMapped")                                          \
+  X(FileHugePages, "FileHugePages")                                            \
+  X(FilePmdMapped, "FilePmdMapped")                                            \
+  X(CmaTotal, "CmaTotal")                                                      \
+  X(CmaFree, "CmaFree")                                                        \
+  X(Unaccepted, "Unaccepted")                                                  \
+  X(Balloon, "Balloon")                                                        \
+  X(HugePagesTotal, "HugePages_Total")                                         \
+  X(HugePagesFree, "HugePages_Free")                                           \
+  X(HugePagesRsvd, "HugePages_Rsvd")                                           \
+  X(HugePagesSurp, "HugePages_Surp")                                           \
+  X(Hugepagesize, "Hugepagesize")                                              \
+  X(Hugetlb, "Hugetlb")                                                        \
+  X(DirectMap4k, "DirectMap4k")                                                \
+  X(DirectMap2M, "DirectMap2M")                                                \
+  X(DirectMap1G, "DirectMap1G")
+
+enum class MemInfoField : uint8_t {
+#define MEMINFO_ENUM(id, label) id,
+  MEMINFO_FIELDS(MEMINFO_ENUM)
+#undef MEMINFO_ENUM
+  Count
+};
+
+constexpr size_t MEMINFO_FIELD_COUNT =
+    static_cast<size_t>(MemInfoField::Count);
+
+/**
+ * @brief All of /proc/meminfo in a fixed array indexed by MemInfoField.
+ * Fields the running kernel does not report stay 0.
+ */
+struct MemInfoFields {
+  std::array<unsigned long long, MEMINFO_FIELD_COUNT> values{};
+
+  unsigned long long operator[](MemInfoField field) const {
+    return values[static_cast<size_t>(field)];
+  }
+};
+
+const char *meminfo_field_name(MemInfoField field);
+bool meminfo_field_from_name(std::string_view label, MemInfoField &field);
+
+/**
+ * @brief Parses /proc/meminfo text into fields.
+ * Labels are looked up through a compile-time perfect hash; labels this
+ * build does not know are skipped.
+ */
+void parse_meminfo(std::string_view text, MemInfoFields &fields);
+// Reads the whole stream into buffer (kept between calls) and parses it
+void read_meminfo(std::istream &input_stream, std::string &buffer,
+                  MemInfoFields &fields);
+// Derives the RAM and swap summaries from the parsed fields
+void summarize_meminfo(const MemInfoFields &fields, MemInfo &meminfo,
+                       MemInfo &swapinfo);
 void get_mem_usage(std::istream &input_stream, MemInfo &meminfo,
                    MemInfo &swapinfo);
 
+/**
+ * @brief Maps configured field names to fields, in order.
+ * "*" selects every field; unknown names are logged and skipped.
+ */
+std::vector<MemInfoField>
+select_meminfo_fields(const std::vector<std::string> &names);
+
+struct Memory {
+  // meminfo labels to serialize under "meminfo_fields"
+  std::vector<std::string> fields = {
+      "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached",
+      "Dirty", "Writeback", "Slab", "Shmem", "AnonHugePages",
+      "HugePages_Total", "HugePages_Free"};
+  // Free pages per migrate type; /proc/pagetypeinfo is root only
+  bool enable_pagetypeinfo = false;
+  // compact_* counters from /proc/vmstat next to the zone fragmentation
+  bool enable_compaction = true;
+};
+
+struct LuaMemory : public Memory {
+  std::string serialize(unsigned indentation_level = 0) const;
+  void deserialize(sol::table memory);
+};
+
+// Raw counters from nodeN/meminfo (kB) and nodeN/numastat (pages)
+struct NumaNodeSnapshot {
+  long total_kb = 0;
+  long free_kb = 0;
+  long file_kb = 0; // FilePages: page cache and other file-backed memory
+  unsigned long long numa_miss = 0;
+  unsigned long long numa_foreign = 0;
+};
+
+struct NumaNodeMemory {
+  size_t node = 0;
+  long total_kb = 0;
+  long used_kb = 0;
+  long free_kb = 0;
+  long file_kb = 0;
+  int percent = 0;
+  // Pages allocated on this node although another node was preferred
+  double numa_miss_per_sec = 0.0;
+  // Pages meant for this node that ended up on another one
+  double numa_foreign_per_sec = 0.0;
+};
+
+void parse_node_meminfo(const std::string &text, NumaNodeSnapshot &snapshot);
+void parse_numastat(const std::string &text, NumaNodeSnapshot &snapshot);
+
 }; // namespace telemetry
 #endif
@@ -2,10 +2,15 @@
 #define METRIC_SETTINGS_HPP
 
 #include "batteryinfo.hpp"
+#include "cgroups.hpp"
 #include "data_ssh.hpp"
 #include "diskstat.hpp"
+#include "interrupts.hpp"
+#include "meminfo.hpp"
+#include "networkstats.hpp"
 #include "processinfo.hpp"
 #include "provider.hpp"
+#include "vmstat.hpp"
 #include "window_settings.hpp"
 
 #include <algorithm>
@@ -24,11 +29,16 @@ struct Features {
   bool enable_sysinfo = true;
   bool enable_memory = true;
   bool enable_cpuinfo = true;
+  bool enable_cpu_idle = true;
+  bool enable_schedstat = true;
   bool enable_cpu_temp = true;
+  bool enable_sensors = true;
   bool enable_uptime = true;
   bool enable_load_and_process_stats = true;
   bool enable_diskstat = true;
   bool enable_network_stats = true;
+  bool enable_interrupts = true;
+  bool enable_cgroups = true;
   bool enable_stability_info = true;
   bool enable_battery_info = true;
   Processes processes;
@@ -40,6 +50,11 @@ struct MetricSettings {
   Features features;
   Batteries batteries;
   Storage storage;
+  Network network;
+  Memory memory;
+  Vmstat vmstat;
+  Interrupts interrupts;
+  Cgroups cgroups;
 
   std::string stream_provider;
   ProviderSettings provider_settings;
@@ -3,15 +3,21 @@
 #define METRICS_HPP
 
 #include "batteryinfo.hpp"
+#include "cgroups.hpp"
 #include "corestat.hpp"
 #include "diskstat.hpp"
+#include "frag_stats.hpp"
+#include "hwmonitor.hpp"
+#include "interrupts.hpp"
 #include "meminfo.hpp"
 #include "networkstats.hpp"
 #include "pcn.hpp"
+#include "processinfo.hpp"
 #include "provider.hpp"
 #include "stream_provider.hpp"
 #include "system_stability.hpp"
 #include "uptime.hpp"
+#include "vmstat.hpp"
 
 namespace telemetry {
 
@@ -37,15 +43,31 @@ public:
   std::unique_ptr<DataStreamProvider> provider;
   PollingTaskList polling_tasks;
   std::vector<DeviceInfo> disks;
-  std::map<std::string, HdIoStats> disk_io;
+  std::vector<HdIoStats> disk_io;
   std::vector<CoreStats> cores;
+  std::vector<CpuGroupStats> cpu_packages;
+  std::vector<CpuGroupStats> cpu_physical_cores;
+  std::vector<CpuGroupStats> numa_nodes;
   double cpu_frequency_ghz;
   double cpu_temp_c;
+  std::vector<SensorReading> sensors;
   MemInfo meminfo;
   MemInfo swapinfo;
+  MemInfoFields meminfo_fields;
+  std::vector<NumaNodeMemory> numa_memory;
   Time uptime;
   std::vector<BatteryStatus> battery_info;
   SystemStability stability;
+  std::vector<VmstatRate> vmstat;
+  std::vector<ZoneFragmentation> memory_zones;
+  std::vector<VmstatRate> compaction;
+  std::vector<size_t> interrupt_cpus;
+  std::vector<InterruptRate> interrupts;
+  std::vector<size_t> softirq_cpus;
+  std::vector<InterruptRate> softirqs;
+  std::vector<CgroupStats> top_cgroups_cpu;
+  std::vector<CgroupStats> top_cgroups_mem;
+  std::vector<CgroupStats> top_cgroups_io;
 
   double load_avg_1m = 0.0;
   double load_avg_5m = 0.0;
@@ -59,14 +81,23 @@ public:
   std::string machine_type;
 
   std::vector<NetworkInterfaceStats> network_interfaces;
-  std::vector<ProcessInfo> top_processes_avg_mem;
-  std::vector<ProcessInfo> top_processes_avg_cpu;
-  std::vector<ProcessInfo> top_processes_real_mem;
-  std::vector<ProcessInfo> top_processes_real_cpu;
+  // Records for every process that made at least one top-N list. The lists
+  // themselves only hold indices into this array.
+  std::vector<ProcessInfo> process_records;
+  // Cgroup of each record (same index); empty when not collected
+  std::vector<ProcessCgroup> process_cgroups;
+  ProcessIndexList top_processes_avg_mem;
+  ProcessIndexList top_processes_avg_cpu;
+  ProcessIndexList top_processes_real_mem;
+  ProcessIndexList top_processes_real_cpu;
 
   SystemMetrics();
   SystemMetrics(MetricsContext &context);
 
+  ProcessListView processes(const ProcessIndexList &list) const {
+    return {process_records, list, &process_cgroups};
+  }
+
   int read_data();
   void complete();
   int get_metrics_from_provider();
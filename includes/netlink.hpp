@@ -0,0 +1,58 @@
+// netlink.hpp
+#ifndef NETLINK_HPP
+#define NETLINK_HPP
+
+#include <sys/types.h>
+
+#include "pcn.hpp"
+
+namespace telemetry {
+
+/**
+ * @brief Minimal RAII wrapper around an AF_NETLINK socket.
+ * Used both for kernel notifications (address changes, uevents) and for
+ * request/response dumps (link statistics).
+ */
+class NetlinkSocket {
+public:
+  NetlinkSocket() = default;
+  ~NetlinkSocket();
+
+  NetlinkSocket(const NetlinkSocket &) = delete;
+  NetlinkSocket &operator=(const NetlinkSocket &) = delete;
+  NetlinkSocket(NetlinkSocket &&other) noexcept;
+  NetlinkSocket &operator=(NetlinkSocket &&other) noexcept;
+
+  /**
+   * @brief Opens and binds the socket.
+   * @param protocol Netlink family, e.g. NETLINK_ROUTE.
+   * @param groups Multicast group mask to subscribe to (0 for none).
+   * @param nonblocking Whether receive() should return immediately when
+   * nothing is queued.
+   */
+  bool open(int protocol, uint32_t groups = 0, bool nonblocking = true);
+  void close();
+  // Bounds how long a blocking receive() may wait for the kernel
+  bool set_receive_timeout(int milliseconds);
+  // Grows the kernel receive queue so large replies are not dropped
+  bool set_receive_buffer(int bytes);
+  bool is_open() const { return fd >= 0; }
+  int get_fd() const { return fd; }
+
+  uint32_t next_sequence() { return ++sequence; }
+  bool send(const void *message, size_t length);
+
+  /**
+   * @brief Reads one datagram into buffer.
+   * @return Bytes read, 0 if nothing is pending on a non-blocking socket,
+   * or -1 on error.
+   */
+  ssize_t receive(std::vector<char> &buffer);
+
+private:
+  int fd = -1;
+  uint32_t sequence = 0;
+};
+
+}; // namespace telemetry
+#endif
@@ -2,28 +2,88 @@
 #ifndef NETWORKSTATS_HPP
 #define NETWORKSTATS_HPP
 
+#include <gtest/gtest_prod.h>
+#include <linux/netlink.h>
+
+#include "netlink.hpp"
 #include "pcn.hpp"
+#include "proc_file.hpp"
 
 namespace telemetry {
 
+/**
+ * @brief Raw link counters, in /proc/net/dev column order.
+ */
 struct NetworkSnapshot {
 
   std::string interface_name;
   unsigned long long rx_bytes = 0;
   unsigned long long rx_packets = 0;
+  unsigned long long rx_errs = 0;
+  unsigned long long rx_drop = 0;
+  unsigned long long rx_fifo = 0;
+  unsigned long long rx_frame = 0;
+  unsigned long long rx_compressed = 0;
+  unsigned long long rx_multicast = 0;
   unsigned long long tx_bytes = 0;
   unsigned long long tx_packets = 0;
+  unsigned long long tx_errs = 0;
+  unsigned long long tx_drop = 0;
+  unsigned long long tx_fifo = 0;
+  unsigned long long tx_colls = 0;
+  unsigned long long tx_carrier = 0;
+  unsigned long long tx_compressed = 0;
 };
 
+using NetworkSnapshotMap = std::map<std::string, NetworkSnapshot>;
+
 /**
  * @brief Holds the calculated transfer rates for one network interface.
  */
 struct NetworkInterfaceStats {
   std::string interface_name;
   std::string ip_address;
+  std::vector<std::string> ipv6_addresses;
   double rx_bytes_per_sec = 0.0;
   double tx_bytes_per_sec = 0.0;
-  // Add packet rates if needed
+  double rx_packets_per_sec = 0.0;
+  double tx_packets_per_sec = 0.0;
+  double rx_errors_per_sec = 0.0;
+  double tx_errors_per_sec = 0.0;
+  double rx_dropped_per_sec = 0.0;
+  double tx_dropped_per_sec = 0.0;
+  double rx_fifo_per_sec = 0.0;
+  double tx_fifo_per_sec = 0.0;
+  double rx_frame_per_sec = 0.0;
+  double rx_compressed_per_sec = 0.0;
+  double tx_compressed_per_sec = 0.0;
+  double multicast_per_sec = 0.0;
+  double collisions_per_sec = 0.0;
+  double carrier_per_sec = 0.0;
+  // Number of interfaces folded into this entry (top-K "other" bucket)
+  uint32_t aggregated_interfaces = 0;
+
+  void accumulate(const NetworkInterfaceStats &other);
+};
+
+/**
+ * @brief Interface allowlist. Entries containing glob metacharacters
+ * ("eth*", "veth[0-9]*") are matched with fnmatch(), everything else is an
+ * exact name. An empty filter matches every interface.
+ */
+class InterfaceFilter {
+public:
+  InterfaceFilter() = default;
+  explicit InterfaceFilter(const std::set<std::string> &entries);
+
+  bool empty() const { return names.empty() && patterns.empty(); }
+  bool has_patterns() const { return !patterns.empty(); }
+  const std::set<std::string> &exact_names() const { return names; }
+  bool matches(const char *interface_name) const;
+
+private:
+  std::set<std::string> names;
+  std::vector<std::string> patterns;
 };
 /**
  * @brief Reads network stats, calculates rates, and populates metrics.
@@ -35,12 +95,88 @@ struct NetworkInterfaceStats {
  * @param initialized Reference to the boolean tracking initialization.
  */
 
-std::string get_ip_address(const std::string &interface_name);
+struct InterfaceAddresses {
+  std::string ipv4; // First IPv4 address, empty if none
+  std::vector<std::string> ipv6;
+};
+
+/**
+ * @brief Interface name -> address map, filled with a single getifaddrs()
+ * call and refreshed only when rtnetlink reports an address change.
+ * The notification socket is non-blocking and drained once per tick by
+ * poll(). If the socket cannot be opened (or notifications overflow) the
+ * cache falls back to reloading on the next poll.
+ */
+class InterfaceAddressCache {
+public:
+  bool open();
+  void poll();
+  void reload();
+  const InterfaceAddresses *find(const std::string &interface_name) const;
+
+private:
+  bool drain_notifications();
+
+  NetlinkSocket socket;
+  std::vector<char> buffer;
+  std::map<std::string, InterfaceAddresses> addresses;
+  bool dirty = true;
+
+  FRIEND_TEST(InterfaceAddressCacheTest, DrainsAddressNotifications);
+  FRIEND_TEST(InterfaceAddressCacheTest, ReloadsOnlyAfterNotifications);
+  FRIEND_TEST(InterfaceAddressCacheTest, ReloadsEveryPollWithoutSocket);
+};
+
+/**
+ * @brief Reads link counters as binary rtnl_link_stats64 records with
+ * RTM_GETLINK instead of formatting and parsing /proc/net/dev.
+ * A filter made only of exact names is sent as one request per interface,
+ * in batches small enough for their replies to fit the receive buffer, so
+ * the kernel only serializes those links; otherwise the whole table is
+ * dumped and filtered while parsing. read() returns false whenever the
+ * answer may be incomplete so the caller can fall back to /proc/net/dev.
+ */
+class LinkStatsReader {
+public:
+  // Sequence range of one send() and the replies still expected for it
+  struct ReplyBatch {
+    uint32_t first_seq = 0;
+    uint32_t last_seq = 0;
+    size_t pending = 0; // A dump waits for NLMSG_DONE instead
+    bool dump = false;
+  };
+
+  bool open();
+  bool is_open() const { return socket.is_open(); }
+  bool read(const InterfaceFilter &filter, NetworkSnapshotMap &out);
+
+  /**
+   * @brief Consumes one datagram of RTM_GETLINK replies.
+   * Replies outside the batch's sequence range are stale and skipped.
+   * @return false if the kernel rejected a dump.
+   */
+  static bool parse_replies(const char *data, size_t length,
+                            ReplyBatch &batch, const InterfaceFilter &filter,
+                            NetworkSnapshotMap &out);
+
+private:
+  void append_request(const std::string *name, uint16_t flags);
+  bool send_batch(ReplyBatch &batch, const InterfaceFilter &filter,
+                  NetworkSnapshotMap &out);
+  static void parse_link(const nlmsghdr *nh, const InterfaceFilter &filter,
+                         NetworkSnapshotMap &out);
+
+  NetlinkSocket socket;
+  std::vector<char> request;
+  std::vector<char> buffer;
+};
 
 struct Network {
   std::vector<std::string> interfaces; // fixme, need a default
   std::string ping_target = "8.8.8.8";
   bool enable_ping = false;
+  // Emit only the K busiest interfaces plus an "other" bucket (0 = all)
+  unsigned top_k = 0;
 
   Network();
   ~Network() = default;
@@ -4,9 +4,14 @@
 
 #include <gtest/gtest_prod.h>
 
+#include "cgroups.hpp"
+#include "cpuinfo.hpp"
 #include "diskstat.hpp"
+#include "filesystems.hpp"
+#include "lru_cache.hpp"
 #include "metrics.hpp"
 #include "networkstats.hpp"
+#include "proc_file.hpp"
 #include "processinfo.hpp"
 #include "provider.hpp"
 
@@ -21,8 +26,6 @@ struct DeviceInfo;
 
 class SystemMetrics;
 
-using CpuSnapshotList = std::vector<CpuSnapshot>;
-using NetworkSnapshotMap = std::map<std::string, NetworkSnapshot>;
 using DiskIoSnapshotMap = std::map<std::string, DiskIoSnapshot>;
 using DevicePaths = std::vector<std::string>;
 using DiskStatConfig = std::set<DiskStatSettings>;
@@ -95,12 +98,24 @@ class CpuPollingTask : public IPollingTask {
   FRIEND_TEST(CpuCoverageTest, MismatchedSnapshotSizes);
   FRIEND_TEST(CpuCoverageTest, CounterWrapHandling);
   FRIEND_TEST(CpuCoverageTest, AggregateAccuracy);
+  FRIEND_TEST(CpuCoverageTest, IrqSoftirqAndStealReported);
 
   FRIEND_TEST(CpuCoverageTest, AggregateIsZeroIndex);
+  FRIEND_TEST(CpuTopologyTest, GroupsSumDeltasBeforeDividing);
+  FRIEND_TEST(CpuTopologyTest, GroupsFollowCpuNumbersWhenOneIsOffline);
 
 private:
   CpuSnapshotList prev_snapshots;
   CpuSnapshotList current_snapshots;
+  CpuUsageArrays usage;
+  CpuTopology topology;
+  // Per-tick scratch for the topology groups
+  CpuSnapshotList group_prev;
+  CpuSnapshotList group_curr;
+  CpuUsageArrays group_usage;
+
+  void calculate_groups(const std::vector<CpuTopology::Group> &groups,
+                        std::vector<CpuGroupStats> &out);
 
 public:
   CpuPollingTask(DataStreamProvider &, SystemMetrics &, MetricsContext &);
@@ -113,10 +128,138 @@ public:
 };
 using CpuPollingTaskPtr = std::unique_ptr<CpuPollingTask>;
 
+/**
+ * @brief Per-core clock and thermal throttling.
+ * Locally, scaling_cur_freq and the thermal_throttle counters are kept open
+ * per CPU and re-read with pread(). Without cpufreq (VMs, remote hosts) the
+ * clock comes from the per-core "cpu MHz" lines of /proc/cpuinfo instead.
+ * Must run after CpuPollingTask: it annotates metrics.cores in place.
+ */
+class CpuFrequencyPollingTask : public IPollingTask {
+private:
+  struct CpuFiles {
+    size_t cpu = 0;
+    long package = -1; // topology/physical_package_id
+    ProcFile frequency;
+    ProcFile core_throttle;
+    ProcFile package_throttle;
+  };
+  std::vector<CpuFiles> cpus;
+  bool has_cpufreq = false;
+  CpuFrequencySnapshotList prev_snapshots;
+  CpuFrequencySnapshotList current_snapshots;
+  std::string buffer;
+
+  void discover(const std::string &cpu_base = "/sys/devices/system/cpu");
+  CpuFrequencySnapshotList read_snapshot();
+
+  FRIEND_TEST(CpuFrequencyTest, ReadsSysfsFrequencyAndThrottles);
+  FRIEND_TEST(CpuFrequencyTest, AnnotatesCoresWithDeltas);
+  FRIEND_TEST(CpuFrequencyTest, MapsCoresByCpuNumber);
+  FRIEND_TEST(CpuFrequencyTest, FallsBackToCpuinfo);
+
+public:
+  CpuFrequencyPollingTask(DataStreamProvider &, SystemMetrics &,
+                          MetricsContext &);
+  void configure() override {};
+  void take_initial_snapshot() override;
+  void take_new_snapshot() override;
+  void calculate() override;
+  void commit() override;
+};
+using CpuFrequencyPollingTaskPtr = std::unique_ptr<CpuFrequencyPollingTask>;
+
+/**
+ * @brief Per-core C-state residency and wakeup rate from cpuidle/stateN.
+ * The time and usage files of every state stay open and are re-read with
+ * pread(). Local only. Like CpuFrequencyPollingTask it annotates
+ * metrics.cores in place and must run after CpuPollingTask.
+ */
+class CpuIdlePollingTask : public IPollingTask {
+private:
+  struct IdleStateFiles {
+    ProcFile time;
+    ProcFile usage;
+  };
+  struct CpuIdleStates {
+    size_t cpu = 0;
+    size_t first = 0; // Index of state0 in state_files and the snapshots
+    std::vector<std::string> names;
+  };
+  std::vector<CpuIdleStates> cpus;
+  std::vector<IdleStateFiles> state_files;
+  CpuIdleSnapshotList prev_snapshots;
+  CpuIdleSnapshotList current_snapshots;
+  std::string buffer;
+
+  void discover(const std::string &cpu_base = "/sys/devices/system/cpu");
+  CpuIdleSnapshotList read_snapshot();
+
+  FRIEND_TEST(CpuIdleTest, DiscoversStatesInOrder);
+  FRIEND_TEST(CpuIdleTest, ResidencyAndWakeupsFromDeltas);
+  FRIEND_TEST(CpuIdleTest, MatchesCoresByCpuNumber);
+
+public:
+  CpuIdlePollingTask(DataStreamProvider &, SystemMetrics &, MetricsContext &);
+  void configure() override {};
+  void take_initial_snapshot() override;
+  void take_new_snapshot() override;
+  void calculate() override;
+  void commit() override;
+};
+using CpuIdlePollingTaskPtr = std::unique_ptr<CpuIdlePollingTask>;
+
+/**
+ * @brief Run-queue wait and scheduling latency per core from
+ * /proc/schedstat, kept open and re-read with pread(). Local only.
+ * Annotates metrics.cores in place and must run after CpuPollingTask.
+ */
+class SchedstatPollingTask : public IPollingTask {
+private:
+  ProcFile schedstat;
+  SchedstatSnapshotList prev_snapshots;
+  SchedstatSnapshotList current_snapshots;
+  std::string buffer;
+
+  void read_snapshot(SchedstatSnapshotList &rows);
+
+  FRIEND_TEST(SchedstatTest, LatencyFromWaitAndTimesliceDeltas);
+  FRIEND_TEST(SchedstatTest, MatchesCoresByCpuNumber);
+
+public:
+  SchedstatPollingTask(DataStreamProvider &, SystemMetrics &,
+                       MetricsContext &);
+  void configure() override {};
+  void take_initial_snapshot() override;
+  void take_new_snapshot() override;
+  void calculate() override;
+  void commit() override;
+};
+using SchedstatPollingTaskPtr = std::unique_ptr<SchedstatPollingTask>;
+
 class NetworkPollingTask : public IPollingTask {
 private:
   NetworkSnapshotMap prev_snapshot;
   NetworkSnapshotMap current_snapshot;
+  InterfaceAddressCache address_cache;
+  bool resolve_addresses = false;
+  LinkStatsReader link_stats;
+  unsigned link_stats_failures = 0;
+  InterfaceFilter filter;
+  unsigned top_k = 0;
+  // rtnl_link_stats64 is always 64-bit; see read_snapshot() for net/dev
+  CounterWidth counter_width = CounterWidth::Bits64;
+  std::vector<NetworkInterfaceStats> rates;
+
+  NetworkSnapshotMap read_snapshot();
+  void select_top_k();
+
+  FRIEND_TEST(NetworkCounterTest, ParsesFullCounterSet);
+  FRIEND_TEST(NetworkCounterTest, RatesIncludeErrorsAndDrops);
+  FRIEND_TEST(NetworkCounterTest, ThirtyTwoBitWrap);
+  FRIEND_TEST(NetworkCounterTest, SixtyFourBitResetBelowFourGiB);
+  FRIEND_TEST(NetworkCounterTest, FilterAppliedAtParseTime);
+  FRIEND_TEST(NetworkCounterTest, TopKWithOtherBucket);
 
 public:
   NetworkPollingTask(DataStreamProvider &, SystemMetrics &, MetricsContext &);
@@ -143,6 +286,41 @@ private:
   DevicePaths load_device_paths(const std::string &config_file);
   std::set<std::string> allowed_io_devices;
   DiskStatConfig config;
+  // Strict mode with a small allowlist: one open stat file per device.
+  // Missing or failed files are reopened on the next read.
+  std::vector<std::pair<std::string, ProcFile>> stat_files;
+  std::string block_class_dir = "/sys/class/block";
+  std::string stat_buffer;
+  bool context_is_local = false;
+  unsigned top_k = 0;
+  // Config-file devices by block device number and canonical path, for
+  // mount table updates
+  struct MountedDevice {
+    dev_t device;
+    std::string path;
+    DeviceInfo *info;
+  };
+  MountTable mount_table;
+  std::vector<MountedDevice> mounted_devices;
+  // Local config devices that were not block devices yet, re-checked on
+  // every mount table change
+  std::vector<DeviceInfo *> unmapped_devices;
+  UsageRefresher usage_refresher;
+  std::chrono::milliseconds usage_interval;
+  std::chrono::milliseconds usage_timeout;
+  // Remote usage is re-read over SSH on the same cadence, in the poll loop
+  std::chrono::steady_clock::time_point remote_usage_time;
+
+  bool map_device(DeviceInfo *info);
+  void refresh_mount_points();
+  void watch_usage();
+  void refresh_remote_usage();
+
+  void select_top_k();
+
+  void open_stat_files();
+  DiskIoSnapshotMap read_stat_files();
+  DiskIoSnapshotMap read_snapshot();
 
 public:
   DiskPollingTask(DataStreamProvider &, SystemMetrics &, MetricsContext &);
@@ -154,6 +332,10 @@ public:
   void commit() override;
 
   DiskIoSnapshotMap read_data(std::istream &);
+
+  FRIEND_TEST(DiskStatTest, TopKWithOtherBucket);
+  FRIEND_TEST(DiskStatTest, ReopensMissingStatFiles);
+  FRIEND_TEST(DiskStatTest, MapsDevicesThatAppearLater);
 };
 using DiskPollingTaskPtr = std::unique_ptr<DiskPollingTask>;
 class ProcessPollingTask : public IPollingTask {
@@ -163,9 +345,33 @@ private:
   bool only_user_processes = true;
   ProcessSnapshotMap prev_snapshots;
   ProcessSnapshotMap current_snapshots;
-  std::vector<std::function<void(std::vector<ProcessInfo> &)>> output_pipeline;
-  void populate_top_ps(std::vector<ProcessInfo> &source,
-                       std::vector<ProcessInfo> &dest, SortMode mode);
+  // Per-tick scratch buffers, reused to avoid reallocating every tick.
+  std::vector<ProcessInfo> candidates;
+  ProcessIndexList sort_order;
+  std::vector<uint32_t> record_slots;
+  std::vector<std::function<void(const std::vector<ProcessInfo> &)>>
+      output_pipeline;
+  // /proc/<pid>/cgroup is read once per process lifetime, and only for
+  // processes that reach a top-N list
+  bool annotate_cgroups = false;
+  LruCache<ProcessKey, ProcessCgroup, ProcessKeyHash> cgroup_cache;
+  std::string cgroup_buffer;
+  bool collect_smaps = false;
+  std::chrono::milliseconds smaps_interval{5000};
+  unsigned smaps_rss_change_percent = 10;
+  std::vector<uint32_t> smaps_records; // Record of each smaps request
+  std::vector<SmapsRequest> smaps_requests;
+  SmapsRefresher smaps_refresher;
+  void populate_top_ps(const std::vector<ProcessInfo> &source,
+                       ProcessIndexList &dest, SortMode mode);
+  void build_process_records();
+  ProcessKey record_key(const ProcessInfo &record) const;
+  void annotate_process_records();
+  void update_smaps();
+
+  FRIEND_TEST(ProcessIOTest, AnnotatesRecordsThroughCache);
+  FRIEND_TEST(ProcessIOTest, ReadsSmapsForTopMemoryProcesses);
+  FRIEND_TEST(ProcessIOTest, ReadsSmapsForTheAverageMemoryList);
 
 public:
   ProcessPollingTask(DataStreamProvider &, SystemMetrics &, MetricsContext &);
@@ -200,7 +406,203 @@ public:
 };
 using BatteryPollingTaskPtr = std::unique_ptr<BatteryPollingTask>;
 
+/**
+ * @brief Per-node memory from /sys/devices/system/node/nodeN.
+ * meminfo and numastat stay open per node and are re-read with pread();
+ * the numastat counters are turned into rates. Local only.
+ */
+class NumaMemoryPollingTask : public IPollingTask {
+private:
+  struct NodeFiles {
+    size_t node = 0;
+    ProcFile meminfo;
+    ProcFile numastat;
+  };
+  std::vector<NodeFiles> nodes;
+  std::vector<NumaNodeSnapshot> prev_snapshots;
+  std::vector<NumaNodeSnapshot> current_snapshots;
+  std::string buffer;
+
+  void discover(const std::string &node_base = "/sys/devices/system/node");
+  std::vector<NumaNodeSnapshot> read_snapshot();
+
+  FRIEND_TEST(NumaMemoryTest, ReportsNodeUsageAndMissRates);
+
+public:
+  NumaMemoryPollingTask(DataStreamProvider &, SystemMetrics &,
+                        MetricsContext &);
+  void configure() override {};
+  void take_initial_snapshot() override;
+  void take_new_snapshot() override;
+  void calculate() override;
+  void commit() override;
+};
+using NumaMemoryPollingTaskPtr = std::unique_ptr<NumaMemoryPollingTask>;
+
+/**
+ * @brief Per-second rates of the configured /proc/vmstat counters.
+ * The file stays open and is re-read with pread(); VmstatTable maps the
+ * counters to line positions once, so a tick only parses those lines.
+ * Local only.
+ */
+class VmstatPollingTask : public IPollingTask {
+private:
+  ProcFile vmstat;
+  VmstatTable table;
+  std::vector<unsigned long long> prev_values;
+  std::vector<unsigned long long> current_values;
+  std::string buffer;
+
+  bool read_values(std::vector<unsigned long long> &values, bool &rebuilt);
+
+  FRIEND_TEST(VmstatTest, ReportsConfiguredCounterRates);
+
+public:
+  VmstatPollingTask(DataStreamProvider &, SystemMetrics &, MetricsContext &);
+  void configure() override {};
+  void take_initial_snapshot() override;
+  void take_new_snapshot() override;
+  void calculate() override;
+  void commit() override;
+};
+using VmstatPollingTaskPtr = std::unique_ptr<VmstatPollingTask>;
+
+/**
+ * @brief Per-zone fragmentation from a single /proc/buddyinfo parse.
+ * Free blocks land in a reused node x zone x order matrix; free pages per
+ * order are block counts shifted by their order. Optionally adds the
+ * migrate type breakdown of /proc/pagetypeinfo and the compaction rates
+ * from /proc/vmstat. Local only.
+ */
+class MemoryFragmentationTask : public IPollingTask {
+private:
+  ProcFile buddyinfo;
+  ProcFile pagetypeinfo;
+  ProcFile vmstat;
+  BuddyMatrix buddy;
+  VmstatTable compaction;
+  std::vector<unsigned long long> prev_compaction;
+  std::vector<unsigned long long> current_compaction;
+  std::string buffer;
+  std::string pagetypeinfo_text;
+
+  bool read_compaction(std::vector<unsigned long long> &values,
+                       bool &rebuilt);
+
+  FRIEND_TEST(MemoryFragmentationTaskTest, ReportsZonesAndCompaction);
+
+public:
+  MemoryFragmentationTask(DataStreamProvider &p, SystemMetrics &m,
+                          MetricsContext &ctx);
+
+  void configure() override;
+  void take_initial_snapshot() override;
+  void take_new_snapshot() override;
+  void calculate() override;
+  void commit() override;
+};
+using MemoryFragmentationTaskPtr = std::unique_ptr<MemoryFragmentationTask>;
+
+/**
+ * @brief Per-CPU rates from /proc/interrupts and /proc/softirqs.
+ * Both files stay open and are parsed into matrices that are reused (and
+ * swapped) across ticks. Emits the top_k busiest IRQ lines plus an "other"
+ * row, and every softirq type. Local only.
+ */
+class InterruptsPollingTask : public IPollingTask {
+private:
+  ProcFile interrupts_file;
+  ProcFile softirqs_file;
+  CounterMatrix prev_irqs;
+  CounterMatrix current_irqs;
+  CounterMatrix prev_softirqs;
+  CounterMatrix current_softirqs;
+  std::vector<float> irq_rates;
+  std::vector<float> softirq_rates;
+  std::vector<float> row_totals;
+  std::vector<size_t> order;
+  unsigned top_k = 0;
+  std::string buffer;
+
+  void read_matrix(const ProcFile &file, CounterMatrix &matrix);
+  void compute_rates(const CounterMatrix &prev, const CounterMatrix &curr,
+                     std::vector<float> &rates);
+  void select_top_k();
+
+  FRIEND_TEST(InterruptsTest, ReportsTopIrqsAndSoftirqsPerCpu);
+
+public:
+  InterruptsPollingTask(DataStreamProvider &, SystemMetrics &,
+                        MetricsContext &);
+  void configure() override {};
+  void take_initial_snapshot() override;
+  void take_new_snapshot() override;
+  void calculate() override;
+  void commit() override;
+};
+using InterruptsPollingTaskPtr = std::unique_ptr<InterruptsPollingTask>;
+
+/**
+ * @brief Per-cgroup CPU, memory, pressure and I/O from a cgroup v2 tree.
+ * The tree keeps every cgroup directory open and follows it with inotify;
+ * cpu.stat, memory.current, memory.pressure and io.stat are opened relative
+ * to those directory fds. Emits the top_k cgroups by CPU, by memory and by
+ * I/O. The root cgroup is skipped. Local only.
+ */
+class CgroupPollingTask : public IPollingTask {
+private:
+  CgroupTree tree;
+  unsigned top_k = 0;
+  // Indexed by tree slot
+  std::vector<CgroupSample> prev_samples;
+  std::vector<CgroupSample> current_samples;
+  std::vector<CgroupStats> stats;
+  std::vector<uint32_t> order;
+  ProcFile file;
+  std::string buffer;
+  std::string path_buffer; // Nodes without a held dirfd
+
+  void read_sample(const CgroupTree::Node &node, CgroupSample &sample);
+  void read_samples(std::vector<CgroupSample> &samples);
+  template <typename Key>
+  void select_top(std::vector<CgroupStats> &dest, Key key);
+
+  FRIEND_TEST(CgroupTest, ReportsTopCgroupsFromDeltas);
+  FRIEND_TEST(CgroupTest, ReadsCgroupsPastTheDirfdLimitByPath);
+
+public:
+  CgroupPollingTask(DataStreamProvider &, SystemMetrics &, MetricsContext &);
+  void configure() override {};
+  void take_initial_snapshot() override;
+  void take_new_snapshot() override;
+  void calculate() override;
+  void commit() override;
+};
+using CgroupPollingTaskPtr = std::unique_ptr<CgroupPollingTask>;
+
+/**
+ * @brief File descriptor usage and cpu/memory/io/irq pressure (PSI).
+ * file-nr and every /proc/pressure file stay open and are re-read with
+ * pread(); stall time per second comes from the "total" counter deltas.
+ * Local only.
+ */
 class SystemStabilityPollingTask : public IPollingTask {
+private:
+  ProcFile file_nr;
+  std::array<ProcFile, PSI_KIND_COUNT> pressure_files;
+  std::array<PsiResource, PSI_KIND_COUNT> prev_pressure{};
+  std::array<PsiResource, PSI_KIND_COUNT> current_pressure{};
+  // The file read and parsed; a failed read leaves zero totals behind
+  std::array<bool, PSI_KIND_COUNT> prev_valid{};
+  std::array<bool, PSI_KIND_COUNT> current_valid{};
+  std::string buffer;
+
+  void read_pressure(std::array<PsiResource, PSI_KIND_COUNT> &pressure,
+                     std::array<bool, PSI_KIND_COUNT> &valid);
+
+  FRIEND_TEST(StabilityValidation, StallRateFromTotalDeltas);
+  FRIEND_TEST(StabilityValidation, NoStallRateAcrossAFailedRead);
+
 public:
   SystemStabilityPollingTask(DataStreamProvider &p, SystemMetrics &m,
                              MetricsContext &ctx);
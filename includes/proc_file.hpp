@@ -0,0 +1,68 @@
+// proc_file.hpp
+#ifndef PROC_FILE_HPP
+#define PROC_FILE_HPP
+
+#include "pcn.hpp"
+
+namespace telemetry {
+
+/**
+ * @brief Keeps a procfs/sysfs file open across ticks and re-reads it with
+ * pread() from offset 0. Pseudo-files regenerate their content on every read
+ * from the start, so this avoids the open/close (and ifstream setup) cost of
+ * reading small, hot files every tick.
+ */
+class ProcFile {
+public:
+  ProcFile() = default;
+  explicit ProcFile(const std::string &path) { open(path); }
+  ~ProcFile();
+
+  ProcFile(const ProcFile &) = delete;
+  ProcFile &operator=(const ProcFile &) = delete;
+  ProcFile(ProcFile &&other) noexcept;
+  ProcFile &operator=(ProcFile &&other) noexcept;
+
+  bool open(const std::string &path);
+  // Opens name relative to an already open directory (see openat(2))
+  bool open_at(int dirfd, const char *name);
+  void close();
+  bool is_open() const { return fd >= 0; }
+  int get_fd() const { return fd; }
+  const std::string &path() const { return file_path; }
+
+  /**
+   * @brief Replaces buffer with the current file contents.
+   * The buffer keeps its capacity between calls.
+   * @return false if the file is not open or the read failed.
+   */
+  bool read(std::string &buffer) const;
+  // Reads a single-value sysfs file such as a cumulative counter
+  bool read_counter(std::string &buffer, unsigned long long &value) const;
+
+private:
+  int fd = -1;
+  std::string file_path;
+};
+
+enum class CounterWidth { Bits32, Bits64 };
+
+/**
+ * @brief Amount a cumulative kernel counter advanced between two reads.
+ * A smaller reading means the counter was reset (device re-added, CPU
+ * hotplug, driver reload) and counted up again from zero, so the new value
+ * is the delta. Only counters from a source known to be 32 bits wide are
+ * instead treated as having wrapped at 2^32.
+ */
+inline unsigned long long
+counter_delta(unsigned long long current, unsigned long long previous,
+              CounterWidth width = CounterWidth::Bits64) {
+  if (current >= previous)
+    return current - previous;
+  if (width == CounterWidth::Bits32 && previous <= UINT32_MAX)
+    return (UINT32_MAX - previous) + current + 1;
+  return current;
+}
+
+}; // namespace telemetry
+#endif
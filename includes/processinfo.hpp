@@ -3,25 +3,220 @@
 #define PROCESSINFO_HPP
 
 #include <algorithm>
+#include <chrono>
 #include <cmath> // For std::round
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <thread>
 
+#include "lru_cache.hpp"
 #include "pcn.hpp"
 namespace telemetry {
 
 class LuaConfigGenerator;
-// Data structure to hold information about a single process
+
+// Kernel comm names are at most 15 characters (TASK_COMM_LEN - 1).
+constexpr size_t PROCESS_NAME_LEN = 16;
+// Percentages are stored as fixed-point hundredths (0..10000).
+constexpr double PROCESS_PERCENT_SCALE = 100.0;
+
+// Data structure to hold information about a single process.
+// Kept trivially copyable so the top-N selection can shuffle records
+// without touching the heap.
 struct ProcessInfo {
-  int pid = 0;
-  long vmRssKb = 0; // Resident Set Size in KiB
-  double cpu_percent = 0.0;
-  double mem_percent = 0.0;
-  double cpu_avg_percent = 0.0;
+  int32_t pid = 0;
+  int32_t open_fds = 0;
+  uint32_t vmRssKb = 0; // Resident Set Size in KiB
+  // From smaps_rollup, top memory processes only (0 until read)
+  uint32_t pss_kb = 0; // Shared pages split between their users
+  uint32_t uss_kb = 0; // Pages no other process maps
+  uint32_t swap_kb = 0;
+  uint16_t cpu_percent_fp = 0;
+  uint16_t mem_percent_fp = 0;
+  uint16_t cpu_avg_percent_fp = 0;
   uint64_t io_read_bytes = 0;
   uint64_t io_write_bytes = 0;
-  int open_fds = 0;
 
-  std::string name;
+  char name[PROCESS_NAME_LEN] = {};
+
+  double cpu_percent() const { return cpu_percent_fp / PROCESS_PERCENT_SCALE; }
+  double mem_percent() const { return mem_percent_fp / PROCESS_PERCENT_SCALE; }
+  double cpu_avg_percent() const {
+    return cpu_avg_percent_fp / PROCESS_PERCENT_SCALE;
+  }
+  void set_cpu_percent(double value) { cpu_percent_fp = to_fixed(value); }
+  void set_mem_percent(double value) { mem_percent_fp = to_fixed(value); }
+  void set_cpu_avg_percent(double value) {
+    cpu_avg_percent_fp = to_fixed(value);
+  }
+  void set_name(const std::string &value) {
+    size_t len = std::min(value.size(), PROCESS_NAME_LEN - 1);
+    std::memcpy(name, value.data(), len);
+    name[len] = '\0';
+  }
+
+private:
+  static uint16_t to_fixed(double value) {
+    double clamped = std::clamp(value, 0.0, 100.0);
+    return static_cast<uint16_t>(std::lround(clamped * PROCESS_PERCENT_SCALE));
+  }
+};
+static_assert(std::is_trivially_copyable_v<ProcessInfo>,
+              "ProcessInfo must stay trivially copyable");
+
+// A top-N list is a set of indices into a shared ProcessInfo array.
+using ProcessIndexList = std::vector<uint32_t>;
+
+// Where a process lives, from /proc/<pid>/cgroup. Kept beside the records
+// (same index) so ProcessInfo stays trivially copyable.
+struct ProcessCgroup {
+  std::string path; // "/system.slice/sshd.service"
+  // The systemd unit, or "docker:<id>" style for containers
+  std::string unit;
+};
+
+// Identifies one process lifetime; pids are reused, start times are not
+struct ProcessKey {
+  int32_t pid = 0;
+  unsigned long long start_time = 0;
+  bool operator==(const ProcessKey &other) const {
+    return pid == other.pid && start_time == other.start_time;
+  }
+};
+
+struct ProcessKeyHash {
+  size_t operator()(const ProcessKey &key) const {
+    uint64_t mixed = key.start_time * 0x9E3779B97F4A7C15ULL;
+    return std::hash<uint64_t>()(mixed ^ static_cast<uint32_t>(key.pid));
+  }
+};
+
+// Picks the cgroup v2 ("0::") entry, else the systemd v1 hierarchy
+bool parse_proc_cgroup(std::string_view text, ProcessCgroup &cgroup);
+// Deepest .service/.scope component, or the container id of a known runtime
+std::string cgroup_unit_name(std::string_view path);
+
+// Totals from /proc/<pid>/smaps_rollup, in KiB
+struct SmapsRollup {
+  uint32_t rss_kb = 0;
+  uint32_t pss_kb = 0;
+  uint32_t uss_kb = 0; // Private_Clean + Private_Dirty
+  uint32_t swap_kb = 0;
+};
+
+bool parse_smaps_rollup(std::string_view text, SmapsRollup &rollup);
+// Whether RSS moved far enough from the value at the last read to re-read
+bool smaps_rss_moved(uint32_t read_rss_kb, uint32_t rss_kb, unsigned percent);
+
+struct SmapsRequest {
+  ProcessKey key;
+  uint32_t rss_kb = 0; // Latest VmRSS, to decide whether to re-read
 };
+
+/**
+ * @brief Reads smaps_rollup for the top memory processes on a helper
+ * thread, on its own cadence. The kernel walks every mapping of the process
+ * to produce the file, so a result is reused until the process's RSS moves
+ * by more than the configured percentage. Processes without a result are
+ * read right away.
+ */
+class SmapsRefresher {
+public:
+  SmapsRefresher() = default;
+  ~SmapsRefresher();
+
+  SmapsRefresher(const SmapsRefresher &) = delete;
+  SmapsRefresher &operator=(const SmapsRefresher &) = delete;
+
+  void start(std::chrono::milliseconds interval, unsigned rss_change_percent,
+             size_t capacity);
+  void stop();
+  bool is_running() const { return thread.joinable(); }
+
+  // Replaces the watched processes
+  void set_processes(const std::vector<SmapsRequest> &processes);
+  // Latest result for key; false if none is available yet
+  bool get(const ProcessKey &key, SmapsRollup &rollup);
+
+private:
+  struct Entry {
+    SmapsRollup rollup;
+    bool valid = false; // The file could be read
+  };
+
+  void run();
+  bool needs_read(const SmapsRequest &request);
+
+  std::chrono::milliseconds interval{5000};
+  unsigned rss_change_percent = 10;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+  bool has_new = false;
+  std::vector<SmapsRequest> processes;
+  LruCache<ProcessKey, Entry, ProcessKeyHash> results;
+  std::thread thread;
+};
+
+/**
+ * @brief Read-only view of a top-N list, resolving indices against the
+ * shared record array. Iterates as `const ProcessInfo &`.
+ */
+class ProcessListView {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ProcessInfo;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const ProcessInfo *;
+    using reference = const ProcessInfo &;
+
+    iterator(const std::vector<ProcessInfo> *records,
+             ProcessIndexList::const_iterator it)
+        : records(records), it(it) {}
+    reference operator*() const { return (*records)[*it]; }
+    pointer operator->() const { return &(*records)[*it]; }
+    iterator &operator++() {
+      ++it;
+      return *this;
+    }
+    bool operator==(const iterator &other) const { return it == other.it; }
+    bool operator!=(const iterator &other) const { return it != other.it; }
+
+  private:
+    const std::vector<ProcessInfo> *records;
+    ProcessIndexList::const_iterator it;
+  };
+
+  ProcessListView(const std::vector<ProcessInfo> &records,
+                  const ProcessIndexList &indices,
+                  const std::vector<ProcessCgroup> *cgroups = nullptr)
+      : records(&records), indices(&indices), cgroups(cgroups) {}
+
+  iterator begin() const { return {records, indices->begin()}; }
+  iterator end() const { return {records, indices->end()}; }
+  size_t size() const { return indices->size(); }
+  bool empty() const { return indices->empty(); }
+  const ProcessInfo &operator[](size_t i) const {
+    return (*records)[(*indices)[i]];
+  }
+  // nullptr when the records were not annotated
+  const ProcessCgroup *cgroup(size_t i) const {
+    size_t record = (*indices)[i];
+    return cgroups != nullptr && record < cgroups->size() ? &(*cgroups)[record]
+                                                          : nullptr;
+  }
+
+private:
+  const std::vector<ProcessInfo> *records;
+  const ProcessIndexList *indices;
+  const std::vector<ProcessCgroup> *cgroups;
+};
+
 struct CpuState {
   long jiffies;
   std::chrono::steady_clock::time_point timestamp;
@@ -36,6 +231,12 @@ struct Processes {
   long unsigned int count = true;
   std::vector<std::string> ignore_list;
   bool only_user_processes = false;
+  // PSS/USS/swap of the top memory processes, read off the polling thread
+  // on this cadence; a result is reused until the RSS moves by more than
+  // smaps_rss_change_percent
+  bool enable_smaps = true;
+  unsigned smaps_interval_ms = 5000;
+  unsigned smaps_rss_change_percent = 10;
   bool enable_processinfo() const;
 }; // End Processes struct
 
@@ -11,6 +11,7 @@ struct DiskUsage;
 struct ProcessRawSnapshot;
 struct BatteryStatus;
 struct Batteries;
+struct SensorReading;
 
 using ProcessSnapshotMap = std::map<long, ProcessRawSnapshot>;
 
@@ -42,6 +43,7 @@ public:
   //   0; virtual uint64_t get_disk_size_bytes(const std::string& mount_point) =
   //   0;
   virtual double get_cpu_temperature() = 0;
+  virtual void get_sensors(std::vector<SensorReading> &) = 0;
   virtual void cleanup() = 0;
 };
 
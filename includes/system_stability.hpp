@@ -1,20 +1,49 @@
 #ifndef SYSTEM_STABILITY_HPP
 #define SYSTEM_STABILITY_HPP
 
+#include <array>
+
+#include "pcn.hpp"
+
 namespace telemetry {
 
-double parse_avg10(const std::string &line);
+// One "some" or "full" line of a /proc/pressure file
+struct PsiLine {
+  double avg10 = 0.0; // Percent of wall time stalled, 10s/60s/300s windows
+  double avg60 = 0.0;
+  double avg300 = 0.0;
+  unsigned long long total_us = 0; // Cumulative stall time
+  double stall_us_per_sec = 0.0;   // From total_us deltas
+};
+
+// "some": at least one task stalled; "full": every non-idle task stalled
+struct PsiResource {
+  PsiLine some;
+  PsiLine full;
+};
+
+enum class PsiKind : uint8_t { Cpu, Memory, Io, Irq };
+constexpr size_t PSI_KIND_COUNT = 4;
+
+// "cpu", "memory", "io", "irq": the /proc/pressure file name
+const char *psi_kind_name(PsiKind kind);
+
+// Fills the lines present in text (irq only has "full")
+bool parse_psi(const std::string &text, PsiResource &resource);
 
 struct SystemStability {
   long file_descriptors_allocated = 0;
   long file_descriptors_max = 0;
   // Pressure Stall Information (PSI) - The "Lag" indicator
-  double memory_pressure_some = 0.0;
-  double cpu_pressure_some = 0.0;
-  double memory_pressure_full = 0.0;
-  double io_pressure_some = 0.0;
-  double io_pressure_full = 0.0;
+  std::array<PsiResource, PSI_KIND_COUNT> pressure{};
   double memory_fragmentation_index = 0.0;
+
+  const PsiResource &psi(PsiKind kind) const {
+    return pressure[static_cast<size_t>(kind)];
+  }
+  PsiResource &psi(PsiKind kind) {
+    return pressure[static_cast<size_t>(kind)];
+  }
 };
 
 }; // namespace telemetry
@@ -0,0 +1,76 @@
+// vmstat.hpp
+#ifndef VMSTAT_HPP
+#define VMSTAT_HPP
+
+#include <string_view>
+#include <unordered_map>
+
+#include "pcn.hpp"
+
+namespace telemetry {
+
+struct VmstatRate {
+  std::string name;
+  double per_sec = 0.0;
+};
+
+/**
+ * @brief Resolves the configured /proc/vmstat counters to fixed slots.
+ * The kernel prints its counters in a fixed order, so build() looks each
+ * line up in the name map once and remembers the line of every wanted
+ * counter; parse() then only converts the values on those lines. A
+ * remembered line whose name no longer matches makes parse() fail so the
+ * caller can rebuild.
+ */
+class VmstatTable {
+public:
+  // "*" selects every counter the kernel exposes
+  explicit VmstatTable(const std::vector<std::string> &wanted = {});
+
+  bool build(std::string_view text);
+  bool parse(std::string_view text,
+             std::vector<unsigned long long> &values) const;
+  // parse(), rebuilding first when the layout is unknown or has changed;
+  // rebuilt tells the caller that older values use other slots
+  bool update(std::string_view text, std::vector<unsigned long long> &values,
+              bool &rebuilt);
+  bool is_built() const { return built; }
+  // Counters found by the last build(), in configured order
+  const std::vector<std::string> &counters() const { return names; }
+
+private:
+  struct Line {
+    size_t line;
+    size_t slot;
+  };
+  std::unordered_map<std::string, size_t> wanted_slots;
+  std::vector<std::string> wanted_names;
+  bool wants_all = false;
+
+  std::vector<std::string> names;
+  std::vector<Line> lines; // Sorted by line
+  bool built = false;
+};
+
+// Per-second rates of the table's counters; regressed counters report 0
+void compute_vmstat_rates(const VmstatTable &table,
+                          const std::vector<unsigned long long> &prev,
+                          const std::vector<unsigned long long> &curr,
+                          double seconds, std::vector<VmstatRate> &out);
+
+struct Vmstat {
+  // /proc/vmstat counters reported as per-second rates
+  std::vector<std::string> counters = {
+      "pgfault",        "pgmajfault",     "pswpin",
+      "pswpout",        "pgscan_kswapd",  "pgscan_direct",
+      "pgsteal_kswapd", "pgsteal_direct", "allocstall_normal",
+      "compact_stall",  "oom_kill"};
+};
+
+struct LuaVmstat : public Vmstat {
+  std::string serialize(unsigned indentation_level = 0) const;
+  void deserialize(sol::table vmstat);
+};
+
+}; // namespace telemetry
+#endif
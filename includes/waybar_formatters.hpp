@@ -8,18 +8,17 @@ namespace telemetry {
 
 struct MetricsContext;
 struct FormattedSize;
-struct ProcessInfo;
+class ProcessListView;
 struct DeviceInfo;
 
 FormattedSize format_size_rate(double bytes_per_sec);
 void generate_waybar_output(const std::vector<MetricsContext> &all_results);
 
-std::string
-show_top_mem_procs(const MetricsContext &result,
-                   const std::vector<ProcessInfo> &top_processes_mem);
+std::string show_top_mem_procs(const MetricsContext &result,
+                               const ProcessListView &top_processes_mem);
 
 std::string show_top_cpu_procs(const MetricsContext &result,
-                               const std::vector<ProcessInfo> &top_procs_cpu);
+                               const ProcessListView &top_procs_cpu);
 
 std::string show_network_interfaces(
     const MetricsContext &result,
@@ -6,6 +6,7 @@
 #include "stream_provider.hpp"
 namespace telemetry {  
 struct Deviceinfo;
+class ProcessListView;
 // A simple reusable progress bar (eww 'bar')
 class SimpleBar : public Gtk::Box {
  public:
@@ -36,7 +37,7 @@ class SysInfo : public Gtk::Frame {
 class ProcList : public Gtk::Frame {
  public:
   ProcList(const Glib::ustring& title);
-  void update(const std::vector<ProcessInfo>& procs);
+  void update(const ProcessListView& procs);
 
  protected:
   Gtk::Box m_main_box;
@@ -25,7 +25,7 @@ ColumnLayout {
         delegate: RowLayout {
             Layout.fillWidth: true
             spacing: 10
-            DefaultText { text: modelData.core_id === 0 ? "Avg" : "Core " + modelData.core_id; Layout.preferredWidth: 50 }
+            DefaultText { text: modelData.core_id === 0 ? "Avg" : "Core " + modelData.cpu; Layout.preferredWidth: 50 }
             MetricBar { value: modelData.user_percent; barColor: "#77aaff" }
             MetricBar { value: modelData.system_percent; barColor: "#ff7777" }
             MetricBar { value: modelData.nice_percent; barColor: "#77ff77" }
@@ -17,9 +17,9 @@ ColumnLayout {
         model: root.metrics ? root.metrics.disk_io : []
         delegate: RowLayout {
             spacing: 10
-            DefaultText { text: modelData[0]; Layout.preferredWidth: 100; elide: Text.ElideRight }
-            DefaultText { text: (modelData[1].read_bytes_per_sec / 1024).toFixed(2); Layout.preferredWidth: 100; horizontalAlignment: Text.AlignRight }
-            DefaultText { text: (modelData[1].write_bytes_per_sec / 1024).toFixed(2); Layout.preferredWidth: 100; horizontalAlignment: Text.AlignRight }
+            DefaultText { text: modelData.device_name; Layout.preferredWidth: 100; elide: Text.ElideRight }
+            DefaultText { text: (modelData.read_bytes_per_sec / 1024).toFixed(2); Layout.preferredWidth: 100; horizontalAlignment: Text.AlignRight }
+            DefaultText { text: (modelData.write_bytes_per_sec / 1024).toFixed(2); Layout.preferredWidth: 100; horizontalAlignment: Text.AlignRight }
         }
     }
 }
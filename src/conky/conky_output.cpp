@@ -56,7 +56,7 @@ void print_metrics(const SystemMetrics& metrics) {
 
   std::cout << "--- Top Processes (Mem) ---" << std::endl;
   std::cout << "PID\tVmRSS (MiB)\tName" << std::endl;
-  for (const auto& proc : metrics.top_processes_avg_mem) {
+  for (const auto& proc : metrics.processes(metrics.top_processes_avg_mem)) {
     double vmRssMiB = static_cast<double>(proc.vmRssKb) / 1024.0;
     std::cout << proc.pid << "\t" << std::fixed << std::setprecision(1)
               << vmRssMiB << "\t\t" << proc.name << std::endl;
@@ -65,9 +65,9 @@ void print_metrics(const SystemMetrics& metrics) {
   std::cout << "--- Top Processes (CPU) ---" << std::endl;
   std::cout << "PID\t%CPU\t\tName" << std::endl;
   // Iterate over the new vector, accessing the cpu_percent field
-  for (const auto& proc : metrics.top_processes_avg_cpu) {
+  for (const auto& proc : metrics.processes(metrics.top_processes_avg_cpu)) {
     std::cout << proc.pid << "\t" << std::fixed << std::setprecision(1)
-              << proc.cpu_percent << "%\t\t" << proc.name << std::endl;
+              << proc.cpu_percent() << "%\t\t" << proc.name << std::endl;
   }
   std::cout << "---------------------------" << std::endl;
 }
@@ -2,6 +2,7 @@
 #include "batteryinfo.hpp"
 #include "diskstat.hpp"
 #include "lua_generator.hpp"
+#include "meminfo.hpp"
 #include "metric_settings.hpp"
 #include "networkstats.hpp"
 #include "processinfo.hpp"
@@ -26,13 +27,18 @@ std::string LuaFeatures::serialize(unsigned const int indentation_level) const {
   features.lua_bool("enable_uptime", enable_uptime);
   features.lua_bool("enable_memory", enable_memory);
   features.lua_bool("enable_cpu_temp", enable_cpu_temp);
+  features.lua_bool("enable_sensors", enable_sensors);
   features.lua_bool("enable_cpuinfo", enable_cpuinfo);
+  features.lua_bool("enable_cpu_idle", enable_cpu_idle);
+  features.lua_bool("enable_schedstat", enable_schedstat);
 
   // Stats and Logic
   features.lua_bool("enable_load_and_process_stats",
                     enable_load_and_process_stats);
   features.lua_bool("enable_network_stats", enable_network_stats);
   features.lua_bool("enable_diskstat", enable_diskstat);
+  features.lua_bool("enable_interrupts", enable_interrupts);
+  features.lua_bool("enable_cgroups", enable_cgroups);
   features.lua_bool("enable_network_stats", enable_network_stats);
 
   return features.str();
@@ -48,8 +54,14 @@ void LuaFeatures::deserialize(sol::table features) {
         features.get<sol::optional<bool>>("enable_memory").value_or(true);
     enable_cpu_temp =
         features.get<sol::optional<bool>>("enable_cpu_temp").value_or(true);
+    enable_sensors =
+        features.get<sol::optional<bool>>("enable_sensors").value_or(true);
     enable_cpuinfo =
         features.get<sol::optional<bool>>("enable_cpuinfo").value_or(true);
+    enable_cpu_idle =
+        features.get<sol::optional<bool>>("enable_cpu_idle").value_or(true);
+    enable_schedstat =
+        features.get<sol::optional<bool>>("enable_schedstat").value_or(true);
     enable_load_and_process_stats =
         features.get<sol::optional<bool>>("enable_load_and_process_stats")
             .value_or(true);
@@ -58,6 +70,10 @@ void LuaFeatures::deserialize(sol::table features) {
             .value_or(true);
     enable_diskstat =
         features.get<sol::optional<bool>>("enable_diskstat").value_or(true);
+    enable_interrupts =
+        features.get<sol::optional<bool>>("enable_interrupts").value_or(true);
+    enable_cgroups =
+        features.get<sol::optional<bool>>("enable_cgroups").value_or(true);
     if (features["processes"].valid()) {
       LuaProcesses lp;
       lp.deserialize(features["processes"]);
@@ -81,6 +97,16 @@ std::string LuaMetricSettings::serialize(unsigned indentation_level) const {
       static_cast<const LuaFeatures &>(features).serialize(indentation_level));
   gen.lua_append(static_cast<const LuaBatteries &>(batteries).serialize(
       indentation_level));
+  gen.lua_append(
+      static_cast<const LuaMemory &>(memory).serialize(indentation_level));
+  gen.lua_append(
+      static_cast<const LuaVmstat &>(vmstat).serialize(indentation_level));
+  gen.lua_append(static_cast<const LuaInterrupts &>(interrupts).serialize(
+      indentation_level));
+  gen.lua_append(
+      static_cast<const LuaCgroups &>(cgroups).serialize(indentation_level));
+  gen.lua_append(
+      static_cast<const LuaNetwork &>(network).serialize(indentation_level));
   gen.lua_append(
       static_cast<const LuaStorage &>(storage).serialize(indentation_level));
   gen.lua_append(static_cast<const LuaSSH &>(ssh).serialize(indentation_level));
@@ -108,6 +134,37 @@ void LuaMetricSettings::deserialize(sol::table settings) {
     batteries = static_cast<Batteries>(lb);
   }
 
+  if (settings["memory"].valid()) {
+    LuaMemory lm;
+    lm.deserialize(settings["memory"]);
+    memory = static_cast<Memory>(lm);
+  }
+
+  if (settings["vmstat"].valid()) {
+    LuaVmstat lv;
+    lv.deserialize(settings["vmstat"]);
+    vmstat = static_cast<Vmstat>(lv);
+  }
+
+  if (settings["interrupts"].valid()) {
+    LuaInterrupts li;
+    li.deserialize(settings["interrupts"]);
+    interrupts = static_cast<Interrupts>(li);
+  }
+
+  if (settings["cgroups"].valid()) {
+    LuaCgroups lc;
+    lc.deserialize(settings["cgroups"]);
+    cgroups = static_cast<Cgroups>(lc);
+  }
+
+  if (settings["network"].valid()) {
+    LuaNetwork ln;
+    ln.deserialize(settings["network"]);
+    network = static_cast<Network>(ln);
+    interfaces = {network.interfaces.begin(), network.interfaces.end()};
+  }
+
   if (settings["storage"].valid()) {
     LuaStorage ls;
     ls.deserialize(settings["storage"]);
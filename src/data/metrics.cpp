@@ -69,18 +69,28 @@ void SystemMetrics::create_pipeline(MetricsContext &context) {
         [this]() { cpu_temp_c = provider->get_cpu_temperature(); });
   }
 
+  // Task: Hardware sensors (all hwmon channels)
+  if (settings.features.enable_sensors) {
+    task_pipeline.emplace_back([this]() { provider->get_sensors(sensors); });
+  }
+
   // Task: Memory
   if (settings.features.enable_memory) {
-    task_pipeline.emplace_back([this]() {
-      get_mem_usage(provider->get_meminfo_stream(), meminfo, swapinfo);
+    task_pipeline.emplace_back([this, buffer = std::string()]() mutable {
+      read_meminfo(provider->get_meminfo_stream(), buffer, meminfo_fields);
+      summarize_meminfo(meminfo_fields, meminfo, swapinfo);
     });
   }
 
   // Task: Uptime & Freq
+  // With enable_cpuinfo the frequency comes from CpuFrequencyPollingTask,
+  // which averages every core instead of reporting the first one.
   if (settings.features.enable_uptime) {
-    task_pipeline.emplace_back([this]() {
+    bool read_cpuinfo = !settings.features.enable_cpuinfo;
+    task_pipeline.emplace_back([this, read_cpuinfo]() {
       uptime = get_uptime(provider->get_uptime_stream());
-      cpu_frequency_ghz = get_cpu_freq_ghz(provider->get_cpuinfo_stream());
+      if (read_cpuinfo)
+        cpu_frequency_ghz = get_cpu_freq_ghz(provider->get_cpuinfo_stream());
     });
   }
 
@@ -119,16 +129,33 @@ void SystemMetrics::configure_polling_pipeline(MetricsContext &context) {
 
   CREATE_POLLING_TASK("cpuinfo", CpuPollingTask,
                       settings.features.enable_cpuinfo);
+  // Annotates the cores produced by CpuPollingTask, so it must follow it
+  CREATE_POLLING_TASK("cpufreq", CpuFrequencyPollingTask,
+                      settings.features.enable_cpuinfo);
+  CREATE_POLLING_TASK("cpuidle", CpuIdlePollingTask,
+                      settings.features.enable_cpuinfo &&
+                          settings.features.enable_cpu_idle);
+  CREATE_POLLING_TASK("schedstat", SchedstatPollingTask,
+                      settings.features.enable_cpuinfo &&
+                          settings.features.enable_schedstat);
+  CREATE_POLLING_TASK("numa_memory", NumaMemoryPollingTask,
+                      settings.features.enable_memory);
   CREATE_POLLING_TASK("stability", SystemStabilityPollingTask,
                       settings.features.enable_stability_info);
+  CREATE_POLLING_TASK("vmstat", VmstatPollingTask,
+                      settings.features.enable_stability_info);
   CREATE_POLLING_TASK("networkstats", NetworkPollingTask,
                       settings.features.enable_network_stats);
   CREATE_POLLING_TASK("diskstat", DiskPollingTask,
                       settings.features.enable_diskstat);
+  CREATE_POLLING_TASK("interrupts", InterruptsPollingTask,
+                      settings.features.enable_interrupts);
+  CREATE_POLLING_TASK("cgroups", CgroupPollingTask,
+                      settings.features.enable_cgroups);
   CREATE_POLLING_TASK("processinfo", ProcessPollingTask,
                       settings.features.processes.enable_processinfo());
   CREATE_POLLING_TASK("fragmentation", MemoryFragmentationTask,
-                      settings.features.processes.enable_processinfo());
+                      settings.features.enable_stability_info);
   (void)new_task;
 }
 }; // namespace telemetry
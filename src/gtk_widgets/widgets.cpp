@@ -138,7 +138,7 @@ ProcList::ProcList(const Glib::ustring& title)
   m_main_box.append(m_list_box);
 }
 
-void ProcList::update(const std::vector<ProcessInfo>& procs) {
+void ProcList::update(const ProcessListView& procs) {
   size_t num_procs = procs.size();
 
   // Ensure we have enough row widgets
@@ -186,12 +186,12 @@ void ProcList::update(const std::vector<ProcessInfo>& procs) {
           Glib::ustring::sprintf("%d", proc.pid));
 
       child = child->get_next_sibling();
-      dynamic_cast<Gtk::Label*>(child)->set_text(format_num(proc.cpu_percent) +
-                                                 "%");
+      dynamic_cast<Gtk::Label*>(child)->set_text(
+          format_num(proc.cpu_percent()) + "%");
 
       child = child->get_next_sibling();
-      dynamic_cast<Gtk::Label*>(child)->set_text(format_num(proc.mem_percent) +
-                                                 "%");
+      dynamic_cast<Gtk::Label*>(child)->set_text(
+          format_num(proc.mem_percent()) + "%");
 
       row_box->set_visible(true);
     } else {
@@ -442,7 +442,7 @@ void StackedCoreBar::update(const CoreStats& core) {
   if (core.core_id == 0) {
     m_label_name.set_text("Avg");
   } else {
-    m_label_name.set_text(Glib::ustring::sprintf("Core %zu", core.core_id - 1));
+    m_label_name.set_text(Glib::ustring::sprintf("Core %zu", core.cpu));
   }
 
   m_label_total.set_text(format_num(core.total_usage_percent) + "%");
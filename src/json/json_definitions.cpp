@@ -4,9 +4,12 @@
 #include <nlohmann/json.hpp>
 
 #include "batteryinfo.hpp"
+#include "cgroups.hpp"
 #include "corestat.hpp"
 #include "diskstat.hpp"
 #include "filesystems.hpp"
+#include "frag_stats.hpp"
+#include "interrupts.hpp"
 #include "json_definitions.hpp"
 #include "log.hpp"
 #include "meminfo.hpp"
@@ -15,7 +18,9 @@
 #include "nlohmann/json.hpp"
 #include "processinfo.hpp"
 #include "stream_provider.hpp"
+#include "system_stability.hpp"
 #include "uptime.hpp"
+#include "vmstat.hpp"
 
 namespace telemetry {
 
@@ -50,21 +55,48 @@ void from_json(const json &j, Time &t) {
 
 // --- Storage ---
 void to_json(json &j, const DiskUsage &s) {
-  j = json{{"used_bytes", s.used_bytes}, {"size_bytes", s.size_bytes}};
+  j = json{{"used_bytes", s.used_bytes},
+           {"size_bytes", s.size_bytes},
+           {"inodes_used", s.inodes_used},
+           {"inodes_total", s.inodes_total},
+           {"stale", s.stale}};
 }
 void from_json(const json &j, DiskUsage &s) {
   j.at("used_bytes").get_to(s.used_bytes);
   j.at("size_bytes").get_to(s.size_bytes);
+  s.inodes_used = j.value("inodes_used", uint64_t{0});
+  s.inodes_total = j.value("inodes_total", uint64_t{0});
+  s.stale = j.value("stale", false);
 }
 
 // --- Disk IO
 void to_json(json &j, const DiskIoStats &s) {
   j = json{{"read_bytes_per_sec", s.read_bytes_per_sec},
-           {"write_bytes_per_sec", s.write_bytes_per_sec}};
+           {"write_bytes_per_sec", s.write_bytes_per_sec},
+           {"read_iops", s.read_iops},
+           {"write_iops", s.write_iops},
+           {"discard_iops", s.discard_iops},
+           {"flush_iops", s.flush_iops},
+           {"util_percent", s.util_percent},
+           {"await_ms", s.await_ms},
+           {"read_await_ms", s.read_await_ms},
+           {"write_await_ms", s.write_await_ms},
+           {"avg_queue_size", s.avg_queue_size},
+           {"in_flight", s.in_flight}};
 }
 void from_json(const json &j, DiskIoStats &s) {
   j.at("read_bytes_per_sec").get_to(s.read_bytes_per_sec);
   j.at("write_bytes_per_sec").get_to(s.write_bytes_per_sec);
+  s.read_iops = j.value("read_iops", 0.0);
+  s.write_iops = j.value("write_iops", 0.0);
+  s.discard_iops = j.value("discard_iops", 0.0);
+  s.flush_iops = j.value("flush_iops", 0.0);
+  s.util_percent = j.value("util_percent", 0.0);
+  s.await_ms = j.value("await_ms", 0.0);
+  s.read_await_ms = j.value("read_await_ms", 0.0);
+  s.write_await_ms = j.value("write_await_ms", 0.0);
+  s.avg_queue_size = j.value("avg_queue_size", 0.0);
+  s.in_flight = j.value("in_flight", uint64_t{0});
 }
 
 // --- Disk Info
@@ -83,46 +115,159 @@ void from_json(const json &j, DeviceInfo &s) {
 
 // --- HDD IO
 void to_json(json &j, const HdIoStats &s) {
-  j = json{{"device_name", s.device_name},
-           {"read_bytes_per_sec", s.read_bytes_per_sec},
-           {"write_bytes_per_sec", s.write_bytes_per_sec}};
+  to_json(j, static_cast<const DiskIoStats &>(s));
+  j["device_name"] = s.device_name;
+  j["aggregated_devices"] = s.aggregated_devices;
 }
 void from_json(const json &j, HdIoStats &s) {
   j.at("device_name").get_to(s.device_name);
-  j.at("read_bytes_per_sec").get_to(s.read_bytes_per_sec);
-  j.at("write_bytes_per_sec").get_to(s.write_bytes_per_sec);
+  s.aggregated_devices = j.value("aggregated_devices", 0u);
+  from_json(j, static_cast<DiskIoStats &>(s));
+}
+
+// --- Sensors ---
+void to_json(json &j, const SensorReading &s) {
+  j = json{{"chip", s.chip},
+           {"label", s.label},
+           {"type", sensor_kind_name(s.kind)},
+           {"value", s.value}};
+}
+void from_json(const json &j, SensorReading &s) {
+  j.at("chip").get_to(s.chip);
+  j.at("label").get_to(s.label);
+  j.at("value").get_to(s.value);
+  std::string type = j.value("type", "temperature");
+  for (auto kind : {SensorKind::Temperature, SensorKind::Fan,
+                    SensorKind::Voltage, SensorKind::Power,
+                    SensorKind::Current}) {
+    if (type == sensor_kind_name(kind))
+      s.kind = kind;
+  }
 }
 
 // --- CPU ---
+void to_json(json &j, const IdleStateResidency &s) {
+  j = json{{"name", s.name}, {"residency_percent", s.residency_percent}};
+}
+void from_json(const json &j, IdleStateResidency &s) {
+  j.at("name").get_to(s.name);
+  j.at("residency_percent").get_to(s.residency_percent);
+}
+
 void to_json(json &j, const CoreStats &s) {
   j = json{{"core_id", s.core_id},
+           {"cpu", s.cpu},
            {"user_percent", s.user_percent},
            {"nice_percent", s.nice_percent},
            {"system_percent", s.system_percent},
            {"iowait_percent", s.iowait_percent},
            {"idle_percent", s.idle_percent},
-           {"total_usage_percent", s.total_usage_percent}};
+           {"irq_percent", s.irq_percent},
+           {"softirq_percent", s.softirq_percent},
+           {"steal_percent", s.steal_percent},
+           {"total_usage_percent", s.total_usage_percent},
+           {"frequency_mhz", s.frequency_mhz},
+           {"core_throttle_events", s.core_throttle_events},
+           {"package_throttle_events", s.package_throttle_events},
+           {"idle_states", s.idle_states},
+           {"wakeups_per_sec", s.wakeups_per_sec},
+           {"runqueue_wait_ms_per_sec", s.runqueue_wait_ms_per_sec},
+           {"timeslices_per_sec", s.timeslices_per_sec},
+           {"sched_latency_us", s.sched_latency_us}};
 }
 void from_json(const json &j, CoreStats &s) {
   j.at("core_id").get_to(s.core_id);
+  s.cpu = j.value("cpu", size_t{0});
+  j.at("user_percent").get_to(s.user_percent);
+  j.at("nice_percent").get_to(s.nice_percent);
+  j.at("system_percent").get_to(s.system_percent);
+  j.at("iowait_percent").get_to(s.iowait_percent);
+  j.at("idle_percent").get_to(s.idle_percent);
+  j.at("total_usage_percent").get_to(s.total_usage_percent);
+  s.irq_percent = j.value("irq_percent", 0.0f);
+  s.softirq_percent = j.value("softirq_percent", 0.0f);
+  s.steal_percent = j.value("steal_percent", 0.0f);
+  s.frequency_mhz = j.value("frequency_mhz", 0.0);
+  s.core_throttle_events = j.value("core_throttle_events", 0ULL);
+  s.package_throttle_events = j.value("package_throttle_events", 0ULL);
+  s.idle_states = j.value("idle_states", std::vector<IdleStateResidency>{});
+  s.wakeups_per_sec = j.value("wakeups_per_sec", 0.0);
+  s.runqueue_wait_ms_per_sec = j.value("runqueue_wait_ms_per_sec", 0.0);
+  s.timeslices_per_sec = j.value("timeslices_per_sec", 0.0);
+  s.sched_latency_us = j.value("sched_latency_us", 0.0);
+}
+
+void to_json(json &j, const CpuGroupStats &s) {
+  j = json{{"id", s.id},
+           {"cpu_count", s.cpu_count},
+           {"user_percent", s.user_percent},
+           {"nice_percent", s.nice_percent},
+           {"system_percent", s.system_percent},
+           {"iowait_percent", s.iowait_percent},
+           {"idle_percent", s.idle_percent},
+           {"irq_percent", s.irq_percent},
+           {"softirq_percent", s.softirq_percent},
+           {"steal_percent", s.steal_percent},
+           {"total_usage_percent", s.total_usage_percent}};
+}
+void from_json(const json &j, CpuGroupStats &s) {
+  j.at("id").get_to(s.id);
+  j.at("cpu_count").get_to(s.cpu_count);
   j.at("user_percent").get_to(s.user_percent);
   j.at("nice_percent").get_to(s.nice_percent);
   j.at("system_percent").get_to(s.system_percent);
   j.at("iowait_percent").get_to(s.iowait_percent);
   j.at("idle_percent").get_to(s.idle_percent);
+  j.at("irq_percent").get_to(s.irq_percent);
+  j.at("softirq_percent").get_to(s.softirq_percent);
+  j.at("steal_percent").get_to(s.steal_percent);
   j.at("total_usage_percent").get_to(s.total_usage_percent);
 }
 
 // --- Network ---
 void to_json(json &j, const NetworkInterfaceStats &s) {
   j = json{{"interface_name", s.interface_name},
+           {"ip_address", s.ip_address},
+           {"ipv6_addresses", s.ipv6_addresses},
            {"rx_bytes_per_sec", s.rx_bytes_per_sec},
-           {"tx_bytes_per_sec", s.tx_bytes_per_sec}};
+           {"tx_bytes_per_sec", s.tx_bytes_per_sec},
+           {"rx_packets_per_sec", s.rx_packets_per_sec},
+           {"tx_packets_per_sec", s.tx_packets_per_sec},
+           {"rx_errors_per_sec", s.rx_errors_per_sec},
+           {"tx_errors_per_sec", s.tx_errors_per_sec},
+           {"rx_dropped_per_sec", s.rx_dropped_per_sec},
+           {"tx_dropped_per_sec", s.tx_dropped_per_sec},
+           {"rx_fifo_per_sec", s.rx_fifo_per_sec},
+           {"tx_fifo_per_sec", s.tx_fifo_per_sec},
+           {"rx_frame_per_sec", s.rx_frame_per_sec},
+           {"rx_compressed_per_sec", s.rx_compressed_per_sec},
+           {"tx_compressed_per_sec", s.tx_compressed_per_sec},
+           {"multicast_per_sec", s.multicast_per_sec},
+           {"collisions_per_sec", s.collisions_per_sec},
+           {"carrier_per_sec", s.carrier_per_sec},
+           {"aggregated_interfaces", s.aggregated_interfaces}};
 }
 void from_json(const json &j, NetworkInterfaceStats &s) {
   j.at("interface_name").get_to(s.interface_name);
+  s.ip_address = j.value("ip_address", "");
+  s.ipv6_addresses = j.value("ipv6_addresses", std::vector<std::string>{});
   j.at("rx_bytes_per_sec").get_to(s.rx_bytes_per_sec);
   j.at("tx_bytes_per_sec").get_to(s.tx_bytes_per_sec);
+  s.rx_packets_per_sec = j.value("rx_packets_per_sec", 0.0);
+  s.tx_packets_per_sec = j.value("tx_packets_per_sec", 0.0);
+  s.rx_errors_per_sec = j.value("rx_errors_per_sec", 0.0);
+  s.tx_errors_per_sec = j.value("tx_errors_per_sec", 0.0);
+  s.rx_dropped_per_sec = j.value("rx_dropped_per_sec", 0.0);
+  s.tx_dropped_per_sec = j.value("tx_dropped_per_sec", 0.0);
+  s.rx_fifo_per_sec = j.value("rx_fifo_per_sec", 0.0);
+  s.tx_fifo_per_sec = j.value("tx_fifo_per_sec", 0.0);
+  s.rx_frame_per_sec = j.value("rx_frame_per_sec", 0.0);
+  s.rx_compressed_per_sec = j.value("rx_compressed_per_sec", 0.0);
+  s.tx_compressed_per_sec = j.value("tx_compressed_per_sec", 0.0);
+  s.multicast_per_sec = j.value("multicast_per_sec", 0.0);
+  s.collisions_per_sec = j.value("collisions_per_sec", 0.0);
+  s.carrier_per_sec = j.value("carrier_per_sec", 0.0);
+  s.aggregated_interfaces = j.value("aggregated_interfaces", 0u);
 }
 
 // --- Memory ---
@@ -136,37 +281,195 @@ void from_json(const json &j, MemInfo &s) {
   j.at("percent").get_to(s.percent);
 }
 
+// Keyed by the /proc/meminfo label
+void to_json(json &j, const MemInfoFields &s) {
+  j = json::object();
+  for (size_t i = 0; i < MEMINFO_FIELD_COUNT; ++i)
+    j[meminfo_field_name(static_cast<MemInfoField>(i))] = s.values[i];
+}
+void from_json(const json &j, MemInfoFields &s) {
+  s.values.fill(0);
+  for (const auto &[label, value] : j.items()) {
+    MemInfoField field;
+    if (meminfo_field_from_name(label, field))
+      s.values[static_cast<size_t>(field)] = value.get<unsigned long long>();
+  }
+}
+
+void to_json(json &j, const NumaNodeMemory &s) {
+  j = json{{"node", s.node},
+           {"total_kb", s.total_kb},
+           {"used_kb", s.used_kb},
+           {"free_kb", s.free_kb},
+           {"file_kb", s.file_kb},
+           {"percent", s.percent},
+           {"numa_miss_per_sec", s.numa_miss_per_sec},
+           {"numa_foreign_per_sec", s.numa_foreign_per_sec}};
+}
+void from_json(const json &j, NumaNodeMemory &s) {
+  j.at("node").get_to(s.node);
+  j.at("total_kb").get_to(s.total_kb);
+  j.at("used_kb").get_to(s.used_kb);
+  j.at("free_kb").get_to(s.free_kb);
+  j.at("file_kb").get_to(s.file_kb);
+  j.at("percent").get_to(s.percent);
+  j.at("numa_miss_per_sec").get_to(s.numa_miss_per_sec);
+  j.at("numa_foreign_per_sec").get_to(s.numa_foreign_per_sec);
+}
+
+// --- Vmstat ---
+void to_json(json &j, const VmstatRate &s) {
+  j = json{{"name", s.name}, {"per_sec", s.per_sec}};
+}
+void from_json(const json &j, VmstatRate &s) {
+  j.at("name").get_to(s.name);
+  j.at("per_sec").get_to(s.per_sec);
+}
+
+// --- Memory Fragmentation ---
+void to_json(json &j, const MigrateTypeFree &s) {
+  j = json{{"type", s.type}, {"free_pages", s.free_pages}};
+}
+void from_json(const json &j, MigrateTypeFree &s) {
+  j.at("type").get_to(s.type);
+  j.at("free_pages").get_to(s.free_pages);
+}
+
+void to_json(json &j, const ZoneFragmentation &s) {
+  j = json{{"node", s.node},
+           {"zone", s.zone},
+           {"fragmentation_index", s.fragmentation_index},
+           {"free_pages", s.free_pages},
+           {"free_pages_by_order", s.free_pages_by_order}};
+  if (!s.migrate_types.empty())
+    j["migrate_types"] = s.migrate_types;
+}
+void from_json(const json &j, ZoneFragmentation &s) {
+  j.at("node").get_to(s.node);
+  j.at("zone").get_to(s.zone);
+  j.at("fragmentation_index").get_to(s.fragmentation_index);
+  j.at("free_pages").get_to(s.free_pages);
+  j.at("free_pages_by_order").get_to(s.free_pages_by_order);
+  s.migrate_types = j.value("migrate_types", std::vector<MigrateTypeFree>{});
+}
+
+// --- Interrupts ---
+void to_json(json &j, const InterruptRate &s) {
+  j = json{{"name", s.name},
+           {"description", s.description},
+           {"per_sec", s.per_sec},
+           {"per_cpu", s.per_cpu}};
+}
+void from_json(const json &j, InterruptRate &s) {
+  j.at("name").get_to(s.name);
+  j.at("description").get_to(s.description);
+  j.at("per_sec").get_to(s.per_sec);
+  j.at("per_cpu").get_to(s.per_cpu);
+}
+
+// --- Cgroups ---
+void to_json(json &j, const CgroupStats &s) {
+  j = json{{"path", s.path},
+           {"cpu_percent", s.cpu_percent},
+           {"cpu_throttled_ms_per_sec", s.cpu_throttled_ms_per_sec},
+           {"memory_kb", s.memory_kb},
+           {"io_read_bytes_per_sec", s.io_read_bytes_per_sec},
+           {"io_write_bytes_per_sec", s.io_write_bytes_per_sec},
+           {"memory_pressure",
+            {{"some", s.memory_pressure.some},
+             {"full", s.memory_pressure.full}}}};
+}
+void from_json(const json &j, CgroupStats &s) {
+  j.at("path").get_to(s.path);
+  j.at("cpu_percent").get_to(s.cpu_percent);
+  j.at("cpu_throttled_ms_per_sec").get_to(s.cpu_throttled_ms_per_sec);
+  j.at("memory_kb").get_to(s.memory_kb);
+  j.at("io_read_bytes_per_sec").get_to(s.io_read_bytes_per_sec);
+  j.at("io_write_bytes_per_sec").get_to(s.io_write_bytes_per_sec);
+  const auto &pressure = j.at("memory_pressure");
+  pressure.at("some").get_to(s.memory_pressure.some);
+  pressure.at("full").get_to(s.memory_pressure.full);
+}
+
 // --- ProcessInfo ---
 void to_json(json &j, const ProcessInfo &p) {
   j = json{{"pid", p.pid},
            {"vmRssKb", p.vmRssKb},
-           {"cpu_percent", p.cpu_percent},
-           {"mem_percent", p.mem_percent},
-           {"name", p.name},
+           {"cpu_percent", p.cpu_percent()},
+           {"mem_percent", p.mem_percent()},
+           {"name", std::string(p.name)},
            {"open_fds", p.open_fds},
            {"io_read_bytes", p.io_read_bytes},
-           {"io_write_bytes", p.io_write_bytes}};
+           {"io_write_bytes", p.io_write_bytes},
+           {"pss_kb", p.pss_kb},
+           {"uss_kb", p.uss_kb},
+           {"swap_kb", p.swap_kb}};
 }
 void from_json(const json &j, ProcessInfo &p) {
   j.at("pid").get_to(p.pid);
   j.at("vmRssKb").get_to(p.vmRssKb);
-  j.at("cpu_percent").get_to(p.cpu_percent);
-  j.at("mem_percent").get_to(p.mem_percent);
-  j.at("name").get_to(p.name);
+  p.set_cpu_percent(j.at("cpu_percent").get<double>());
+  p.set_mem_percent(j.at("mem_percent").get<double>());
+  p.set_name(j.at("name").get<std::string>());
   j.at("open_fds").get_to(p.open_fds);
   j.at("io_read_bytes").get_to(p.io_read_bytes);
   j.at("io_write_bytes").get_to(p.io_write_bytes);
+  p.pss_kb = j.value("pss_kb", 0u);
+  p.uss_kb = j.value("uss_kb", 0u);
+  p.swap_kb = j.value("swap_kb", 0u);
+}
+
+void to_json(json &j, const ProcessListView &v) {
+  j = json::array();
+  for (size_t i = 0; i < v.size(); ++i) {
+    json process = v[i];
+    const ProcessCgroup *cgroup = v.cgroup(i);
+    if (cgroup != nullptr && !cgroup->path.empty()) {
+      process["cgroup"] = cgroup->path;
+      process["unit"] = cgroup->unit;
+    }
+    j.push_back(std::move(process));
+  }
+}
+
+// Appends the records in a JSON process list to the shared record array and
+// points the index list at them.
+static void process_list_from_json(const json &j, SystemMetrics &s,
+                                   ProcessIndexList &list) {
+  list.clear();
+  for (const auto &item : j) {
+    list.push_back(static_cast<uint32_t>(s.process_records.size()));
+    s.process_records.push_back(item.get<ProcessInfo>());
+    s.process_cgroups.push_back({item.value("cgroup", std::string()),
+                                 item.value("unit", std::string())});
+  }
 }
 
 // System Metrics
 void to_json(json &j, const SystemMetrics &s) {
   j = json{
       {"cores", s.cores},
+      {"cpu_packages", s.cpu_packages},
+      {"cpu_physical_cores", s.cpu_physical_cores},
+      {"numa_nodes", s.numa_nodes},
       {"cpu_frequency_ghz", s.cpu_frequency_ghz},
       {"cpu_temp_c", s.cpu_temp_c},
+      {"sensors", s.sensors},
       {"meminfo", s.meminfo},
       {"stability", s.stability},
+      {"vmstat", s.vmstat},
+      {"memory_zones", s.memory_zones},
+      {"compaction", s.compaction},
+      {"interrupt_cpus", s.interrupt_cpus},
+      {"interrupts", s.interrupts},
+      {"softirq_cpus", s.softirq_cpus},
+      {"softirqs", s.softirqs},
+      {"top_cgroups_cpu", s.top_cgroups_cpu},
+      {"top_cgroups_mem", s.top_cgroups_mem},
+      {"top_cgroups_io", s.top_cgroups_io},
       {"swapinfo", s.swapinfo},
+      {"numa_memory", s.numa_memory},
+      {"meminfo_fields", s.meminfo_fields},
       {"disks", s.disks},
       {"uptime", s.uptime},
       {"load_avg_1m", s.load_avg_1m},
@@ -179,27 +482,39 @@ void to_json(json &j, const SystemMetrics &s) {
       {"kernel_release", s.kernel_release},
       {"machine_type", s.machine_type},
       {"network_interfaces", s.network_interfaces},
-      {"top_processes_avg_mem", s.top_processes_avg_mem},
-      {"top_processes_avg_cpu", s.top_processes_avg_cpu},
-      {"top_processes_real_mem", s.top_processes_real_mem},
-      {"top_processes_real_cpu", s.top_processes_real_cpu},
+      {"top_processes_avg_mem", s.processes(s.top_processes_avg_mem)},
+      {"top_processes_avg_cpu", s.processes(s.top_processes_avg_cpu)},
+      {"top_processes_real_mem", s.processes(s.top_processes_real_mem)},
+      {"top_processes_real_cpu", s.processes(s.top_processes_real_cpu)},
       // Note: polling_tasks is intentionally omitted
   };
-  j["disk_io"] = json::array();
-  for (const auto &pair : s.disk_io) {
-    SPDLOG_TRACE("Serializing {}", pair.second.device_name);
-    j["disk_io"].push_back(
-        pair.second); // pair.second is the DiskIoStats object
-  }
+  j["disk_io"] = s.disk_io;
 }
 
 void from_json(const json &j, SystemMetrics &s) {
   j.at("cores").get_to(s.cores);
+  s.cpu_packages = j.value("cpu_packages", std::vector<CpuGroupStats>{});
+  s.cpu_physical_cores =
+      j.value("cpu_physical_cores", std::vector<CpuGroupStats>{});
+  s.numa_nodes = j.value("numa_nodes", std::vector<CpuGroupStats>{});
   j.at("cpu_frequency_ghz").get_to(s.cpu_frequency_ghz);
   j.at("cpu_temp_c").get_to(s.cpu_temp_c);
+  s.sensors = j.value("sensors", std::vector<SensorReading>{});
   j.at("meminfo").get_to(s.meminfo);
   j.at("stability").get_to(s.stability);
+  s.vmstat = j.value("vmstat", std::vector<VmstatRate>{});
+  s.memory_zones = j.value("memory_zones", std::vector<ZoneFragmentation>{});
+  s.compaction = j.value("compaction", std::vector<VmstatRate>{});
+  s.interrupt_cpus = j.value("interrupt_cpus", std::vector<size_t>{});
+  s.interrupts = j.value("interrupts", std::vector<InterruptRate>{});
+  s.softirq_cpus = j.value("softirq_cpus", std::vector<size_t>{});
+  s.softirqs = j.value("softirqs", std::vector<InterruptRate>{});
+  s.top_cgroups_cpu = j.value("top_cgroups_cpu", std::vector<CgroupStats>{});
+  s.top_cgroups_mem = j.value("top_cgroups_mem", std::vector<CgroupStats>{});
+  s.top_cgroups_io = j.value("top_cgroups_io", std::vector<CgroupStats>{});
   j.at("swapinfo").get_to(s.swapinfo);
+  s.numa_memory = j.value("numa_memory", std::vector<NumaNodeMemory>{});
+  s.meminfo_fields = j.value("meminfo_fields", MemInfoFields{});
   j.at("disks").get_to(s.disks);
   j.at("uptime").get_to(s.uptime);
   j.at("load_avg_1m").get_to(s.load_avg_1m);
@@ -212,23 +527,52 @@ void from_json(const json &j, SystemMetrics &s) {
   j.at("kernel_release").get_to(s.kernel_release);
   j.at("machine_type").get_to(s.machine_type);
   j.at("network_interfaces").get_to(s.network_interfaces);
-  j.at("top_processes_avg_mem").get_to(s.top_processes_avg_mem);
-  j.at("top_processes_avg_cpu").get_to(s.top_processes_avg_cpu);
-  j.at("top_processes_real_mem").get_to(s.top_processes_real_mem);
-  j.at("top_processes_real_cpu").get_to(s.top_processes_real_cpu);
+  s.process_records.clear();
+  s.process_cgroups.clear();
+  process_list_from_json(j.at("top_processes_avg_mem"), s,
+                         s.top_processes_avg_mem);
+  process_list_from_json(j.at("top_processes_avg_cpu"), s,
+                         s.top_processes_avg_cpu);
+  process_list_from_json(j.at("top_processes_real_mem"), s,
+                         s.top_processes_real_mem);
+  process_list_from_json(j.at("top_processes_real_cpu"), s,
+                         s.top_processes_real_cpu);
   j.at("disk_io").get_to(s.disk_io);
   // Note: polling_tasks is intentionally omitted
 }
 
+void to_json(json &j, const PsiLine &s) {
+  j = json{{"avg10", s.avg10},
+           {"avg60", s.avg60},
+           {"avg300", s.avg300},
+           {"total_us", s.total_us},
+           {"stall_us_per_sec", s.stall_us_per_sec}};
+}
+void from_json(const json &j, PsiLine &s) {
+  j.at("avg10").get_to(s.avg10);
+  j.at("avg60").get_to(s.avg60);
+  j.at("avg300").get_to(s.avg300);
+  j.at("total_us").get_to(s.total_us);
+  j.at("stall_us_per_sec").get_to(s.stall_us_per_sec);
+}
+
 void to_json(json &j, const SystemStability &s) {
+  // "pressure" keeps the avg10 headline numbers; "psi" has every field
+  json pressure = json::object();
+  json psi = json::object();
+  for (size_t i = 0; i < PSI_KIND_COUNT; ++i) {
+    const char *kind = psi_kind_name(static_cast<PsiKind>(i));
+    const PsiResource &resource = s.pressure[i];
+    pressure[kind] = {{"some", resource.some.avg10},
+                      {"full", resource.full.avg10}};
+    psi[kind] = {{"some", resource.some}, {"full", resource.full}};
+  }
   j = json{
       {"file_descriptors",
        {{"allocated", s.file_descriptors_allocated},
         {"max", s.file_descriptors_max}}},
-      {"pressure",
-       {{"memory",
-         {{"some", s.memory_pressure_some}, {"full", s.memory_pressure_full}}},
-        {"io", {{"some", s.io_pressure_some}, {"full", s.io_pressure_full}}}}},
+      {"pressure", std::move(pressure)},
+      {"psi", std::move(psi)},
       {"memory_fragmentation_index", s.memory_fragmentation_index}};
 }
 
@@ -240,20 +584,18 @@ void from_json(const json &j, SystemStability &s) {
     fd.at("max").get_to(s.file_descriptors_max);
   }
 
-  // Parsing nested pressure
-  if (j.contains("pressure")) {
-    const auto &pr = j.at("pressure");
-
-    if (pr.contains("memory")) {
-      const auto &mem = pr.at("memory");
-      mem.at("some").get_to(s.memory_pressure_some);
-      mem.at("full").get_to(s.memory_pressure_full);
-    }
-
-    if (pr.contains("io")) {
-      const auto &io = pr.at("io");
-      io.at("some").get_to(s.io_pressure_some);
-      io.at("full").get_to(s.io_pressure_full);
+  // Parsing nested pressure; "psi" is absent in older output
+  for (size_t i = 0; i < PSI_KIND_COUNT; ++i) {
+    const char *kind = psi_kind_name(static_cast<PsiKind>(i));
+    PsiResource &resource = s.pressure[i];
+    if (j.contains("psi") && j.at("psi").contains(kind)) {
+      const auto &psi = j.at("psi").at(kind);
+      psi.at("some").get_to(resource.some);
+      psi.at("full").get_to(resource.full);
+    } else if (j.contains("pressure") && j.at("pressure").contains(kind)) {
+      const auto &pr = j.at("pressure").at(kind);
+      pr.at("some").get_to(resource.some.avg10);
+      pr.at("full").get_to(resource.full.avg10);
     }
   }
 
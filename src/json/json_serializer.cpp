@@ -6,9 +6,12 @@
 #include <vector>
 
 #include "batteryinfo.hpp"
+#include "cgroups.hpp"
 #include "corestat.hpp"
 #include "diskstat.hpp"
 #include "filesystems.hpp"
+#include "frag_stats.hpp"
+#include "interrupts.hpp"
 #include "json_definitions.hpp"
 #include "log.hpp"
 #include "meminfo.hpp"
@@ -17,7 +20,9 @@
 #include "networkstats.hpp"
 #include "processinfo.hpp"
 #include "stream_provider.hpp"
+#include "system_stability.hpp"
 #include "uptime.hpp"
+#include "vmstat.hpp"
 
 namespace telemetry {
 
@@ -58,9 +63,18 @@ JsonSerializer::JsonSerializer(const MetricSettings &settings) {
   }
 
   if (settings.features.enable_memory) {
-    pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
+    // Resolved once; the lambda only indexes the parsed array
+    std::vector<MemInfoField> fields =
+        select_meminfo_fields(settings.memory.fields);
+    pipeline.emplace_back([fields](nlohmann::json &j,
+                                   const SystemMetrics &s) {
       j["meminfo"] = s.meminfo;
       j["swapinfo"] = s.swapinfo;
+      j["numa_memory"] = s.numa_memory;
+      nlohmann::json &selected = j["meminfo_fields"];
+      selected = nlohmann::json::object();
+      for (MemInfoField field : fields)
+        selected[meminfo_field_name(field)] = s.meminfo_fields[field];
     });
   }
 
@@ -70,41 +84,73 @@ JsonSerializer::JsonSerializer(const MetricSettings &settings) {
     });
   }
 
+  if (settings.features.enable_sensors) {
+    pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
+      j["sensors"] = s.sensors;
+    });
+  }
+
   if (settings.features.enable_cpuinfo) {
     pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
       j["cores"] = s.cores;
+      j["cpu_packages"] = s.cpu_packages;
+      j["cpu_physical_cores"] = s.cpu_physical_cores;
+      j["numa_nodes"] = s.numa_nodes;
     });
   }
 
   if (settings.features.enable_diskstat) {
     pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
       j["disks"] = s.disks;
-      j["disk_io"] = nlohmann::json::array();
-      for (const auto &pair : s.disk_io) {
-        j["disk_io"].push_back(pair.second);
-      }
+      j["disk_io"] = s.disk_io;
+    });
+  }
+
+  if (settings.features.enable_interrupts) {
+    pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
+      j["interrupt_cpus"] = s.interrupt_cpus;
+      j["interrupts"] = s.interrupts;
+      j["softirq_cpus"] = s.softirq_cpus;
+      j["softirqs"] = s.softirqs;
+    });
+  }
+
+  if (settings.features.enable_cgroups) {
+    pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
+      j["top_cgroups_cpu"] = s.top_cgroups_cpu;
+      j["top_cgroups_mem"] = s.top_cgroups_mem;
+      j["top_cgroups_io"] = s.top_cgroups_io;
+    });
+  }
+
+  if (settings.features.enable_stability_info) {
+    pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
+      j["stability"] = s.stability;
+      j["vmstat"] = s.vmstat;
+      j["memory_zones"] = s.memory_zones;
+      j["compaction"] = s.compaction;
     });
   }
 
   // 3. Process Lists
   if (settings.features.processes.enable_avg_cpu) {
     pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
-      j["top_processes_avg_cpu"] = s.top_processes_avg_cpu;
+      j["top_processes_avg_cpu"] = s.processes(s.top_processes_avg_cpu);
     });
   }
   if (settings.features.processes.enable_realtime_cpu) {
     pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
-      j["top_processes_real_cpu"] = s.top_processes_real_cpu;
+      j["top_processes_real_cpu"] = s.processes(s.top_processes_real_cpu);
     });
   }
   if (settings.features.processes.enable_avg_mem) {
     pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
-      j["top_processes_avg_mem"] = s.top_processes_avg_mem;
+      j["top_processes_avg_mem"] = s.processes(s.top_processes_avg_mem);
     });
   }
   if (settings.features.processes.enable_realtime_mem) {
     pipeline.emplace_back([](nlohmann::json &j, const SystemMetrics &s) {
-      j["top_processes_real_mem"] = s.top_processes_real_mem;
+      j["top_processes_real_mem"] = s.processes(s.top_processes_real_mem);
     });
   }
 }
@@ -0,0 +1,472 @@
+// cgroups.cpp
+#include "cgroups.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <numeric>
+
+#include "context.hpp"
+#include "log.hpp"
+#include "lua_generator.hpp"
+#include "polling.hpp"
+
+namespace telemetry {
+
+namespace {
+
+constexpr uint32_t CGROUP_WATCH_MASK =
+    IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+constexpr int CGROUP_DIR_FLAGS = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+
+std::string_view base_name(const std::string &path) {
+  return std::string_view(path).substr(path.rfind('/') + 1);
+}
+
+// Subdirectories of path relative to dirfd, sorted; cgroupfs always fills
+// in d_type
+bool list_subdirectories(int dirfd, const char *path,
+                         std::vector<std::string> &names) {
+  int fd = ::openat(dirfd, path, CGROUP_DIR_FLAGS);
+  if (fd < 0)
+    return false;
+  DIR *dir = ::fdopendir(fd);
+  if (dir == nullptr) {
+    ::close(fd);
+    return false;
+  }
+  names.clear();
+  while (const dirent *entry = ::readdir(dir)) {
+    if (std::strcmp(entry->d_name, ".") == 0 ||
+        std::strcmp(entry->d_name, "..") == 0)
+      continue;
+    bool is_dir = entry->d_type == DT_DIR;
+    if (entry->d_type == DT_UNKNOWN) {
+      struct stat st;
+      is_dir = ::fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 &&
+               S_ISDIR(st.st_mode);
+    }
+    if (is_dir)
+      names.emplace_back(entry->d_name);
+  }
+  ::closedir(dir);
+  std::sort(names.begin(), names.end());
+  return true;
+}
+
+} // namespace
+
+CgroupTree::~CgroupTree() { close(); }
+
+bool CgroupTree::open(const std::string &root, size_t max_dirfds) {
+  close();
+  dirfd_limit = max_dirfds;
+  if (dirfd_limit == 0) {
+    // Leave the other half for the rest of the daemon
+    rlimit limit{};
+    dirfd_limit = ::getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+                          limit.rlim_cur != RLIM_INFINITY
+                      ? limit.rlim_cur / 2
+                      : 512;
+  }
+  int fd = ::open(root.c_str(), CGROUP_DIR_FLAGS);
+  if (fd < 0)
+    return false;
+  ++held_dirfds;
+  root_path = root;
+  inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd < 0)
+    SPDLOG_WARN("Cgroups: inotify unavailable, rescanning every tick");
+  scan(add(NO_PARENT, fd, ""));
+  SPDLOG_DEBUG("Cgroups: tracking {} cgroups under {}", size(), root);
+  return true;
+}
+
+void CgroupTree::close() {
+  for (const Node &node : slots) {
+    if (node.id != 0 && node.dirfd >= 0)
+      ::close(node.dirfd);
+  }
+  if (inotify_fd >= 0)
+    ::close(inotify_fd);
+  inotify_fd = -1;
+  unwatched = false;
+  held_dirfds = 0;
+  retry.clear();
+  slots.clear();
+  free_slots.clear();
+  watches.clear();
+  dirty.clear();
+}
+
+size_t CgroupTree::add(size_t parent, int dirfd, std::string path) {
+  size_t index;
+  if (free_slots.empty()) {
+    index = slots.size();
+    slots.emplace_back();
+  } else {
+    index = free_slots.back();
+    free_slots.pop_back();
+  }
+
+  Node &node = slots[index];
+  node.id = next_id++;
+  node.path = std::move(path);
+  node.dirfd = dirfd;
+  node.parent = parent;
+  node.children.clear();
+  node.watch = -1;
+  if (inotify_fd >= 0) {
+    // Watches are keyed by path; the dirfd only saves the lookups on reads
+    std::string full_path = root_path + node.path;
+    node.watch =
+        ::inotify_add_watch(inotify_fd, full_path.c_str(), CGROUP_WATCH_MASK);
+    if (node.watch >= 0) {
+      watches[node.watch] = index;
+    } else if (!unwatched) {
+      SPDLOG_WARN("Cgroups: cannot watch {} ({}), rescanning every tick",
+                  full_path, std::strerror(errno));
+      unwatched = true;
+    }
+  }
+  if (parent != NO_PARENT)
+    slots[parent].children.push_back(index);
+  return index;
+}
+
+// Frees the node and its subtree; the parent's child list is left alone
+void CgroupTree::remove(size_t index) {
+  for (size_t child : slots[index].children)
+    remove(child);
+  Node &node = slots[index];
+  if (node.watch >= 0) {
+    ::inotify_rm_watch(inotify_fd, node.watch);
+    watches.erase(node.watch);
+  }
+  if (node.dirfd >= 0) {
+    ::close(node.dirfd);
+    --held_dirfds;
+  }
+  node = Node();
+  free_slots.push_back(index);
+}
+
+// Opens a new child's directory, or returns -1 with errno = 0 when it
+// should be tracked by path because the descriptor budget is spent
+int CgroupTree::open_child(size_t parent, const std::string &name) {
+  errno = 0;
+  if (held_dirfds >= dirfd_limit)
+    return -1;
+  const Node &node = slots[parent];
+  int fd = node.dirfd >= 0
+               ? ::openat(node.dirfd, name.c_str(), CGROUP_DIR_FLAGS)
+               : ::open((root_path + node.path + "/" + name).c_str(),
+                        CGROUP_DIR_FLAGS);
+  if (fd >= 0) {
+    if (++held_dirfds == dirfd_limit)
+      SPDLOG_INFO("Cgroups: holding {} directory fds, opening further "
+                  "cgroups by path",
+                  held_dirfds);
+    return fd;
+  }
+  if (errno == EMFILE || errno == ENFILE) {
+    SPDLOG_WARN("Cgroups: out of file descriptors after {} directories, "
+                "opening further cgroups by path",
+                held_dirfds);
+    dirfd_limit = held_dirfds;
+    errno = 0;
+  }
+  return -1;
+}
+
+// Brings the children of one directory in line with the filesystem
+bool CgroupTree::scan(size_t index) {
+  std::vector<std::string> names;
+  bool listed = slots[index].dirfd >= 0
+                    ? list_subdirectories(slots[index].dirfd, ".", names)
+                    : list_subdirectories(
+                          AT_FDCWD, (root_path + slots[index].path).c_str(),
+                          names);
+  if (!listed) {
+    // No watch event will come back for it, so list it again next tick
+    if (errno == EMFILE || errno == ENFILE)
+      retry.emplace_back(index, slots[index].id);
+    return false;
+  }
+
+  bool changed = false;
+  std::vector<bool> known(names.size(), false);
+  std::vector<size_t> &children = slots[index].children;
+  for (size_t i = 0; i < children.size();) {
+    std::string_view name = base_name(slots[children[i]].path);
+    auto it = std::lower_bound(names.begin(), names.end(), name);
+    if (it != names.end() && *it == name) {
+      known[it - names.begin()] = true;
+      ++i;
+      continue;
+    }
+    remove(children[i]);
+    children[i] = children.back();
+    children.pop_back();
+    changed = true;
+  }
+
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (known[i])
+      continue;
+    int fd = open_child(index, names[i]);
+    if (fd < 0 && errno != 0)
+      continue; // Removed again before we got to it
+    size_t child = add(index, fd, slots[index].path + "/" + names[i]);
+    scan(child);
+    changed = true;
+  }
+  return changed;
+}
+
+void CgroupTree::read_events() {
+  alignas(inotify_event) char events[4096];
+  for (;;) {
+    ssize_t length = ::read(inotify_fd, events, sizeof(events));
+    if (length <= 0)
+      break;
+    for (char *pos = events; pos < events + length;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(pos);
+      pos += sizeof(inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were dropped; every directory has to be checked
+        for (size_t i = 0; i < slots.size(); ++i) {
+          if (slots[i].id != 0)
+            dirty.emplace_back(i, slots[i].id);
+        }
+        continue;
+      }
+      if ((event->mask & IN_ISDIR) == 0)
+        continue;
+      auto it = watches.find(event->wd);
+      if (it != watches.end())
+        dirty.emplace_back(it->second, slots[it->second].id);
+    }
+  }
+}
+
+bool CgroupTree::refresh() {
+  if (slots.empty())
+    return false;
+  if (inotify_fd < 0 || unwatched) {
+    for (size_t i = 0; i < slots.size(); ++i) {
+      if (slots[i].id != 0)
+        dirty.emplace_back(i, slots[i].id);
+    }
+  } else {
+    read_events();
+  }
+  dirty.insert(dirty.end(), retry.begin(), retry.end());
+  retry.clear();
+
+  bool changed = false;
+  for (const auto &[index, id] : dirty) {
+    // Skip directories freed (or reused) by an earlier scan
+    if (slots[index].id == id)
+      changed |= scan(index);
+  }
+  dirty.clear();
+  return changed;
+}
+
+void parse_cgroup_cpu_stat(std::string_view text, CgroupSample &sample) {
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string_view::npos)
+      end = text.size();
+    std::string_view line = text.substr(start, end - start);
+    size_t space = line.find(' ');
+    if (space != std::string_view::npos) {
+      std::string_view key = line.substr(0, space);
+      unsigned long long *target = nullptr;
+      if (key == "usage_usec")
+        target = &sample.usage_usec;
+      else if (key == "throttled_usec")
+        target = &sample.throttled_usec;
+      if (target != nullptr)
+        std::from_chars(line.data() + space + 1, line.data() + line.size(),
+                        *target);
+    }
+    start = end + 1;
+  }
+}
+
+void parse_cgroup_io_stat(std::string_view text, CgroupSample &sample) {
+  const char *pos = text.data();
+  const char *end = pos + text.size();
+  while (pos < end) {
+    const char *equals =
+        static_cast<const char *>(std::memchr(pos, '=', end - pos));
+    if (equals == nullptr)
+      break;
+    const char *key = equals;
+    while (key > pos && key[-1] != ' ' && key[-1] != '\n')
+      --key;
+    std::string_view name(key, equals - key);
+    unsigned long long value = 0;
+    auto result = std::from_chars(equals + 1, end, value);
+    if (name == "rbytes")
+      sample.io_read_bytes += value;
+    else if (name == "wbytes")
+      sample.io_write_bytes += value;
+    pos = result.ptr > equals ? result.ptr : equals + 1;
+  }
+}
+
+std::string LuaCgroups::serialize(unsigned indentation_level) const {
+  LuaConfigGenerator gen("cgroups", indentation_level);
+  gen.lua_string("root", root);
+  gen.lua_uint("top_k", top_k);
+  return gen.str();
+}
+
+void LuaCgroups::deserialize(sol::table cgroups) {
+  if (!cgroups.valid())
+    return;
+  root = cgroups.get_or("root", root);
+  top_k = cgroups.get_or("top_k", top_k);
+}
+
+CgroupPollingTask::CgroupPollingTask(DataStreamProvider &provider,
+                                     SystemMetrics &metrics,
+                                     MetricsContext &context)
+    : IPollingTask(provider, metrics, context),
+      top_k(context.settings.cgroups.top_k) {
+  name = "Cgroup polling";
+  if (context.provider != DataStreamProviders::LocalDataStream)
+    return;
+
+  const std::string &root = context.settings.cgroups.root;
+  // A v1 (or hybrid) mount has no cgroup.controllers at the top
+  if (::access((root + "/cgroup.controllers").c_str(), R_OK) != 0) {
+    SPDLOG_WARN("Cgroups: {} is not a cgroup v2 hierarchy", root);
+    return;
+  }
+  if (!tree.open(root))
+    SPDLOG_WARN("Cgroups: cannot open {}", root);
+}
+
+void CgroupPollingTask::read_sample(const CgroupTree::Node &node,
+                                    CgroupSample &sample) {
+  sample = CgroupSample();
+  sample.id = node.id;
+  auto open = [&](const char *name) {
+    if (node.dirfd >= 0)
+      return file.open_at(node.dirfd, name);
+    path_buffer.assign(tree.root()).append(node.path).append("/").append(
+        name);
+    return file.open(path_buffer);
+  };
+  // Controllers that are not enabled for the cgroup just lack the file
+  if (open("cpu.stat") && file.read(buffer))
+    parse_cgroup_cpu_stat(buffer, sample);
+  if (open("memory.current"))
+    file.read_counter(buffer, sample.memory_bytes);
+  if (open("memory.pressure") && file.read(buffer))
+    parse_psi(buffer, sample.memory_pressure);
+  if (open("io.stat") && file.read(buffer))
+    parse_cgroup_io_stat(buffer, sample);
+  file.close();
+}
+
+void CgroupPollingTask::read_samples(std::vector<CgroupSample> &samples) {
+  const auto &nodes = tree.nodes();
+  samples.resize(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    // The root cgroup is the whole system, reported elsewhere
+    if (nodes[i].id == 0 || nodes[i].parent == CgroupTree::NO_PARENT)
+      samples[i] = CgroupSample();
+    else
+      read_sample(nodes[i], samples[i]);
+  }
+}
+
+void CgroupPollingTask::take_initial_snapshot() {
+  set_timestamp();
+  read_samples(prev_samples);
+}
+
+void CgroupPollingTask::take_new_snapshot() {
+  set_delta_time();
+  tree.refresh();
+  read_samples(current_samples);
+}
+
+template <typename Key>
+void CgroupPollingTask::select_top(std::vector<CgroupStats> &dest, Key key) {
+  order.resize(stats.size());
+  std::iota(order.begin(), order.end(), 0);
+  size_t count = top_k == 0 ? order.size()
+                            : std::min<size_t>(top_k, order.size());
+  std::partial_sort(order.begin(), order.begin() + count, order.end(),
+                    [&](uint32_t a, uint32_t b) {
+                      return key(stats[a]) > key(stats[b]);
+                    });
+  dest.resize(count);
+  for (size_t i = 0; i < count; ++i)
+    dest[i] = stats[order[i]];
+}
+
+void CgroupPollingTask::calculate() {
+  const auto &nodes = tree.nodes();
+  double seconds = time_delta_seconds;
+  size_t count = 0;
+  for (size_t i = 0; i < current_samples.size(); ++i) {
+    const CgroupSample &curr = current_samples[i];
+    if (curr.id == 0)
+      continue;
+    // A new cgroup (or a reused slot) has no previous values yet
+    bool have_prev = i < prev_samples.size() && prev_samples[i].id == curr.id &&
+                     seconds > 0.0;
+    const CgroupSample &prev = have_prev ? prev_samples[i] : curr;
+    auto rate = [&](unsigned long long before, unsigned long long after) {
+      return have_prev ? counter_delta(after, before) / seconds : 0.0;
+    };
+
+    if (count == stats.size())
+      stats.emplace_back();
+    CgroupStats &cgroup = stats[count++];
+    if (cgroup.path != nodes[i].path)
+      cgroup.path = nodes[i].path;
+    cgroup.cpu_percent = rate(prev.usage_usec, curr.usage_usec) / 1e4;
+    cgroup.cpu_throttled_ms_per_sec =
+        rate(prev.throttled_usec, curr.throttled_usec) / 1e3;
+    cgroup.memory_kb = curr.memory_bytes / 1024;
+    cgroup.io_read_bytes_per_sec = rate(prev.io_read_bytes, curr.io_read_bytes);
+    cgroup.io_write_bytes_per_sec =
+        rate(prev.io_write_bytes, curr.io_write_bytes);
+    PsiResource &pressure = cgroup.memory_pressure;
+    pressure = curr.memory_pressure;
+    pressure.some.stall_us_per_sec =
+        rate(prev.memory_pressure.some.total_us, pressure.some.total_us);
+    pressure.full.stall_us_per_sec =
+        rate(prev.memory_pressure.full.total_us, pressure.full.total_us);
+  }
+  stats.resize(count);
+
+  select_top(metrics.top_cgroups_cpu,
+             [](const CgroupStats &s) { return s.cpu_percent; });
+  select_top(metrics.top_cgroups_mem,
+             [](const CgroupStats &s) { return s.memory_kb; });
+  select_top(metrics.top_cgroups_io, [](const CgroupStats &s) {
+    return s.io_read_bytes_per_sec + s.io_write_bytes_per_sec;
+  });
+}
+
+void CgroupPollingTask::commit() { prev_samples.swap(current_samples); }
+
+}; // namespace telemetry
@@ -1,8 +1,13 @@
 // corestat.cpp
 #include "corestat.hpp"
 
+#include <charconv>
+#include <cstring>
+
+#include "context.hpp"
 #include "data_local.hpp"
 #include "data_ssh.hpp"
+#include "log.hpp"
 #include "polling.hpp"
 
 namespace telemetry {
@@ -19,63 +24,287 @@ CpuPollingTask::CpuPollingTask(DataStreamProvider &provider,
                                SystemMetrics &metrics, MetricsContext &context)
     : IPollingTask(provider, metrics, context) {
   //   dump_fstream(provider.get_stat_stream());
+  if (context.provider == DataStreamProviders::LocalDataStream)
+    topology.load();
 }
 
-void CpuPollingTask::calculate() {
-  std::vector<CoreStats> all_core_stats;
-  size_t num_cores_and_agg =
-      std::min(prev_snapshots.size(), current_snapshots.size());
-
-  for (size_t i = 0; i < num_cores_and_agg; ++i) {
-    const auto &prev = prev_snapshots[i];
-    const auto &curr = current_snapshots[i];
-
-    unsigned long long curr_total = curr.get_total_time();
-    unsigned long long prev_total = prev.get_total_time();
-
-    // Handle counter wraps or resets: if total time or individual metrics
-    // regressed
-    if (curr_total < prev_total || curr.user < prev.user ||
-        curr.nice < prev.nice || curr.system < prev.system ||
-        curr.idle < prev.idle || curr.iowait < prev.iowait) {
-      all_core_stats.push_back({i, 0.0f, 0.0f, 0.0f, 0.0f, 100.0f, 0.0f});
+bool parse_cpu_dirname(const std::string &dirname, size_t &cpu) {
+  if (dirname.size() < 4 || dirname.compare(0, 3, "cpu") != 0 ||
+      !std::all_of(dirname.begin() + 3, dirname.end(),
+                   [](unsigned char c) { return std::isdigit(c); }))
+    return false;
+  cpu = std::strtoul(dirname.c_str() + 3, nullptr, 10);
+  return true;
+}
+
+void CpuTopology::load(const std::string &cpu_base) {
+  packages.clear();
+  physical_cores.clear();
+  numa_nodes.clear();
+
+  std::map<size_t, Group> by_package;
+  std::map<std::pair<size_t, size_t>, Group> by_core;
+  std::map<size_t, Group> by_node;
+  std::string buffer;
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(cpu_base, ec)) {
+    size_t cpu;
+    if (!parse_cpu_dirname(entry.path().filename().string(), cpu))
+      continue;
+
+    // Offline CPUs have no topology directory
+    auto topology = entry.path() / "topology";
+    unsigned long long package_id, core_id;
+    if (!ProcFile((topology / "physical_package_id").string())
+             .read_counter(buffer, package_id) ||
+        !ProcFile((topology / "core_id").string())
+             .read_counter(buffer, core_id))
       continue;
+    by_package[package_id].cpus.push_back(cpu);
+    by_core[{package_id, core_id}].cpus.push_back(cpu);
+
+    // NUMA kernels link the owning node as cpuN/nodeM
+    std::error_code node_ec;
+    for (const auto &link :
+         std::filesystem::directory_iterator(entry.path(), node_ec)) {
+      std::string link_name = link.path().filename().string();
+      if (link_name.size() > 4 && link_name.compare(0, 4, "node") == 0 &&
+          std::isdigit(static_cast<unsigned char>(link_name[4])))
+        by_node[std::strtoul(link_name.c_str() + 4, nullptr, 10)]
+            .cpus.push_back(cpu);
     }
+  }
 
-    unsigned long long total_delta = curr_total - prev_total;
+  auto flatten = [](auto &groups_by_key, std::vector<Group> &out,
+                    auto group_id) {
+    for (auto &[key, group] : groups_by_key) {
+      std::sort(group.cpus.begin(), group.cpus.end());
+      group.id = group_id(key, group);
+      out.push_back(std::move(group));
+    }
+    std::sort(out.begin(), out.end(),
+              [](const Group &a, const Group &b) { return a.id < b.id; });
+  };
+  flatten(by_package, packages,
+          [](size_t package, const Group &) { return package; });
+  flatten(by_core, physical_cores,
+          [](const std::pair<size_t, size_t> &, const Group &group) {
+            return group.cpus.front();
+          });
+  flatten(by_node, numa_nodes,
+          [](size_t node, const Group &) { return node; });
+  SPDLOG_DEBUG("CPU topology: {} packages, {} cores, {} nodes",
+               packages.size(), physical_cores.size(), numa_nodes.size());
+}
 
-    if (total_delta == 0) {
-      all_core_stats.push_back({i, 0.0f, 0.0f, 0.0f, 0.0f, 100.0f, 0.0f});
-      continue;
+void sum_cpu_groups(const CpuSnapshotList &rows,
+                    const std::vector<CpuTopology::Group> &groups,
+                    CpuSnapshotList &out) {
+  out.clear();
+  for (const auto &group : groups) {
+    CpuSnapshot sum;
+    for (size_t cpu : group.cpus) {
+      size_t row = rows.find_row(cpu);
+      if (row == rows.size())
+        continue;
+      sum.user += rows.user[row];
+      sum.nice += rows.nice[row];
+      sum.system += rows.system[row];
+      sum.idle += rows.idle[row];
+      sum.iowait += rows.iowait[row];
+      sum.irq += rows.irq[row];
+      sum.softirq += rows.softirq[row];
+      sum.steal += rows.steal[row];
     }
+    out.push_back(sum);
+  }
+}
+
+CpuSnapshotList::CpuSnapshotList(std::initializer_list<CpuSnapshot> rows) {
+  reserve(rows.size());
+  for (const auto &row : rows)
+    push_back(row);
+}
+
+void CpuSnapshotList::clear() {
+  for (auto *column :
+       {&user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal})
+    column->clear();
+  cpu.clear();
+}
+
+void CpuSnapshotList::reserve(size_t rows) {
+  for (auto *column :
+       {&user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal})
+    column->reserve(rows);
+  cpu.reserve(rows);
+}
+
+void CpuSnapshotList::push_back(const CpuSnapshot &row) {
+  user.push_back(row.user);
+  nice.push_back(row.nice);
+  system.push_back(row.system);
+  idle.push_back(row.idle);
+  iowait.push_back(row.iowait);
+  irq.push_back(row.irq);
+  softirq.push_back(row.softirq);
+  steal.push_back(row.steal);
+  cpu.push_back(row.cpu);
+}
+
+size_t CpuSnapshotList::find_row(size_t cpu_number) const {
+  // Rows after the aggregate are in ascending CPU order
+  if (cpu.size() < 2)
+    return size();
+  auto it = std::lower_bound(cpu.begin() + 1, cpu.end(), cpu_number);
+  if (it == cpu.end() || *it != cpu_number)
+    return size();
+  return it - cpu.begin();
+}
+
+void CpuUsageArrays::resize(size_t rows) {
+  for (auto *column : {&user, &nice, &system, &iowait, &idle, &irq, &softirq,
+                       &steal, &total, &scale})
+    column->resize(rows);
+}
 
-    unsigned long long user_delta = curr.user - prev.user;
-    unsigned long long nice_delta = curr.nice - prev.nice;
-    unsigned long long system_delta = curr.system - prev.system;
-    unsigned long long iowait_delta = curr.iowait - prev.iowait;
-    unsigned long long idle_delta = curr.idle - prev.idle;
+// Low 31 bits of a per-tick delta as a signed 32-bit lane
+static inline int32_t low_lane(unsigned long long delta) {
+  return static_cast<int32_t>(delta & 0x7fffffff);
+}
 
-    CoreStats core_stat;
-    core_stat.core_id = i; // 0 = aggregate, 1 = Core 0, etc.
+// out[i] = delta * scale[i]; a zero scale marks a row that is not valid
+static void scale_column(const unsigned long long *prev,
+                         const unsigned long long *curr, const float *scale,
+                         size_t rows, float *out) {
+  for (size_t i = 0; i < rows; ++i)
+    out[i] = static_cast<float>(low_lane(curr[i] - prev[i])) * scale[i];
+}
 
-    core_stat.user_percent = 100.0f * user_delta / total_delta;
-    core_stat.nice_percent = 100.0f * nice_delta / total_delta;
-    core_stat.system_percent = 100.0f * system_delta / total_delta;
-    core_stat.iowait_percent = 100.0f * iowait_delta / total_delta;
-    core_stat.idle_percent = 100.0f * idle_delta / total_delta;
+void compute_cpu_usage(const CpuSnapshotList &prev,
+                       const CpuSnapshotList &curr, size_t rows,
+                       CpuUsageArrays &out) {
+  out.resize(rows);
 
+  // Same scheme as compute_counter_rates(): every delta is narrowed to a
+  // 32-bit lane right after the 64-bit subtraction and the selects are
+  // integer masks, so none of these loops has control flow. A column that
+  // went backwards wraps to a delta of 2^31 or more; that row, like one
+  // that did not advance, gets a zero scale and reports 100% idle. The
+  // scale is computed first so each column loop has a single output and
+  // stays within GCC's alias check budget.
+  float *scale = out.scale.data();
+  for (size_t i = 0; i < rows; ++i) {
+    unsigned long long user = curr.user[i] - prev.user[i];
+    unsigned long long nice = curr.nice[i] - prev.nice[i];
+    unsigned long long system = curr.system[i] - prev.system[i];
+    unsigned long long idle = curr.idle[i] - prev.idle[i];
+    unsigned long long iowait = curr.iowait[i] - prev.iowait[i];
+    unsigned long long irq = curr.irq[i] - prev.irq[i];
+    unsigned long long softirq = curr.softirq[i] - prev.softirq[i];
+    unsigned long long steal = curr.steal[i] - prev.steal[i];
+    unsigned long long sum =
+        user + nice + system + idle + iowait + irq + softirq + steal;
+    // A wrapped column, or a sum that does not fit a lane, voids the row
+    uint32_t high = static_cast<uint32_t>(
+        (user | nice | system | idle | iowait | irq | softirq | steal | sum) >>
+        31);
+    int32_t total = low_lane(sum) & -static_cast<int32_t>(high == 0);
+    int32_t empty = -static_cast<int32_t>(total == 0);
+    // An empty row divides by 1 instead of 0 and then has its scale
+    // cleared bitwise; a float select here would stop the vectorizer
+    float row_scale = 100.0f / static_cast<float>(total | (empty & 1));
+    uint32_t bits;
+    std::memcpy(&bits, &row_scale, sizeof(bits));
+    bits &= ~static_cast<uint32_t>(empty);
+    std::memcpy(&row_scale, &bits, sizeof(bits));
+    scale[i] = row_scale;
+  }
+
+  scale_column(prev.user.data(), curr.user.data(), scale, rows,
+               out.user.data());
+  scale_column(prev.nice.data(), curr.nice.data(), scale, rows,
+               out.nice.data());
+  scale_column(prev.system.data(), curr.system.data(), scale, rows,
+               out.system.data());
+  scale_column(prev.idle.data(), curr.idle.data(), scale, rows,
+               out.idle.data());
+  scale_column(prev.iowait.data(), curr.iowait.data(), scale, rows,
+               out.iowait.data());
+  scale_column(prev.irq.data(), curr.irq.data(), scale, rows, out.irq.data());
+  scale_column(prev.softirq.data(), curr.softirq.data(), scale, rows,
+               out.softirq.data());
+  scale_column(prev.steal.data(), curr.steal.data(), scale, rows,
+               out.steal.data());
+
+  for (size_t i = 0; i < rows; ++i) {
+    int32_t invalid = -static_cast<int32_t>(scale[i] == 0.0f);
+    out.idle[i] += static_cast<float>(invalid & 100);
     // Total usage ("CPU Load") = user + nice + system
-    core_stat.total_usage_percent = core_stat.user_percent +
-                                    core_stat.nice_percent +
-                                    core_stat.system_percent;
+    out.total[i] = out.user[i] + out.nice[i] + out.system[i];
+  }
+}
+
+void CpuPollingTask::calculate() {
+  size_t rows = std::min(prev_snapshots.size(), current_snapshots.size());
+  compute_cpu_usage(prev_snapshots, current_snapshots, rows, usage);
+
+  // Rows are already in core_id order (0 = aggregate, then online CPUs).
+  // Entries are updated in place so the per-core annotations added by the
+  // frequency and idle tasks keep their storage between ticks.
+  metrics.cores.resize(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    CoreStats &core_stat = metrics.cores[i];
+    core_stat.core_id = i;
+    core_stat.cpu = current_snapshots.cpu[i];
+    core_stat.user_percent = usage.user[i];
+    core_stat.nice_percent = usage.nice[i];
+    core_stat.system_percent = usage.system[i];
+    core_stat.iowait_percent = usage.iowait[i];
+    core_stat.idle_percent = usage.idle[i];
+    core_stat.irq_percent = usage.irq[i];
+    core_stat.softirq_percent = usage.softirq[i];
+    core_stat.steal_percent = usage.steal[i];
+    core_stat.total_usage_percent = usage.total[i];
+  }
+
+  // Group sums are only meaningful when both ticks saw the same CPUs
+  if (prev_snapshots.cpu != current_snapshots.cpu) {
+    metrics.cpu_packages.clear();
+    metrics.cpu_physical_cores.clear();
+    metrics.numa_nodes.clear();
+    return;
+  }
+  calculate_groups(topology.packages, metrics.cpu_packages);
+  calculate_groups(topology.physical_cores, metrics.cpu_physical_cores);
+  calculate_groups(topology.numa_nodes, metrics.numa_nodes);
+}
 
-    all_core_stats.push_back(core_stat);
+void CpuPollingTask::calculate_groups(
+    const std::vector<CpuTopology::Group> &groups,
+    std::vector<CpuGroupStats> &out) {
+  // Summing the raw counters first weights each CPU by its elapsed time,
+  // unlike averaging the per-core percentages.
+  sum_cpu_groups(prev_snapshots, groups, group_prev);
+  sum_cpu_groups(current_snapshots, groups, group_curr);
+  compute_cpu_usage(group_prev, group_curr, groups.size(), group_usage);
+
+  out.resize(groups.size());
+  for (size_t i = 0; i < groups.size(); ++i) {
+    CpuGroupStats &group_stat = out[i];
+    group_stat.id = groups[i].id;
+    group_stat.cpu_count = groups[i].cpus.size();
+    group_stat.user_percent = group_usage.user[i];
+    group_stat.nice_percent = group_usage.nice[i];
+    group_stat.system_percent = group_usage.system[i];
+    group_stat.iowait_percent = group_usage.iowait[i];
+    group_stat.idle_percent = group_usage.idle[i];
+    group_stat.irq_percent = group_usage.irq[i];
+    group_stat.softirq_percent = group_usage.softirq[i];
+    group_stat.steal_percent = group_usage.steal[i];
+    group_stat.total_usage_percent = group_usage.total[i];
   }
-  std::sort(all_core_stats.begin(), all_core_stats.end(),
-            [](const CoreStats &a, const CoreStats &b) {
-              return a.core_id < b.core_id;
-            });
-  metrics.cores = all_core_stats;
 }
 
 void CpuPollingTask::take_initial_snapshot() {
@@ -93,6 +322,7 @@ void CpuPollingTask::commit() { prev_snapshots = current_snapshots; }
 
 CpuSnapshotList CpuPollingTask::read_data(std::istream &input_stream) {
   CpuSnapshotList snapshots;
+  snapshots.reserve(prev_snapshots.size());
   std::string line;
 
   while (std::getline(input_stream, line)) {
@@ -104,7 +334,9 @@ CpuSnapshotList CpuPollingTask::read_data(std::istream &input_stream) {
     std::string label;
     ss >> label;
 
+    // The aggregate "cpu" row keeps cpu = 0
     CpuSnapshot snap;
+    parse_cpu_dirname(label, snap.cpu);
     ss >> snap.user >> snap.nice >> snap.system >> snap.idle >> snap.iowait >>
         snap.irq >> snap.softirq >> snap.steal;
     snapshots.push_back(snap);
@@ -112,6 +344,244 @@ CpuSnapshotList CpuPollingTask::read_data(std::istream &input_stream) {
   return snapshots;
 }
 
+CpuIdlePollingTask::CpuIdlePollingTask(DataStreamProvider &provider,
+                                       SystemMetrics &metrics,
+                                       MetricsContext &context)
+    : IPollingTask(provider, metrics, context) {
+  name = "CPU idle polling";
+  if (context.provider == DataStreamProviders::LocalDataStream)
+    discover();
+}
+
+void CpuIdlePollingTask::discover(const std::string &cpu_base) {
+  cpus.clear();
+  state_files.clear();
+
+  std::error_code ec;
+  std::vector<size_t> cpu_numbers;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(cpu_base, ec)) {
+    size_t cpu;
+    if (parse_cpu_dirname(entry.path().filename().string(), cpu))
+      cpu_numbers.push_back(cpu);
+  }
+  std::sort(cpu_numbers.begin(), cpu_numbers.end());
+
+  for (size_t cpu : cpu_numbers) {
+    std::filesystem::path cpuidle = std::filesystem::path(cpu_base) /
+                                    ("cpu" + std::to_string(cpu)) / "cpuidle";
+    CpuIdleStates states;
+    states.cpu = cpu;
+    states.first = state_files.size();
+    // States are numbered contiguously from state0
+    for (size_t index = 0;; ++index) {
+      std::string state = "state" + std::to_string(index);
+      IdleStateFiles files;
+      if (!files.time.open((cpuidle / state / "time").string()) ||
+          !files.usage.open((cpuidle / state / "usage").string()))
+        break;
+      std::ifstream name_file(cpuidle / state / "name");
+      std::string state_name;
+      std::getline(name_file, state_name);
+      states.names.push_back(state_name.empty() ? state : state_name);
+      state_files.push_back(std::move(files));
+    }
+    if (!states.names.empty())
+      cpus.push_back(std::move(states));
+  }
+  SPDLOG_DEBUG("CPU idle: {} cpus, {} states", cpus.size(),
+               state_files.size());
+}
+
+CpuIdleSnapshotList CpuIdlePollingTask::read_snapshot() {
+  CpuIdleSnapshotList snapshots(state_files.size());
+  for (size_t i = 0; i < state_files.size(); ++i) {
+    state_files[i].time.read_counter(buffer, snapshots[i].time_us);
+    state_files[i].usage.read_counter(buffer, snapshots[i].usage);
+  }
+  return snapshots;
+}
+
+void CpuIdlePollingTask::take_initial_snapshot() {
+  set_timestamp();
+  prev_snapshots = read_snapshot();
+}
+
+void CpuIdlePollingTask::take_new_snapshot() {
+  set_delta_time();
+  current_snapshots = read_snapshot();
+}
+
+void CpuIdlePollingTask::calculate() {
+  if (prev_snapshots.size() != current_snapshots.size() ||
+      time_delta_seconds <= 0.0)
+    return;
+  double interval_us = time_delta_seconds * 1e6;
+
+  CoreStats *aggregate = nullptr;
+  std::vector<double> residency_sum;
+  std::vector<size_t> residency_count;
+  double wakeups_sum = 0.0;
+
+  // cores[0] is the aggregate; the rest are matched by CPU number
+  for (auto &core : metrics.cores) {
+    if (core.core_id == 0) {
+      aggregate = &core;
+      continue;
+    }
+    auto it = std::lower_bound(cpus.begin(), cpus.end(), core.cpu,
+                               [](const CpuIdleStates &states, size_t cpu) {
+                                 return states.cpu < cpu;
+                               });
+    if (it == cpus.end() || it->cpu != core.cpu)
+      continue;
+
+    core.idle_states.resize(it->names.size());
+    unsigned long long wakeups = 0;
+    for (size_t j = 0; j < it->names.size(); ++j) {
+      const auto &prev = prev_snapshots[it->first + j];
+      const auto &curr = current_snapshots[it->first + j];
+      double residency =
+          100.0 * counter_delta(curr.time_us, prev.time_us) / interval_us;
+      core.idle_states[j].name = it->names[j];
+      core.idle_states[j].residency_percent =
+          static_cast<float>(std::min(residency, 100.0));
+      // Every exit from an idle state is a wakeup
+      wakeups += counter_delta(curr.usage, prev.usage);
+
+      if (residency_sum.size() <= j) {
+        residency_sum.resize(j + 1, 0.0);
+        residency_count.resize(j + 1, 0);
+      }
+      residency_sum[j] += core.idle_states[j].residency_percent;
+      ++residency_count[j];
+    }
+    core.wakeups_per_sec = wakeups / time_delta_seconds;
+    wakeups_sum += core.wakeups_per_sec;
+  }
+
+  if (aggregate == nullptr || cpus.empty())
+    return;
+  // State names follow the driver, which is the same on every CPU
+  const auto &names = cpus.front().names;
+  aggregate->idle_states.resize(residency_sum.size());
+  for (size_t j = 0; j < residency_sum.size(); ++j) {
+    aggregate->idle_states[j].name =
+        j < names.size() ? names[j] : "state" + std::to_string(j);
+    aggregate->idle_states[j].residency_percent =
+        static_cast<float>(residency_sum[j] / residency_count[j]);
+  }
+  aggregate->wakeups_per_sec = wakeups_sum;
+}
+
+void CpuIdlePollingTask::commit() { prev_snapshots = current_snapshots; }
+
+// "cpu3 0 0 1234 567 890 12 <run_ns> <wait_ns> <timeslices>". The leading
+// fields differ between schedstat versions; the scheduler ones are always
+// the last three on the line.
+bool parse_schedstat(std::string_view text, SchedstatSnapshotList &rows) {
+  rows.resize(1);
+  rows[0] = SchedstatSnapshot();
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string_view::npos)
+      end = text.size();
+    std::string_view line = text.substr(start, end - start);
+    start = end + 1;
+    if (line.size() < 4 || line.compare(0, 3, "cpu") != 0 ||
+        !std::isdigit(static_cast<unsigned char>(line[3])))
+      continue;
+
+    SchedstatSnapshot row;
+    const char *pos = line.data() + 3;
+    const char *line_end = line.data() + line.size();
+    pos = std::from_chars(pos, line_end, row.cpu).ptr;
+
+    // Ring of the last three values seen
+    unsigned long long last[3] = {};
+    size_t count = 0;
+    for (;;) {
+      while (pos < line_end && *pos == ' ')
+        ++pos;
+      auto result = std::from_chars(pos, line_end, last[count % 3]);
+      if (result.ec != std::errc())
+        break;
+      pos = result.ptr;
+      ++count;
+    }
+    if (count < 3)
+      continue;
+    row.run_ns = last[count % 3];
+    row.wait_ns = last[(count + 1) % 3];
+    row.timeslices = last[(count + 2) % 3];
+
+    rows[0].run_ns += row.run_ns;
+    rows[0].wait_ns += row.wait_ns;
+    rows[0].timeslices += row.timeslices;
+    rows.push_back(row);
+  }
+  return rows.size() > 1;
+}
+
+SchedstatPollingTask::SchedstatPollingTask(DataStreamProvider &provider,
+                                           SystemMetrics &metrics,
+                                           MetricsContext &context)
+    : IPollingTask(provider, metrics, context) {
+  name = "Schedstat polling";
+  if (context.provider == DataStreamProviders::LocalDataStream)
+    schedstat.open("/proc/schedstat");
+}
+
+void SchedstatPollingTask::read_snapshot(SchedstatSnapshotList &rows) {
+  if (!schedstat.read(buffer) || !parse_schedstat(buffer, rows))
+    rows.clear();
+}
+
+void SchedstatPollingTask::take_initial_snapshot() {
+  set_timestamp();
+  read_snapshot(prev_snapshots);
+}
+
+void SchedstatPollingTask::take_new_snapshot() {
+  set_delta_time();
+  read_snapshot(current_snapshots);
+}
+
+void SchedstatPollingTask::calculate() {
+  // A CPU going on- or offline changes the rows and the aggregate's sum
+  if (prev_snapshots.size() != current_snapshots.size() ||
+      current_snapshots.empty() || time_delta_seconds <= 0.0)
+    return;
+
+  for (auto &core : metrics.cores) {
+    size_t row = 0;
+    if (core.core_id != 0) {
+      // Rows after the aggregate are in CPU order
+      auto it = std::lower_bound(current_snapshots.begin() + 1,
+                                 current_snapshots.end(), core.cpu,
+                                 [](const SchedstatSnapshot &s, size_t cpu) {
+                                   return s.cpu < cpu;
+                                 });
+      if (it == current_snapshots.end() || it->cpu != core.cpu)
+        continue;
+      row = it - current_snapshots.begin();
+      if (prev_snapshots[row].cpu != it->cpu)
+        continue;
+    }
+
+    const SchedstatSnapshot &prev = prev_snapshots[row];
+    const SchedstatSnapshot &curr = current_snapshots[row];
+    unsigned long long wait_ns = counter_delta(curr.wait_ns, prev.wait_ns);
+    unsigned long long slices = counter_delta(curr.timeslices, prev.timeslices);
+    core.runqueue_wait_ms_per_sec = wait_ns / 1e6 / time_delta_seconds;
+    core.timeslices_per_sec = slices / time_delta_seconds;
+    core.sched_latency_us = slices == 0 ? 0.0 : wait_ns / 1e3 / slices;
+  }
+}
+
+void SchedstatPollingTask::commit() { prev_snapshots = current_snapshots; }
+
 /* Deprecated, possibly dead code */
 std::vector<CPUCore> read_cpu_times(std::istream &input_stream) {
   std::vector<CPUCore> cores;
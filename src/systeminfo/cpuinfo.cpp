@@ -1,8 +1,12 @@
 // cpuinfo.cpp
 #include "cpuinfo.hpp"
 
+#include "context.hpp"
+#include "corestat.hpp"
 #include "data_local.hpp"
 #include "data_ssh.hpp"
+#include "log.hpp"
+#include "polling.hpp"
 
 namespace telemetry {
 
@@ -27,4 +31,155 @@ float get_cpu_freq_mhz(std::istream &input_stream) {
 float get_cpu_freq_ghz(std::istream &input_stream) {
   return get_cpu_freq_mhz(input_stream) / 1000.0f;
 }
+
+std::vector<double> get_core_freqs_mhz(std::istream &input_stream) {
+  std::vector<double> freqs;
+  size_t processor = 0;
+  std::string line;
+  while (std::getline(input_stream, line)) {
+    size_t colon = line.find(':');
+    if (colon == std::string::npos)
+      continue;
+    const char *value = line.c_str() + colon + 1;
+    if (line.compare(0, 9, "processor") == 0) {
+      processor = std::strtoul(value, nullptr, 10);
+    } else if (line.compare(0, 7, "cpu MHz") == 0) {
+      if (freqs.size() <= processor)
+        freqs.resize(processor + 1, 0.0);
+      freqs[processor] = std::strtod(value, nullptr);
+    }
+  }
+  return freqs;
+}
+
+CpuFrequencyPollingTask::CpuFrequencyPollingTask(DataStreamProvider &provider,
+                                                 SystemMetrics &metrics,
+                                                 MetricsContext &context)
+    : IPollingTask(provider, metrics, context) {
+  name = "CPU frequency polling";
+  if (context.provider == DataStreamProviders::LocalDataStream)
+    discover();
+}
+
+void CpuFrequencyPollingTask::discover(const std::string &cpu_base) {
+  cpus.clear();
+  has_cpufreq = false;
+
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(cpu_base, ec)) {
+    CpuFiles files;
+    if (!parse_cpu_dirname(entry.path().filename().string(), files.cpu))
+      continue;
+
+    const auto &dir = entry.path();
+    if (files.frequency.open((dir / "cpufreq/scaling_cur_freq").string()))
+      has_cpufreq = true;
+    files.core_throttle.open(
+        (dir / "thermal_throttle/core_throttle_count").string());
+    files.package_throttle.open(
+        (dir / "thermal_throttle/package_throttle_count").string());
+
+    ProcFile package_id((dir / "topology/physical_package_id").string());
+    unsigned long long package;
+    if (package_id.read_counter(buffer, package))
+      files.package = static_cast<long>(package);
+    cpus.push_back(std::move(files));
+  }
+  std::sort(cpus.begin(), cpus.end(),
+            [](const CpuFiles &a, const CpuFiles &b) { return a.cpu < b.cpu; });
+  SPDLOG_DEBUG("CPU frequency: {} cpus, cpufreq {}", cpus.size(),
+               has_cpufreq ? "present" : "absent");
+}
+
+CpuFrequencySnapshotList CpuFrequencyPollingTask::read_snapshot() {
+  CpuFrequencySnapshotList snapshots;
+  for (const auto &files : cpus) {
+    if (snapshots.size() <= files.cpu)
+      snapshots.resize(files.cpu + 1);
+    CpuFrequencySnapshot &snapshot = snapshots[files.cpu];
+
+    unsigned long long khz;
+    if (files.frequency.read_counter(buffer, khz))
+      snapshot.frequency_mhz = khz / 1000.0;
+    files.core_throttle.read_counter(buffer, snapshot.core_throttles);
+    files.package_throttle.read_counter(buffer, snapshot.package_throttles);
+  }
+
+  if (!has_cpufreq) {
+    std::vector<double> freqs =
+        get_core_freqs_mhz(provider.get_cpuinfo_stream());
+    if (snapshots.size() < freqs.size())
+      snapshots.resize(freqs.size());
+    for (size_t cpu = 0; cpu < freqs.size(); ++cpu)
+      snapshots[cpu].frequency_mhz = freqs[cpu];
+  }
+  return snapshots;
+}
+
+void CpuFrequencyPollingTask::take_initial_snapshot() {
+  set_timestamp();
+  prev_snapshots = read_snapshot();
+}
+
+void CpuFrequencyPollingTask::take_new_snapshot() {
+  set_delta_time();
+  current_snapshots = read_snapshot();
+}
+
+void CpuFrequencyPollingTask::calculate() {
+  size_t count = std::min(prev_snapshots.size(), current_snapshots.size());
+
+  double frequency_sum = 0.0;
+  size_t frequency_count = 0;
+  for (size_t cpu = 0; cpu < count; ++cpu) {
+    if (current_snapshots[cpu].frequency_mhz > 0.0) {
+      frequency_sum += current_snapshots[cpu].frequency_mhz;
+      ++frequency_count;
+    }
+  }
+
+  // Package counters are mirrored on every CPU of the package, so they are
+  // only summed once per package for the aggregate.
+  unsigned long long core_events = 0;
+  unsigned long long package_events = 0;
+  std::set<long> packages;
+  for (const auto &files : cpus) {
+    if (files.cpu >= count)
+      continue;
+    const auto &prev = prev_snapshots[files.cpu];
+    const auto &curr = current_snapshots[files.cpu];
+    core_events += counter_delta(curr.core_throttles, prev.core_throttles);
+    if (packages.insert(files.package).second)
+      package_events +=
+          counter_delta(curr.package_throttles, prev.package_throttles);
+  }
+
+  double average_mhz = frequency_count ? frequency_sum / frequency_count : 0.0;
+  if (frequency_count)
+    metrics.cpu_frequency_ghz = average_mhz / 1000.0;
+
+  // cores[0] is the aggregate; snapshots are indexed by CPU number
+  for (auto &core : metrics.cores) {
+    if (core.core_id == 0) {
+      core.frequency_mhz = average_mhz;
+      core.core_throttle_events = core_events;
+      core.package_throttle_events = package_events;
+      continue;
+    }
+    size_t cpu = core.cpu;
+    if (cpu >= count)
+      continue;
+    const auto &prev = prev_snapshots[cpu];
+    const auto &curr = current_snapshots[cpu];
+    core.frequency_mhz = curr.frequency_mhz;
+    core.core_throttle_events =
+        counter_delta(curr.core_throttles, prev.core_throttles);
+    core.package_throttle_events =
+        counter_delta(curr.package_throttles, prev.package_throttles);
+  }
+}
+
+void CpuFrequencyPollingTask::commit() { prev_snapshots = current_snapshots; }
+
 }; // namespace telemetry
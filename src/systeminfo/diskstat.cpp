@@ -10,12 +10,18 @@
 #include "polling.hpp"
 #include "ssh.hpp"
 #include "stream_provider.hpp"
+#include <sys/stat.h>
+
 #include <filesystem>
 #include <fstream>
 
 namespace telemetry {
 namespace fs = std::filesystem;
 
+// Above this many devices a single /proc/diskstats read is cheaper than one
+// pread() per device
+constexpr size_t DISK_STAT_FILE_LIMIT = 16;
+
 std::istream &LocalDataStreams::get_diskstats_stream() {
   return create_stream_from_file(diskstats, "/proc/diskstats");
 }
@@ -56,6 +62,12 @@ DiskPollingTask::DiskPollingTask(DataStreamProvider &provider,
     : IPollingTask(provider, metrics, context) {
   // 1. Copy the Config
   this->config = context.disk_stat_config;
+  context_is_local = context.provider == DataStreamProviders::LocalDataStream;
+  top_k = context.settings.storage.top_k;
+  usage_interval =
+      std::chrono::milliseconds(context.settings.storage.usage_interval_ms);
+  usage_timeout =
+      std::chrono::milliseconds(context.settings.storage.usage_timeout_ms);
 
   // 2. Load the Allowlist
   for (const auto &dev : context.io_devices) {
@@ -76,6 +88,9 @@ DiskPollingTask::DiskPollingTask(DataStreamProvider &provider,
     device_paths.insert(device_paths.end(), loaded.begin(), loaded.end());
   }
 
+  if (context_is_local)
+    mount_table.open();
+
   metrics.disks.reserve(metrics.disks.size() + device_paths.size());
   // 2. Iterate the paths we JUST loaded
   for (const std::string &logical_path : device_paths) {
@@ -90,31 +105,185 @@ DiskPollingTask::DiskPollingTask(DataStreamProvider &provider,
       // Build the persistent "skeleton" in SystemMetrics
       DeviceInfo info;
       info.device_path = logical_path;
-      info.mount_point =
-          get_mount_point(provider.get_mounts_stream(), logical_path);
+      struct stat st;
+      bool is_block = context_is_local &&
+                      ::stat(real_path.c_str(), &st) == 0 &&
+                      S_ISBLK(st.st_mode);
+      if (is_block)
+        info.mount_point = mount_table.find(st.st_rdev, real_path.string());
+      else
+        info.mount_point =
+            get_mount_point(provider.get_mounts_stream(), logical_path);
       SPDLOG_TRACE("Found mount point: {}", info.mount_point);
-      info.usage = provider.get_disk_usage(info.mount_point);
+      // Local usage comes from the refresher thread; statvfs() here could
+      // hang construction on a dead mount
+      if (!context_is_local)
+        info.usage = provider.get_disk_usage(info.mount_point);
 
       metrics.disks.push_back(std::move(info));
 
       // Store a pointer to the object we just created
       DeviceInfo *device_ptr = &metrics.disks.back();
       kernel_to_device_map[kernel_name] = device_ptr;
+      if (is_block)
+        mounted_devices.push_back({st.st_rdev, real_path.string(), device_ptr});
+      else if (context_is_local)
+        unmapped_devices.push_back(device_ptr);
 
     } catch (const std::filesystem::filesystem_error &e) {
       std::cerr << "Warning (DiskPollingTask): Could not resolve device path: "
                 << logical_path << ": " << e.what() << std::endl;
+      // Not plugged in yet; mapped once the mount table changes
+      if (context_is_local) {
+        DeviceInfo &info = metrics.disks.emplace_back();
+        info.device_path = logical_path;
+        unmapped_devices.push_back(&info);
+      }
     }
   }
 }
 
 void DiskPollingTask::take_initial_snapshot() {
+  if (context_is_local) {
+    open_stat_files();
+    watch_usage();
+  }
   set_timestamp();
-  prev_snapshots = read_data(provider.get_diskstats_stream());
+  remote_usage_time = timestamp;
+  prev_snapshots = read_snapshot();
 }
 void DiskPollingTask::take_new_snapshot() {
   set_delta_time();
-  current_snapshots = read_data(provider.get_diskstats_stream());
+  current_snapshots = read_snapshot();
+  if (mount_table.poll())
+    refresh_mount_points();
+
+  if (usage_refresher.is_running()) {
+    for (const auto &[kernel_name, info] : kernel_to_device_map)
+      usage_refresher.get(info->mount_point, info->usage);
+  } else if (!context_is_local &&
+             timestamp - remote_usage_time >= usage_interval) {
+    refresh_remote_usage();
+  }
+}
+
+void DiskPollingTask::refresh_remote_usage() {
+  remote_usage_time = timestamp;
+  for (const auto &[kernel_name, info] : kernel_to_device_map)
+    info->usage = provider.get_disk_usage(info->mount_point);
+}
+
+void DiskPollingTask::watch_usage() {
+  std::vector<std::string> mount_points;
+  for (const auto &[kernel_name, info] : kernel_to_device_map)
+    mount_points.push_back(info->mount_point);
+
+  if (!usage_refresher.is_running()) {
+    if (mount_points.empty())
+      return;
+    usage_refresher.start(usage_interval, usage_timeout);
+  }
+  usage_refresher.set_mount_points(mount_points);
+}
+
+// Registers a config device that was not a block device before
+bool DiskPollingTask::map_device(DeviceInfo *info) {
+  std::error_code error;
+  auto real_path = std::filesystem::canonical(info->device_path, error);
+  struct stat st;
+  if (error || ::stat(real_path.c_str(), &st) != 0 || !S_ISBLK(st.st_mode))
+    return false;
+
+  std::string kernel_name = real_path.filename().string();
+  SPDLOG_DEBUG("Disk: {} appeared as {}", info->device_path, kernel_name);
+  for (auto it = kernel_to_device_map.begin();
+       it != kernel_to_device_map.end();) {
+    it = it->second == info ? kernel_to_device_map.erase(it) : std::next(it);
+  }
+  kernel_to_device_map[kernel_name] = info;
+  target_kernel_names.insert(kernel_name);
+  mounted_devices.push_back({st.st_rdev, real_path.string(), info});
+
+  bool has_stat_file = std::any_of(
+      stat_files.begin(), stat_files.end(),
+      [&](const auto &entry) { return entry.first == kernel_name; });
+  if (!stat_files.empty() && !has_stat_file)
+    stat_files.emplace_back(kernel_name,
+                            ProcFile(block_class_dir + "/" + kernel_name +
+                                     "/stat"));
+  return true;
+}
+
+void DiskPollingTask::refresh_mount_points() {
+  // A device that appeared after startup is only known from here on
+  for (auto it = unmapped_devices.begin(); it != unmapped_devices.end();)
+    it = map_device(*it) ? unmapped_devices.erase(it) : std::next(it);
+
+  bool changed = false;
+  for (auto &[device, path, info] : mounted_devices) {
+    std::string mount_point = mount_table.find(device, path);
+    if (mount_point == info->mount_point)
+      continue;
+
+    SPDLOG_DEBUG("Disk: {} is now mounted at '{}'", info->device_path,
+                 mount_point);
+    info->mount_point = std::move(mount_point);
+    info->usage = DiskUsage{};
+    changed = true;
+  }
+  if (changed)
+    watch_usage();
+}
+
+void DiskPollingTask::open_stat_files() {
+  // Strict mode only: auto-discovery has to see every device
+  if (allowed_io_devices.empty())
+    return;
+
+  std::set<std::string> wanted = allowed_io_devices;
+  wanted.insert(target_kernel_names.begin(), target_kernel_names.end());
+  if (wanted.size() > DISK_STAT_FILE_LIMIT) {
+    SPDLOG_DEBUG("Disk: {} devices allowed, using /proc/diskstats",
+                 wanted.size());
+    return;
+  }
+
+  for (const auto &dev_name : wanted) {
+    // /sys/class/block covers both whole disks and partitions
+    ProcFile file(block_class_dir + "/" + dev_name + "/stat");
+    if (!file.is_open())
+      SPDLOG_INFO("Disk: no stat file for {} yet, retrying every tick",
+                  dev_name);
+    stat_files.emplace_back(dev_name, std::move(file));
+  }
+}
+
+DiskIoSnapshotMap DiskPollingTask::read_snapshot() {
+  if (!stat_files.empty())
+    return read_stat_files();
+  return read_data(provider.get_diskstats_stream());
+}
+
+DiskIoSnapshotMap DiskPollingTask::read_stat_files() {
+  DiskIoSnapshotMap snapshots;
+  for (auto &[dev_name, file] : stat_files) {
+    if (!file.read(stat_buffer)) {
+      // A removed device's fd fails with ENODEV and a re-added one gets a
+      // new sysfs node, so the path is opened again
+      bool was_open = file.is_open();
+      if (!file.open(block_class_dir + "/" + dev_name + "/stat") ||
+          !file.read(stat_buffer)) {
+        if (was_open)
+          SPDLOG_WARN("Disk: stat file for {} is gone, retrying every tick",
+                      dev_name);
+        file.close();
+        continue;
+      }
+      SPDLOG_INFO("Disk: reopened stat file for {}", dev_name);
+    }
+    parse_disk_counters(stat_buffer.c_str(), snapshots[dev_name]);
+  }
+  return snapshots;
 }
 
 void DiskPollingTask::commit() { prev_snapshots = current_snapshots; }
@@ -131,8 +300,7 @@ void DiskPollingTask::calculate() {
 
   // 1. Reset I/O stats for config-file devices
   for (const auto &[kernel_name, info_ptr] : kernel_to_device_map) {
-    info_ptr->io.read_bytes_per_sec = 0;
-    info_ptr->io.write_bytes_per_sec = 0;
+    info_ptr->io = DiskIoStats{};
   }
   SPDLOG_TRACE("Disk Calculate: Curr Size = {}", current_snapshots.size());
 
@@ -143,52 +311,166 @@ void DiskPollingTask::calculate() {
       continue; // No prev data, skip
     }
 
-    const auto &prev_snap = prev_it->second;
-    uint64_t read_delta = (curr_snap.bytes_read >= prev_snap.bytes_read)
-                              ? (curr_snap.bytes_read - prev_snap.bytes_read)
-                              : 0;
-    uint64_t write_delta =
-        (curr_snap.bytes_written >= prev_snap.bytes_written)
-            ? (curr_snap.bytes_written - prev_snap.bytes_written)
-            : 0;
-    uint64_t read_bps = static_cast<uint64_t>(read_delta / time_delta_seconds);
-    uint64_t write_bps =
-        static_cast<uint64_t>(write_delta / time_delta_seconds);
+    DiskIoStats stats =
+        calculate_disk_io(prev_it->second, curr_snap, time_delta_seconds);
 
     // Check if this device is one of the ones from the config file
     auto info_it = kernel_to_device_map.find(dev_name);
     if (info_it != kernel_to_device_map.end()) {
       // It is. Update the DeviceInfo struct directly.
-      DeviceInfo *info_ptr = info_it->second;
-      info_ptr->io.read_bytes_per_sec = read_bps;
-      info_ptr->io.write_bytes_per_sec = write_bps;
-    } else { // Inside the loop
-             // Ensure we aren't writing infinite entries
-      if (metrics.disk_io.size() > 100) {
-        std::cerr << "CRITICAL: DiskIO map growing too large! Aborting."
-                  << std::endl;
-        return;
-      }
-      // It's not from the config. Add it to the generic HdIoStats map.
-      HdIoStats &io = metrics.disk_io[dev_name];
+      info_it->second->io = stats;
+    } else {
+      // It's not from the config. Add it to the generic disk_io list.
+      HdIoStats &io = metrics.disk_io.emplace_back();
+      static_cast<DiskIoStats &>(io) = stats;
       io.device_name = dev_name;
-      io.read_bytes_per_sec = read_bps;
-      io.write_bytes_per_sec = write_bps;
 
       SPDLOG_TRACE("Found disk `{}`", io.device_name);
-      //   std::cerr << "CALCULATE: Added to disk_io map: " << dev_name
-      //             << " (read: " << read_bps << ", write: " << write_bps
-      //             << "), map size: " << metrics.disk_io.size() << std::endl;
     }
   }
-  SPDLOG_TRACE("CALCULATE END: disk_io map has {} entries.",
+
+  // An explicit allowlist already bounds the output
+  if (allowed_io_devices.empty())
+    select_top_k();
+
+  SPDLOG_TRACE("CALCULATE END: disk_io has {} entries.",
                metrics.disk_io.size());
-  //   for (const auto& [name, stats] : metrics.disk_io) {
-  //     std::cerr << "  - " << name << ": '" << stats.device_name
-  //               << "' read=" << stats.read_bytes_per_sec
-  //               << " write=" << stats.write_bytes_per_sec << std::endl;
-  //   }
 }
+
+void DiskPollingTask::select_top_k() {
+  auto &disk_io = metrics.disk_io;
+  if (top_k == 0 || disk_io.size() <= top_k)
+    return;
+
+  auto busier = [](const HdIoStats &a, const HdIoStats &b) {
+    uint64_t ta = a.read_bytes_per_sec + a.write_bytes_per_sec;
+    uint64_t tb = b.read_bytes_per_sec + b.write_bytes_per_sec;
+    if (ta != tb)
+      return ta > tb;
+    return a.device_name < b.device_name; // Stable output on ties
+  };
+  std::partial_sort(disk_io.begin(), disk_io.begin() + top_k, disk_io.end(),
+                    busier);
+
+  HdIoStats other;
+  other.device_name = "other";
+  for (auto it = disk_io.begin() + top_k; it != disk_io.end(); ++it)
+    other.accumulate(*it);
+
+  disk_io.resize(top_k);
+  disk_io.push_back(std::move(other));
+}
+
+void DiskIoStats::accumulate(const DiskIoStats &other) {
+  double ios = read_iops + write_iops + discard_iops + flush_iops;
+  double other_ios = other.read_iops + other.write_iops +
+                     other.discard_iops + other.flush_iops;
+  auto weighted = [](double a, double wa, double b, double wb) {
+    return (wa + wb) > 0 ? (a * wa + b * wb) / (wa + wb) : 0.0;
+  };
+  await_ms = weighted(await_ms, ios, other.await_ms, other_ios);
+  read_await_ms =
+      weighted(read_await_ms, read_iops, other.read_await_ms, other.read_iops);
+  write_await_ms = weighted(write_await_ms, write_iops, other.write_await_ms,
+                            other.write_iops);
+
+  read_bytes_per_sec += other.read_bytes_per_sec;
+  write_bytes_per_sec += other.write_bytes_per_sec;
+  read_iops += other.read_iops;
+  write_iops += other.write_iops;
+  discard_iops += other.discard_iops;
+  flush_iops += other.flush_iops;
+  avg_queue_size += other.avg_queue_size;
+  in_flight += other.in_flight;
+  util_percent = std::max(util_percent, other.util_percent);
+}
+
+void HdIoStats::accumulate(const HdIoStats &other) {
+  DiskIoStats::accumulate(other);
+  aggregated_devices += std::max<uint32_t>(other.aggregated_devices, 1);
+}
+
+void parse_disk_counters(const char *text, DiskIoSnapshot &snap) {
+  constexpr int FIELD_COUNT = 17;
+  uint64_t v[FIELD_COUNT] = {};
+  // Fields past io_ticks are missing on older kernels and stay zero
+  for (int i = 0; i < FIELD_COUNT; ++i) {
+    char *end;
+    v[i] = std::strtoull(text, &end, 10);
+    if (end == text)
+      break;
+    text = end;
+  }
+
+  snap.reads_completed = v[0];
+  snap.reads_merged = v[1];
+  snap.bytes_read = v[2] * 512;
+  snap.time_reading_ms = v[3];
+  snap.writes_completed = v[4];
+  snap.writes_merged = v[5];
+  snap.bytes_written = v[6] * 512;
+  snap.time_writing_ms = v[7];
+  snap.ios_in_progress = v[8];
+  snap.io_ticks_ms = v[9];
+  snap.weighted_io_ms = v[10];
+  snap.discards_completed = v[11];
+  snap.discards_merged = v[12];
+  snap.sectors_discarded = v[13];
+  snap.time_discarding_ms = v[14];
+  snap.flushes_completed = v[15];
+  snap.time_flushing_ms = v[16];
+}
+
+DiskIoStats calculate_disk_io(const DiskIoSnapshot &prev,
+                              const DiskIoSnapshot &curr,
+                              double time_delta_seconds) {
+  DiskIoStats io;
+  io.in_flight = curr.ios_in_progress;
+  if (time_delta_seconds <= 0)
+    return io;
+
+  const double interval_ms = time_delta_seconds * 1000.0;
+  uint64_t reads = counter_delta(curr.reads_completed, prev.reads_completed);
+  uint64_t writes =
+      counter_delta(curr.writes_completed, prev.writes_completed);
+  uint64_t discards =
+      counter_delta(curr.discards_completed, prev.discards_completed);
+  uint64_t flushes =
+      counter_delta(curr.flushes_completed, prev.flushes_completed);
+  uint64_t read_ms = counter_delta(curr.time_reading_ms, prev.time_reading_ms);
+  uint64_t write_ms =
+      counter_delta(curr.time_writing_ms, prev.time_writing_ms);
+  uint64_t total_ms =
+      read_ms + write_ms +
+      counter_delta(curr.time_discarding_ms, prev.time_discarding_ms) +
+      counter_delta(curr.time_flushing_ms, prev.time_flushing_ms);
+  uint64_t total_ios = reads + writes + discards + flushes;
+
+  io.read_bytes_per_sec = static_cast<uint64_t>(
+      counter_delta(curr.bytes_read, prev.bytes_read) / time_delta_seconds);
+  io.write_bytes_per_sec = static_cast<uint64_t>(
+      counter_delta(curr.bytes_written, prev.bytes_written) /
+      time_delta_seconds);
+  io.read_iops = reads / time_delta_seconds;
+  io.write_iops = writes / time_delta_seconds;
+  io.discard_iops = discards / time_delta_seconds;
+  io.flush_iops = flushes / time_delta_seconds;
+
+  io.util_percent = std::min(
+      100.0,
+      counter_delta(curr.io_ticks_ms, prev.io_ticks_ms) * 100.0 / interval_ms);
+  io.avg_queue_size =
+      counter_delta(curr.weighted_io_ms, prev.weighted_io_ms) / interval_ms;
+
+  if (reads > 0)
+    io.read_await_ms = static_cast<double>(read_ms) / reads;
+  if (writes > 0)
+    io.write_await_ms = static_cast<double>(write_ms) / writes;
+  if (total_ios > 0)
+    io.await_ms = static_cast<double>(total_ms) / total_ios;
+  return io;
+}
+
 DiskIoSnapshotMap DiskPollingTask::read_data(std::istream &diskstats_stream) {
   DiskIoSnapshotMap snapshots;
 
@@ -204,12 +486,8 @@ DiskIoSnapshotMap DiskPollingTask::read_data(std::istream &diskstats_stream) {
     std::istringstream iss(line);
     int major, minor;
     std::string dev_name;
-    uint64_t reads_completed, reads_merged, sectors_read, time_reading;
-    uint64_t writes_completed, writes_merged, sectors_written, time_writing;
 
-    iss >> major >> minor >> dev_name >> reads_completed >> reads_merged >>
-        sectors_read >> time_reading >> writes_completed >> writes_merged >>
-        sectors_written >> time_writing;
+    iss >> major >> minor >> dev_name;
 
     bool keep = false;
 
@@ -246,8 +524,9 @@ DiskIoSnapshotMap DiskPollingTask::read_data(std::istream &diskstats_stream) {
     }
 
     if (keep) {
-      snapshots[dev_name] = {.bytes_read = sectors_read * 512,
-                             .bytes_written = sectors_written * 512};
+      auto pos = iss.tellg();
+      parse_disk_counters(pos < 0 ? "" : line.c_str() + pos,
+                          snapshots[dev_name]);
     }
   }
 
@@ -297,16 +576,22 @@ std::istream &ProcDataStreams::get_mounts_stream() {
   return create_stream_from_command(mounts, "cat /proc/mounts");
 }
 
-DiskUsage LocalDataStreams::get_disk_usage(const std::string &mount_point) {
+DiskUsage query_disk_usage(const std::string &mount_point) {
   struct statvfs stat;
   DiskUsage usage;
   if (!mount_point.empty() && statvfs(mount_point.c_str(), &stat) == 0) {
     usage.used_bytes = (stat.f_blocks - stat.f_bfree) * stat.f_frsize;
     usage.size_bytes = stat.f_blocks * stat.f_frsize;
+    usage.inodes_used = stat.f_files - stat.f_ffree;
+    usage.inodes_total = stat.f_files;
   }
   return usage;
 }
 
+DiskUsage LocalDataStreams::get_disk_usage(const std::string &mount_point) {
+  return query_disk_usage(mount_point);
+}
+
 DiskUsage ProcDataStreams::get_disk_usage(const std::string &mount_point) {
   DiskUsage usage;
   // Execute df command and get the output as a single string.
@@ -337,6 +622,7 @@ DiskUsage ProcDataStreams::get_disk_usage(const std::string &mount_point) {
     try {
       usage.used_bytes = std::stoull(used);
       usage.size_bytes = std::stoull(blocks);
+      return usage;
     } catch (const std::exception &e) {
       std::cerr << "Error parsing numbers from df output: " << e.what()
                 << std::endl;
@@ -415,6 +701,9 @@ std::string LuaStorage::serialize(unsigned indentation_level) const {
 
   gen.lua_vector("filesystems", filesystems);
   gen.lua_vector("io_devices", io_devices);
+  gen.lua_uint("top_k", top_k);
+  gen.lua_uint("usage_interval_ms", usage_interval_ms);
+  gen.lua_uint("usage_timeout_ms", usage_timeout_ms);
 
   // Manual insertion of nested filter string to maintain indentation
   // (Assuming LuaConfigGenerator::lua_string/lua_raw can be used)
@@ -430,6 +719,9 @@ void LuaStorage::deserialize(sol::table storage) {
 
   filesystems = storage.get_or("filesystems", std::vector<std::string>{});
   io_devices = storage.get_or("io_devices", std::vector<std::string>{});
+  top_k = storage.get_or("top_k", top_k);
+  usage_interval_ms = storage.get_or("usage_interval_ms", usage_interval_ms);
+  usage_timeout_ms = storage.get_or("usage_timeout_ms", usage_timeout_ms);
 
   if (storage["filters"].valid()) {
     LuaFilters lf;
@@ -1,5 +1,220 @@
 #include "filesystems.hpp"
 
+#include <poll.h>
+#include <sys/sysmacros.h>
+
+#include <filesystem>
+
+#include "log.hpp"
+
+namespace telemetry {
+
+bool MountTable::open() {
+  if (!file.open("/proc/self/mountinfo"))
+    return false;
+  if (file.read(buffer))
+    load(buffer);
+  return true;
+}
+
+bool MountTable::poll() {
+  if (!file.is_open())
+    return false;
+
+  pollfd pfd{file.get_fd(), POLLPRI, 0};
+  if (::poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLPRI | POLLERR)))
+    return false;
+
+  // Reading the file also re-arms the notification
+  if (!file.read(buffer))
+    return false;
+  load(buffer);
+  return true;
+}
+
+static bool is_octal(char c) { return c >= '0' && c <= '7'; }
+
+// Mount points escape space, tab, newline and backslash as \ooo
+static std::string unescape_mount_path(const std::string &path) {
+  std::string out;
+  out.reserve(path.size());
+  for (size_t i = 0; i < path.size(); ++i) {
+    if (path[i] == '\\' && i + 3 < path.size() && is_octal(path[i + 1]) &&
+        is_octal(path[i + 2]) && is_octal(path[i + 3])) {
+      out += static_cast<char>((path[i + 1] - '0') * 64 +
+                               (path[i + 2] - '0') * 8 + (path[i + 3] - '0'));
+      i += 3;
+    } else {
+      out += path[i];
+    }
+  }
+  return out;
+}
+
+void MountTable::load(const std::string &mountinfo) {
+  // "36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw"
+  mounts.clear();
+  sources.clear();
+  std::istringstream in(mountinfo);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string id, parent, dev, root, mount_point;
+    if (!(fields >> id >> parent >> dev >> root >> mount_point))
+      continue;
+
+    unsigned int major = 0, minor = 0;
+    if (std::sscanf(dev.c_str(), "%u:%u", &major, &minor) != 2)
+      continue;
+
+    // Prefer the mount of the filesystem root over bind mounts of subtrees
+    bool is_root = root == "/";
+    MountEntry entry{unescape_mount_path(mount_point), is_root};
+    auto [it, inserted] = mounts.try_emplace(makedev(major, minor), entry);
+    if (!inserted && is_root && !it->second.is_root)
+      it->second = entry;
+
+    // Optional fields end at " - ", followed by the fstype and the source
+    size_t separator = line.find(" - ");
+    if (separator == std::string::npos)
+      continue;
+    std::istringstream tail(line.substr(separator + 3));
+    std::string fstype, source;
+    if (!(tail >> fstype >> source))
+      continue;
+    source = unescape_mount_path(source);
+    if (source.compare(0, 5, "/dev/") == 0) {
+      // /dev/mapper/root and friends are symlinks to the dm-N node
+      std::error_code error;
+      auto real_path = std::filesystem::canonical(source, error);
+      if (!error)
+        source = real_path.string();
+    }
+    auto [source_it, source_inserted] = sources.try_emplace(source, entry);
+    if (!source_inserted && is_root && !source_it->second.is_root)
+      source_it->second = entry;
+  }
+}
+
+std::string MountTable::find(dev_t device,
+                             const std::string &device_path) const {
+  auto it = mounts.find(device);
+  if (it != mounts.end())
+    return it->second.mount_point;
+  auto source_it = device_path.empty() ? sources.end()
+                                       : sources.find(device_path);
+  return source_it == sources.end() ? "" : source_it->second.mount_point;
+}
+
+UsageRefresher::~UsageRefresher() { stop(); }
+
+void UsageRefresher::start(std::chrono::milliseconds interval,
+                           std::chrono::milliseconds timeout) {
+  stop();
+  this->interval = interval;
+  this->timeout = timeout;
+  stopping = false;
+  thread = std::thread(&UsageRefresher::run, this);
+}
+
+void UsageRefresher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  if (thread.joinable())
+    thread.join();
+}
+
+void UsageRefresher::set_mount_points(
+    const std::vector<std::string> &mount_points) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->mount_points = mount_points;
+    for (auto it = results.begin(); it != results.end();) {
+      bool watched = std::find(mount_points.begin(), mount_points.end(),
+                               it->first) != mount_points.end();
+      it = watched ? std::next(it) : results.erase(it);
+    }
+    mounts_changed = true;
+  }
+  wake.notify_all();
+}
+
+bool UsageRefresher::get(const std::string &mount_point,
+                         DiskUsage &usage) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = results.find(mount_point);
+  if (it == results.end())
+    return false;
+  usage = it->second;
+  return true;
+}
+
+void UsageRefresher::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopping) {
+    mounts_changed = false;
+    std::vector<std::string> mounts = mount_points;
+    lock.unlock();
+
+    for (const auto &mount_point : mounts) {
+      DiskUsage usage = probe(mount_point);
+      std::lock_guard<std::mutex> guard(mutex);
+      if (stopping)
+        break;
+      results[mount_point] = usage;
+    }
+    prune_pending(mounts);
+
+    lock.lock();
+    wake.wait_for(lock, interval,
+                  [this] { return stopping || mounts_changed; });
+  }
+}
+
+// Drops probes of mounts no longer watched, finished or still hung. A
+// packaged_task future does not block in its destructor; a hung statvfs()
+// thread just finishes into the abandoned shared state.
+void UsageRefresher::prune_pending(const std::vector<std::string> &mounts) {
+  for (auto it = pending.begin(); it != pending.end();) {
+    bool watched =
+        std::find(mounts.begin(), mounts.end(), it->first) != mounts.end();
+    it = watched ? std::next(it) : pending.erase(it);
+  }
+}
+
+DiskUsage UsageRefresher::probe(const std::string &mount_point) {
+  if (mount_point.empty())
+    return {};
+
+  // A probe left over from an earlier round is checked without waiting
+  auto wait = timeout;
+  auto it = pending.find(mount_point);
+  if (it == pending.end()) {
+    std::packaged_task<DiskUsage()> task(
+        [mount_point] { return query_disk_usage(mount_point); });
+    it = pending.emplace(mount_point, task.get_future()).first;
+    std::thread(std::move(task)).detach();
+  } else {
+    wait = std::chrono::milliseconds(0);
+  }
+
+  if (it->second.wait_for(wait) == std::future_status::ready) {
+    DiskUsage usage = it->second.get();
+    pending.erase(it);
+    return usage;
+  }
+
+  SPDLOG_DEBUG("Disk: statvfs({}) timed out, marking stale", mount_point);
+  std::lock_guard<std::mutex> lock(mutex);
+  DiskUsage usage = results[mount_point];
+  usage.stale = true;
+  return usage;
+}
+
+}; // namespace telemetry
 
 // uint64_t LocalDataStreams::get_used_space_bytes(
 //     const std::string& mount_point) {
@@ -1,94 +1,258 @@
 // src/systemdata/frag_stats.cpp
 #include "frag_stats.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include "context.hpp"
+#include "log.hpp"
+#include "polling.hpp"
+
 namespace telemetry {
 
-double calculate_fragmentation_index(const std::vector<int> &chunks) {
-  double total_free_pages = 0;
-  double weighted_free_pages = 0;
+namespace {
+
+// Compaction activity reported next to the zones when enabled
+const std::vector<std::string> COMPACTION_COUNTERS = {
+    "compact_stall",
+    "compact_fail",
+    "compact_success",
+    "compact_migrate_scanned",
+    "compact_free_scanned",
+    "compact_daemon_wake",
+};
+
+const char *skip_blanks(const char *pos, const char *end) {
+  while (pos < end && *pos == ' ')
+    ++pos;
+  return pos;
+}
+
+// Reads "Node 0, zone   Normal" and leaves pos just after the zone name
+bool parse_zone_prefix(const char *&pos, const char *end, size_t &node,
+                       std::string_view &zone) {
+  if (end - pos < 5 || std::memcmp(pos, "Node ", 5) != 0)
+    return false;
+  pos = skip_blanks(pos + 5, end);
+  auto result = std::from_chars(pos, end, node);
+  if (result.ec != std::errc())
+    return false;
+
+  std::string_view rest(result.ptr, end - result.ptr);
+  size_t label = rest.find("zone ");
+  if (label == std::string_view::npos)
+    return false;
+  pos = skip_blanks(result.ptr + label + 5, end);
+  const char *name = pos;
+  while (pos < end && *pos != ' ' && *pos != ',')
+    ++pos;
+  zone = std::string_view(name, pos - name);
+  return !zone.empty();
+}
+
+// Returns how many order columns were present; the rest are zeroed
+size_t parse_orders(const char *pos, const char *end, BuddyOrders &blocks) {
+  size_t count = 0;
+  for (; count < BUDDY_MAX_ORDERS; ++count) {
+    pos = skip_blanks(pos, end);
+    auto result = std::from_chars(pos, end, blocks[count]);
+    if (result.ec != std::errc())
+      break;
+    pos = result.ptr;
+  }
+  std::fill(blocks.begin() + count, blocks.end(), 0);
+  return count;
+}
 
-  for (size_t order = 0; order < chunks.size(); ++order) {
-    // Number of pages in this chunk = 2^order
-    double pages_in_chunk = std::pow(2, order);
-    double pages_at_this_order = chunks[order] * pages_in_chunk;
+} // namespace
 
-    total_free_pages += pages_at_this_order;
+double fragmentation_index(const unsigned long long *free_blocks,
+                           size_t orders) {
+  if (orders < 2)
+    return 0.0;
 
+  unsigned long long total_pages = 0;
+  unsigned long long weighted_pages = 0;
+  for (size_t order = 0; order < orders; ++order) {
+    // A block of order n spans 2^n pages
+    unsigned long long pages = free_blocks[order] << order;
+    total_pages += pages;
     // Weighting: Higher orders are "better" (less fragmented).
-    // We subtract the availability of large blocks from the index.
-    weighted_free_pages += (pages_at_this_order * (order / 10.0));
+    weighted_pages += pages * order;
   }
 
-  if (total_free_pages == 0)
+  if (total_pages == 0)
     return 0.0;
 
   // Result is between 0 (contiguous) and 1 (fragmented)
-  return 1.0 - (weighted_free_pages / total_free_pages);
+  return 1.0 - static_cast<double>(weighted_pages) /
+                   (static_cast<double>(total_pages) * (orders - 1));
+}
+
+// Parse: Node 0, zone Normal  1 2 3 4 5 6 7 8 9 10 11
+bool parse_buddyinfo(std::string_view text, BuddyMatrix &matrix) {
+  size_t rows = 0;
+  matrix.orders = 0;
+  const char *pos = text.data();
+  const char *end = pos + text.size();
+  while (pos < end) {
+    const char *eol =
+        static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+    if (eol == nullptr)
+      eol = end;
+
+    size_t node;
+    std::string_view zone;
+    const char *cursor = pos;
+    if (parse_zone_prefix(cursor, eol, node, zone)) {
+      if (rows == matrix.zones.size()) {
+        matrix.zones.push_back({node, std::string(zone)});
+        matrix.free_blocks.emplace_back();
+      } else {
+        BuddyMatrix::Zone &row = matrix.zones[rows];
+        row.node = node;
+        if (row.name != zone)
+          row.name.assign(zone.data(), zone.size());
+      }
+      matrix.orders = std::max(
+          matrix.orders, parse_orders(cursor, eol, matrix.free_blocks[rows]));
+      ++rows;
+    }
+    pos = eol + 1;
+  }
+  matrix.zones.resize(rows);
+  matrix.free_blocks.resize(rows);
+  return rows > 0;
+}
+
+// "Node    0, zone   Normal, type      Movable   8176    289 ..."
+// Only the free page section has a type column; the block counts that
+// follow it are keyed by zone alone and skipped.
+void parse_pagetypeinfo(std::string_view text,
+                        std::vector<ZoneFragmentation> &zones) {
+  std::vector<size_t> types_seen(zones.size(), 0);
+  const char *pos = text.data();
+  const char *end = pos + text.size();
+  while (pos < end) {
+    const char *eol =
+        static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+    if (eol == nullptr)
+      eol = end;
+    const char *line_end = eol;
+    const char *cursor = pos;
+    pos = eol + 1;
+
+    size_t node;
+    std::string_view zone_name;
+    if (!parse_zone_prefix(cursor, line_end, node, zone_name) ||
+        line_end - cursor < 6 || std::memcmp(cursor, ", type", 6) != 0)
+      continue;
+    cursor = skip_blanks(cursor + 6, line_end);
+    const char *type = cursor;
+    while (cursor < line_end && *cursor != ' ')
+      ++cursor;
+    std::string_view type_name(type, cursor - type);
+
+    auto zone = std::find_if(zones.begin(), zones.end(),
+                             [&](const ZoneFragmentation &z) {
+                               return z.node == node && z.zone == zone_name;
+                             });
+    if (zone == zones.end())
+      continue;
+
+    BuddyOrders blocks;
+    size_t orders = parse_orders(cursor, line_end, blocks);
+    unsigned long long pages = 0;
+    for (size_t order = 0; order < orders; ++order)
+      pages += blocks[order] << order;
+
+    size_t &seen = types_seen[zone - zones.begin()];
+    if (seen == zone->migrate_types.size())
+      zone->migrate_types.emplace_back();
+    MigrateTypeFree &entry = zone->migrate_types[seen++];
+    if (entry.type != type_name)
+      entry.type.assign(type_name.data(), type_name.size());
+    entry.free_pages = pages;
+  }
+  for (size_t i = 0; i < zones.size(); ++i)
+    zones[i].migrate_types.resize(types_seen[i]);
 }
 
 MemoryFragmentationTask::MemoryFragmentationTask(DataStreamProvider &p,
                                                  SystemMetrics &m,
                                                  MetricsContext &ctx)
-    : IPollingTask(p, m, ctx) {
+    : IPollingTask(p, m, ctx), compaction(COMPACTION_COUNTERS) {
   name = "Memory Fragmentation";
+  if (ctx.provider != DataStreamProviders::LocalDataStream)
+    return;
+  buddyinfo.open("/proc/buddyinfo");
+  // Root only, and the kernel walks every free list to produce it
+  if (ctx.settings.memory.enable_pagetypeinfo &&
+      !pagetypeinfo.open("/proc/pagetypeinfo"))
+    SPDLOG_WARN("Fragmentation: /proc/pagetypeinfo is not readable");
+  if (ctx.settings.memory.enable_compaction)
+    vmstat.open("/proc/vmstat");
 }
 
 void MemoryFragmentationTask::configure() {}
-void MemoryFragmentationTask::take_initial_snapshot() { take_new_snapshot(); }
+
+bool MemoryFragmentationTask::read_compaction(
+    std::vector<unsigned long long> &values, bool &rebuilt) {
+  rebuilt = false;
+  return vmstat.is_open() && vmstat.read(buffer) &&
+         compaction.update(buffer, values, rebuilt);
+}
+
+void MemoryFragmentationTask::take_initial_snapshot() {
+  set_timestamp();
+  bool rebuilt;
+  if (!read_compaction(prev_compaction, rebuilt))
+    prev_compaction.clear();
+}
 
 void MemoryFragmentationTask::take_new_snapshot() {
-  std::ifstream buddy("/proc/buddyinfo");
-  std::string line;
-  // Parse: Node 0, zone Normal  1 2 3 4 5 6 7 8 9 10 11
-  while (std::getline(buddy, line)) {
-    std::istringstream ss(line);
-    std::string discard, zone;
-    int node;
-    ss >> discard >> node >> discard >> zone;
-
-    int count;
-    long high_order_sum = 0;
-    long total_chunks = 0;
-    for (int i = 0; i < 11; ++i) {
-      ss >> count;
-      total_chunks += count;
-      if (i > 7)
-        high_order_sum += count; // Tracking large contiguous chunks
-    }
-    // If high_order_sum is low relative to total_chunks, fragmentation is
-    // high.
+  set_delta_time();
+  if (!buddyinfo.read(buffer) || !parse_buddyinfo(buffer, buddy)) {
+    buddy.zones.clear();
+    buddy.free_blocks.clear();
   }
+  if (!pagetypeinfo.is_open() || !pagetypeinfo.read(pagetypeinfo_text))
+    pagetypeinfo_text.clear();
+  bool rebuilt;
+  if (!read_compaction(current_compaction, rebuilt))
+    current_compaction.clear();
+  if (rebuilt)
+    prev_compaction.clear();
 }
-void MemoryFragmentationTask::calculate() {
-  std::ifstream buddy("/proc/buddyinfo");
-  std::string line;
-  double global_index_sum = 0.0;
-  int zones_counted = 0;
-
-  while (std::getline(buddy, line)) {
-    std::istringstream ss(line);
-    std::string discard, zone;
-    int node;
-    // Format: Node 0, zone Normal  1 2 3 4 ...
-    ss >> discard >> node >> discard >> zone;
-
-    std::vector<int> chunks;
-    int val;
-    while (ss >> val) {
-      chunks.push_back(val);
-    }
 
-    if (!chunks.empty()) {
-      global_index_sum += calculate_fragmentation_index(chunks);
-      zones_counted++;
+void MemoryFragmentationTask::calculate() {
+  auto &zones = metrics.memory_zones;
+  zones.resize(buddy.zones.size());
+  double index_sum = 0.0;
+  for (size_t row = 0; row < zones.size(); ++row) {
+    ZoneFragmentation &zone = zones[row];
+    const BuddyOrders &blocks = buddy.free_blocks[row];
+    zone.node = buddy.zones[row].node;
+    zone.zone = buddy.zones[row].name;
+    zone.free_pages_by_order.resize(buddy.orders);
+    zone.free_pages = 0;
+    for (size_t order = 0; order < buddy.orders; ++order) {
+      zone.free_pages_by_order[order] = blocks[order] << order;
+      zone.free_pages += zone.free_pages_by_order[order];
     }
+    zone.fragmentation_index = fragmentation_index(blocks.data(), buddy.orders);
+    index_sum += zone.fragmentation_index;
   }
-
-  if (zones_counted > 0) {
+  if (!zones.empty()) {
     // Store the average fragmentation across all zones
-    metrics.stability.memory_fragmentation_index =
-        global_index_sum / zones_counted;
+    metrics.stability.memory_fragmentation_index = index_sum / zones.size();
   }
+
+  parse_pagetypeinfo(pagetypeinfo_text, zones);
+  compute_vmstat_rates(compaction, prev_compaction, current_compaction,
+                       time_delta_seconds, metrics.compaction);
 }
-void MemoryFragmentationTask::commit() {}
+
+void MemoryFragmentationTask::commit() { prev_compaction = current_compaction; }
 }; // namespace telemetry
@@ -1,64 +1,224 @@
 // hwmonitor.cpp
 #include "hwmonitor.hpp"
 
+#include <linux/netlink.h>
+
+#include <cstring>
+
 #include "data_local.hpp"
+#include "log.hpp"
 #include "provider.hpp"
 
 namespace telemetry {
 
+// Kernel uevent broadcasts go to multicast group 1
+constexpr uint32_t UEVENT_KERNEL_GROUP = 1;
+constexpr char HWMON_SUBSYSTEM[] = "SUBSYSTEM=hwmon";
+
+const char *sensor_kind_name(SensorKind kind) {
+  switch (kind) {
+  case SensorKind::Temperature:
+    return "temperature";
+  case SensorKind::Fan:
+    return "fan";
+  case SensorKind::Voltage:
+    return "voltage";
+  case SensorKind::Power:
+    return "power";
+  case SensorKind::Current:
+    return "current";
+  }
+  return "unknown";
+}
+
 double LocalDataStreams::get_cpu_temperature() {
-  const std::string hwmon_base = "/sys/class/hwmon";
-  std::optional<double> fallback_temp; // Fallback to first core/sensor
+  hwmon.refresh();
+  return hwmon.read_cpu_temperature();
+}
 
-  try {
-    for (const auto &hwmon_dir :
-         std::filesystem::directory_iterator(hwmon_base)) {
-      if (!hwmon_dir.is_directory())
-        continue;
+void LocalDataStreams::get_sensors(std::vector<SensorReading> &sensors) {
+  hwmon.refresh();
+  hwmon.read(sensors);
+}
 
-      auto name = read_sysfs_file(hwmon_dir.path() / "name");
-      if (!name || (name.value() != "coretemp" && name.value() != "k10temp" &&
-                    name.value() != "zenpower")) {
-        continue; // Not a known CPU sensor
-      }
+static std::string read_trimmed(const std::filesystem::path &path) {
+  std::ifstream file(path);
+  std::string value;
+  std::getline(file, value);
+  while (!value.empty() &&
+         std::isspace(static_cast<unsigned char>(value.back())))
+    value.pop_back();
+  return value;
+}
+
+// Maps a channel prefix to its kind and the factor from sysfs units
+// (millidegrees, RPM, millivolts, microwatts, milliamps)
+static bool classify_channel(const std::string &prefix, SensorKind &kind,
+                             double &scale) {
+  if (prefix == "temp") {
+    kind = SensorKind::Temperature;
+    scale = 1e-3;
+  } else if (prefix == "fan") {
+    kind = SensorKind::Fan;
+    scale = 1.0;
+  } else if (prefix == "in") {
+    kind = SensorKind::Voltage;
+    scale = 1e-3;
+  } else if (prefix == "power") {
+    kind = SensorKind::Power;
+    scale = 1e-6;
+  } else if (prefix == "curr") {
+    kind = SensorKind::Current;
+    scale = 1e-3;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool is_cpu_chip(const std::string &chip) {
+  return chip == "coretemp" || chip == "k10temp" || chip == "zenpower";
+}
 
-      for (const auto &file :
-           std::filesystem::directory_iterator(hwmon_dir.path())) {
-        std::string filename = file.path().filename().string();
+void HwmonSensors::discover(const std::string &hwmon_base) {
+  channels.clear();
+  cpu_channel = -1;
+  bool cpu_is_package = false;
+  discovered = true;
 
-        if (filename.rfind("temp", 0) == 0 &&
-            filename.rfind("_input") != std::string::npos) {
-          std::string label_filename = filename;
-          label_filename.replace(label_filename.rfind("_input"), 6, "_label");
+  std::error_code ec;
+  std::vector<std::filesystem::path> chips;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(hwmon_base, ec)) {
+    chips.push_back(entry.path());
+  }
+  std::sort(chips.begin(), chips.end());
 
-          auto label = read_sysfs_file(hwmon_dir.path() / label_filename);
-          auto temp_str = read_sysfs_file(file.path());
+  for (const auto &chip_dir : chips) {
+    std::string chip = read_trimmed(chip_dir / "name");
+    if (chip.empty())
+      continue;
 
-          if (!temp_str)
-            continue;
+    std::vector<std::string> inputs;
+    for (const auto &file :
+         std::filesystem::directory_iterator(chip_dir, ec)) {
+      std::string filename = file.path().filename().string();
+      if (filename.size() > 6 &&
+          filename.compare(filename.size() - 6, 6, "_input") == 0)
+        inputs.push_back(filename);
+    }
+    // Natural order within a prefix: temp2 before temp10
+    auto natural_key = [](const std::string &name) {
+      size_t digits = name.find_first_of("0123456789");
+      if (digits == std::string::npos)
+        return std::make_pair(name, 0UL);
+      return std::make_pair(name.substr(0, digits),
+                            std::strtoul(name.c_str() + digits, nullptr, 10));
+    };
+    std::sort(inputs.begin(), inputs.end(),
+              [&](const std::string &a, const std::string &b) {
+                return natural_key(a) < natural_key(b);
+              });
 
-          double temp_celsius = std::stod(temp_str.value()) / 1000.0;
+    for (const auto &filename : inputs) {
+      std::string id = filename.substr(0, filename.size() - 6); // "temp3"
+      size_t digits = id.find_first_of("0123456789");
+      if (digits == std::string::npos)
+        continue;
 
-          if (label) {
-            if (label.value() == "Tdie" || label.value() == "Package id 0") {
-              return temp_celsius; // Found package temp
-            }
-          }
-          if (!fallback_temp) {
-            fallback_temp = temp_celsius;
-          }
+      Channel channel;
+      if (!classify_channel(id.substr(0, digits), channel.reading.kind,
+                            channel.scale))
+        continue;
+      if (!channel.input.open((chip_dir / filename).string()))
+        continue;
+
+      channel.reading.chip = chip;
+      channel.reading.label = read_trimmed(chip_dir / (id + "_label"));
+      if (channel.reading.label.empty())
+        channel.reading.label = id;
+
+      // The first package sensor wins, else the first CPU sensor
+      if (channel.reading.kind == SensorKind::Temperature &&
+          is_cpu_chip(chip)) {
+        const std::string &label = channel.reading.label;
+        bool package = label == "Tdie" || label == "Package id 0";
+        if (cpu_channel < 0 || (package && !cpu_is_package)) {
+          cpu_channel = static_cast<int>(channels.size());
+          cpu_is_package = package;
         }
       }
+      channels.push_back(std::move(channel));
     }
-  } catch (const std::exception &e) {
-    std::cerr << "Error reading temperature: " << e.what() << std::endl;
-    return -1.0;
   }
+  SPDLOG_DEBUG("Hwmon: discovered {} channels", channels.size());
+}
 
-  if (fallback_temp) {
-    return fallback_temp.value();
+void HwmonSensors::refresh() {
+  if (!discovered) {
+    uevents.open(NETLINK_KOBJECT_UEVENT, UEVENT_KERNEL_GROUP);
+    discover();
+    return;
   }
+  if (hotplug_pending())
+    discover();
+}
+
+bool HwmonSensors::hotplug_pending() {
+  if (!uevents.is_open())
+    return false;
+
+  bool changed = false;
+  for (;;) {
+    ssize_t len = uevents.receive(uevent_buffer);
+    if (len == 0)
+      break;
+    if (len < 0)
+      return true; // Dropped events; rediscover to be safe
 
-  return -1.0; // Not found
+    // "add@/devices/.../hwmon/hwmon3\0ACTION=add\0...SUBSYSTEM=hwmon\0..."
+    const char *data = uevent_buffer.data();
+    for (ssize_t pos = 0; pos < len;) {
+      const char *field = data + pos;
+      size_t field_len = strnlen(field, static_cast<size_t>(len - pos));
+      if (field_len == sizeof(HWMON_SUBSYSTEM) - 1 &&
+          std::memcmp(field, HWMON_SUBSYSTEM, field_len) == 0)
+        changed = true;
+      pos += static_cast<ssize_t>(field_len) + 1;
+    }
+  }
+  return changed;
 }
+
+bool HwmonSensors::read_channel(const Channel &channel, double &value) {
+  if (!channel.input.read(buffer) || buffer.empty())
+    return false;
+  char *end;
+  double raw = std::strtod(buffer.c_str(), &end);
+  if (end == buffer.c_str())
+    return false;
+  value = raw * channel.scale;
+  return true;
+}
+
+void HwmonSensors::read(std::vector<SensorReading> &out) {
+  out.clear();
+  out.reserve(channels.size());
+  for (const auto &channel : channels) {
+    // Channels of a removed device fail until the next discovery
+    double value;
+    if (!read_channel(channel, value))
+      continue;
+    out.push_back(channel.reading);
+    out.back().value = value;
+  }
+}
+
+double HwmonSensors::read_cpu_temperature() {
+  double value;
+  if (cpu_channel < 0 || !read_channel(channels[cpu_channel], value))
+    return -1.0;
+  return value;
+}
+
 }; // namespace telemetry
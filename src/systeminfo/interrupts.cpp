@@ -0,0 +1,265 @@
+// interrupts.cpp
+#include "interrupts.hpp"
+
+#include <charconv>
+#include <numeric>
+
+#include "context.hpp"
+#include "log.hpp"
+#include "lua_generator.hpp"
+#include "polling.hpp"
+
+namespace telemetry {
+
+namespace {
+
+bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+// Leaves an unchanged label alone so a steady layout never allocates
+void assign_if_changed(std::string &target, std::string_view value) {
+  if (target != value)
+    target.assign(value.data(), value.size());
+}
+
+// The kernel pads descriptions into columns; emit single spaces instead
+void collapse_spaces(const std::string &text, std::string &out) {
+  out.clear();
+  for (char c : text) {
+    if (!is_blank(c))
+      out.push_back(c);
+    else if (!out.empty() && out.back() != ' ')
+      out.push_back(' ');
+  }
+}
+
+void emit_row(const CounterMatrix &matrix, const float *rates, size_t row,
+              InterruptRate &out) {
+  const float *begin = rates + row * matrix.columns();
+  const float *end = begin + matrix.columns();
+  out.name = matrix.names[row];
+  collapse_spaces(matrix.descriptions[row], out.description);
+  out.per_cpu.assign(begin, end);
+  out.per_sec = std::accumulate(begin, end, 0.0);
+}
+
+} // namespace
+
+bool CounterMatrix::same_layout(const CounterMatrix &other) const {
+  return cpus == other.cpus && names == other.names;
+}
+
+void CounterMatrix::clear() {
+  cpus.clear();
+  names.clear();
+  descriptions.clear();
+  counts.clear();
+}
+
+// The header lists the online CPUs ("CPU0 CPU1 ..."); every other line is
+// "label: count count ... [description]". Rows such as ERR and MIS carry a
+// single count, which lands in the first column.
+bool parse_counter_matrix(std::string_view text, CounterMatrix &matrix) {
+  size_t end = text.find('\n');
+  if (end == std::string_view::npos)
+    return false;
+
+  std::string_view header = text.substr(0, end);
+  size_t columns = 0;
+  for (size_t pos = header.find("CPU"); pos != std::string_view::npos;
+       pos = header.find("CPU", pos)) {
+    pos += 3;
+    size_t cpu = 0;
+    std::from_chars(header.data() + pos, header.data() + header.size(), cpu);
+    if (columns < matrix.cpus.size())
+      matrix.cpus[columns] = cpu;
+    else
+      matrix.cpus.push_back(cpu);
+    ++columns;
+  }
+  matrix.cpus.resize(columns);
+  if (columns == 0)
+    return false;
+
+  size_t rows = 0;
+  for (size_t start = end + 1; start < text.size(); start = end + 1) {
+    end = text.find('\n', start);
+    if (end == std::string_view::npos)
+      end = text.size();
+    std::string_view line = text.substr(start, end - start);
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+      continue;
+    size_t label = line.find_first_not_of(" \t");
+    std::string_view name = line.substr(label, colon - label);
+
+    if (rows == matrix.names.size()) {
+      matrix.names.emplace_back(name);
+      matrix.descriptions.emplace_back();
+    } else {
+      assign_if_changed(matrix.names[rows], name);
+    }
+    matrix.counts.resize((rows + 1) * columns);
+    unsigned long long *row = &matrix.counts[rows * columns];
+
+    const char *pos = line.data() + colon + 1;
+    const char *line_end = line.data() + line.size();
+    size_t column = 0;
+    for (; column < columns; ++column) {
+      while (pos < line_end && is_blank(*pos))
+        ++pos;
+      auto result = std::from_chars(pos, line_end, row[column]);
+      if (result.ec != std::errc())
+        break;
+      pos = result.ptr;
+    }
+    for (; column < columns; ++column)
+      row[column] = 0;
+
+    while (pos < line_end && is_blank(*pos))
+      ++pos;
+    while (line_end > pos && is_blank(line_end[-1]))
+      --line_end;
+    assign_if_changed(matrix.descriptions[rows],
+                      std::string_view(pos, line_end - pos));
+    ++rows;
+  }
+
+  matrix.names.resize(rows);
+  matrix.descriptions.resize(rows);
+  matrix.counts.resize(rows * columns);
+  return rows > 0;
+}
+
+void compute_counter_rates(const unsigned long long *prev,
+                           const unsigned long long *curr, size_t count,
+                           double seconds, float *out) {
+  float scale = seconds > 0.0 ? static_cast<float>(1.0 / seconds) : 0.0f;
+  // Branch-free over the flattened matrix and kept to 32-bit lanes after
+  // the subtraction, so it vectorizes even without 64-bit vector compares.
+  // A counter that went backwards wraps to a delta of 2^31 or more and is
+  // masked to zero along with (implausible) larger per-tick deltas.
+  for (size_t i = 0; i < count; ++i) {
+    unsigned long long delta = curr[i] - prev[i];
+    uint32_t high = static_cast<uint32_t>(delta >> 31);
+    int32_t low = static_cast<int32_t>(delta & 0x7fffffff);
+    int32_t keep = -static_cast<int32_t>(high == 0);
+    out[i] = static_cast<float>(low & keep) * scale;
+  }
+}
+
+std::string LuaInterrupts::serialize(unsigned indentation_level) const {
+  LuaConfigGenerator gen("interrupts", indentation_level);
+  gen.lua_uint("top_k", top_k);
+  return gen.str();
+}
+
+void LuaInterrupts::deserialize(sol::table interrupts) {
+  if (!interrupts.valid())
+    return;
+  top_k = interrupts.get_or("top_k", top_k);
+}
+
+InterruptsPollingTask::InterruptsPollingTask(DataStreamProvider &provider,
+                                             SystemMetrics &metrics,
+                                             MetricsContext &context)
+    : IPollingTask(provider, metrics, context),
+      top_k(context.settings.interrupts.top_k) {
+  name = "Interrupts polling";
+  if (context.provider == DataStreamProviders::LocalDataStream) {
+    interrupts_file.open("/proc/interrupts");
+    softirqs_file.open("/proc/softirqs");
+  }
+}
+
+void InterruptsPollingTask::read_matrix(const ProcFile &file,
+                                        CounterMatrix &matrix) {
+  if (!file.read(buffer) || !parse_counter_matrix(buffer, matrix))
+    matrix.clear();
+}
+
+void InterruptsPollingTask::take_initial_snapshot() {
+  set_timestamp();
+  read_matrix(interrupts_file, prev_irqs);
+  read_matrix(softirqs_file, prev_softirqs);
+}
+
+void InterruptsPollingTask::take_new_snapshot() {
+  set_delta_time();
+  read_matrix(interrupts_file, current_irqs);
+  read_matrix(softirqs_file, current_softirqs);
+}
+
+void InterruptsPollingTask::compute_rates(const CounterMatrix &prev,
+                                          const CounterMatrix &curr,
+                                          std::vector<float> &rates) {
+  rates.resize(curr.counts.size());
+  if (!prev.same_layout(curr)) {
+    std::fill(rates.begin(), rates.end(), 0.0f);
+    return;
+  }
+  compute_counter_rates(prev.counts.data(), curr.counts.data(), rates.size(),
+                        time_delta_seconds, rates.data());
+}
+
+void InterruptsPollingTask::calculate() {
+  compute_rates(prev_irqs, current_irqs, irq_rates);
+  compute_rates(prev_softirqs, current_softirqs, softirq_rates);
+  metrics.interrupt_cpus = current_irqs.cpus;
+  metrics.softirq_cpus = current_softirqs.cpus;
+
+  metrics.softirqs.resize(current_softirqs.rows());
+  for (size_t row = 0; row < current_softirqs.rows(); ++row)
+    emit_row(current_softirqs, softirq_rates.data(), row,
+             metrics.softirqs[row]);
+
+  select_top_k();
+}
+
+void InterruptsPollingTask::select_top_k() {
+  size_t rows = current_irqs.rows();
+  size_t columns = current_irqs.columns();
+  bool folded = top_k != 0 && rows > top_k;
+  size_t shown = folded ? top_k : rows;
+
+  order.resize(rows);
+  std::iota(order.begin(), order.end(), 0);
+  if (folded) {
+    row_totals.resize(rows);
+    for (size_t row = 0; row < rows; ++row) {
+      const float *begin = irq_rates.data() + row * columns;
+      row_totals[row] = std::accumulate(begin, begin + columns, 0.0f);
+    }
+    std::partial_sort(order.begin(), order.begin() + shown, order.end(),
+                      [&](size_t a, size_t b) {
+                        if (row_totals[a] != row_totals[b])
+                          return row_totals[a] > row_totals[b];
+                        return a < b; // Stable output on ties
+                      });
+  }
+
+  metrics.interrupts.resize(folded ? shown + 1 : shown);
+  for (size_t i = 0; i < shown; ++i)
+    emit_row(current_irqs, irq_rates.data(), order[i], metrics.interrupts[i]);
+  if (!folded)
+    return;
+
+  InterruptRate &other = metrics.interrupts.back();
+  other.name = "other";
+  other.description.clear();
+  other.per_cpu.assign(columns, 0.0f);
+  for (size_t i = shown; i < rows; ++i) {
+    const float *row = irq_rates.data() + order[i] * columns;
+    for (size_t column = 0; column < columns; ++column)
+      other.per_cpu[column] += row[column];
+  }
+  other.per_sec =
+      std::accumulate(other.per_cpu.begin(), other.per_cpu.end(), 0.0);
+}
+
+void InterruptsPollingTask::commit() {
+  // Swapped rather than copied; the next parse overwrites current in place
+  std::swap(prev_irqs, current_irqs);
+  std::swap(prev_softirqs, current_softirqs);
+}
+
+}; // namespace telemetry
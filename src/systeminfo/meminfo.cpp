@@ -1,8 +1,14 @@
 // meminfo.cpp
 #include "meminfo.hpp"
 
+#include <cstring>
+
+#include "context.hpp"
 #include "data_local.hpp"
 #include "data_ssh.hpp"
+#include "log.hpp"
+#include "lua_generator.hpp"
+#include "polling.hpp"
 
 namespace telemetry {
 
@@ -14,25 +20,146 @@ std::istream &ProcDataStreams::get_meminfo_stream() {
   return create_stream_from_command(meminfo, "cat /proc/meminfo");
 }
 
-void get_mem_usage(std::istream &input_stream, MemInfo &meminfo,
-                   MemInfo &swapinfo) {
-  std::string label;
-  long mem_total = -1, mem_available = -1, swap_total = -1, swap_free = -1;
-  while (input_stream >> label) {
-    if (label == "MemTotal:")
-      input_stream >> mem_total;
-    else if (label == "MemAvailable:")
-      input_stream >> mem_available;
-    else if (label == "SwapTotal:")
-      input_stream >> swap_total;
-    else if (label == "SwapFree:")
-      input_stream >> swap_free;
-
-    if (mem_total != -1 && mem_available != -1 && swap_total != -1 &&
-        swap_free != -1)
+namespace {
+
+constexpr std::string_view MEMINFO_LABELS[] = {
+#define MEMINFO_LABEL(id, label) label,
+    MEMINFO_FIELDS(MEMINFO_LABEL)
+#undef MEMINFO_LABEL
+};
+
+// The length and three bytes of a label are enough to tell all known
+// labels apart, so hashing costs the same for every line. A multiplicative
+// hash spreads those bytes and its top bits index the table.
+constexpr size_t HASH_BITS = 8;
+constexpr size_t HASH_SLOTS = size_t{1} << HASH_BITS;
+
+constexpr uint32_t label_key(std::string_view label) {
+  size_t n = label.size();
+  return static_cast<unsigned char>(label[n - 2]) |
+         static_cast<uint32_t>(n & 0xff) << 8 |
+         static_cast<uint32_t>(static_cast<unsigned char>(label[0])) << 16 |
+         static_cast<uint32_t>(static_cast<unsigned char>(label[n - 1]))
+             << 24;
+}
+
+constexpr size_t hash_slot(uint32_t key, uint32_t seed) {
+  return static_cast<uint32_t>(key * seed) >> (32 - HASH_BITS);
+}
+
+constexpr bool is_perfect(uint32_t seed) {
+  bool used[HASH_SLOTS] = {};
+  for (std::string_view label : MEMINFO_LABELS) {
+    size_t slot = hash_slot(label_key(label), seed);
+    if (used[slot])
+      return false;
+    used[slot] = true;
+  }
+  return true;
+}
+
+// The search starts at the last known good seed, so it costs one probe;
+// after a label is added it keeps looking from there.
+constexpr uint32_t SEED_HINT = 114449;
+constexpr uint32_t find_seed() {
+  for (uint32_t seed = SEED_HINT; seed < SEED_HINT + 200000; seed += 2) {
+    if (is_perfect(seed))
+      return seed;
+  }
+  return 0;
+}
+
+constexpr uint32_t HASH_SEED = find_seed();
+static_assert(HASH_SEED != 0, "no perfect hash seed for the meminfo labels");
+
+// Slot -> field index + 1; 0 marks an empty slot
+constexpr std::array<uint8_t, HASH_SLOTS> build_table() {
+  std::array<uint8_t, HASH_SLOTS> table{};
+  for (size_t i = 0; i < MEMINFO_FIELD_COUNT; ++i)
+    table[hash_slot(label_key(MEMINFO_LABELS[i]), HASH_SEED)] =
+        static_cast<uint8_t>(i + 1);
+  return table;
+}
+
+constexpr std::array<uint8_t, HASH_SLOTS> HASH_TABLE = build_table();
+
+// A hash hit still needs the label check: labels from newer kernels may
+// land on an occupied slot.
+bool lookup(std::string_view label, MemInfoField &field) {
+  if (label.size() < 2)
+    return false;
+  uint8_t entry = HASH_TABLE[hash_slot(label_key(label), HASH_SEED)];
+  if (entry == 0 || MEMINFO_LABELS[entry - 1] != label)
+    return false;
+  field = static_cast<MemInfoField>(entry - 1);
+  return true;
+}
+
+} // namespace
+
+const char *meminfo_field_name(MemInfoField field) {
+  return MEMINFO_LABELS[static_cast<size_t>(field)].data();
+}
+
+bool meminfo_field_from_name(std::string_view label, MemInfoField &field) {
+  return lookup(label, field);
+}
+
+void parse_meminfo(std::string_view text, MemInfoFields &fields) {
+  fields.values.fill(0);
+  const char *p = text.data();
+  const char *end = p + text.size();
+  while (p < end) {
+    const char *colon = static_cast<const char *>(std::memchr(p, ':', end - p));
+    if (colon == nullptr)
       break;
-    input_stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    // "Label:      1234 kB"; the padding is skipped only for known labels
+    const char *cursor = colon + 1;
+    MemInfoField field;
+    if (lookup(std::string_view(p, static_cast<size_t>(colon - p)), field)) {
+      while (cursor < end && *cursor == ' ')
+        ++cursor;
+      unsigned long long value = 0;
+      while (cursor < end && *cursor >= '0' && *cursor <= '9')
+        value = value * 10 + static_cast<unsigned>(*cursor++ - '0');
+      fields.values[static_cast<size_t>(field)] = value;
+    }
+
+    const char *newline =
+        static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+    if (newline == nullptr)
+      break;
+    p = newline + 1;
   }
+}
+
+void read_meminfo(std::istream &input_stream, std::string &buffer,
+                  MemInfoFields &fields) {
+  // /proc/meminfo is about 1.5 KiB; grow only if a kernel ever exceeds 4
+  if (buffer.size() < 4096)
+    buffer.resize(4096);
+  size_t total = 0;
+  for (;;) {
+    if (total == buffer.size())
+      buffer.resize(buffer.size() * 2);
+    input_stream.read(&buffer[total],
+                      static_cast<std::streamsize>(buffer.size() - total));
+    std::streamsize count = input_stream.gcount();
+    if (count <= 0)
+      break;
+    total += static_cast<size_t>(count);
+  }
+  parse_meminfo(std::string_view(buffer.data(), total), fields);
+}
+
+void summarize_meminfo(const MemInfoFields &fields, MemInfo &meminfo,
+                       MemInfo &swapinfo) {
+  long mem_total = static_cast<long>(fields[MemInfoField::MemTotal]);
+  long mem_available = static_cast<long>(fields[MemInfoField::MemAvailable]);
+  long swap_total = static_cast<long>(fields[MemInfoField::SwapTotal]);
+  long swap_free = static_cast<long>(fields[MemInfoField::SwapFree]);
+
   meminfo.total_kb = mem_total;
   meminfo.used_kb = mem_total - mem_available;
   meminfo.percent =
@@ -45,4 +172,181 @@ void get_mem_usage(std::istream &input_stream, MemInfo &meminfo,
                          : (100 * swapinfo.used_kb / swapinfo.total_kb);
 }
 
+void get_mem_usage(std::istream &input_stream, MemInfo &meminfo,
+                   MemInfo &swapinfo) {
+  std::string buffer;
+  MemInfoFields fields;
+  read_meminfo(input_stream, buffer, fields);
+  summarize_meminfo(fields, meminfo, swapinfo);
+}
+
+std::vector<MemInfoField>
+select_meminfo_fields(const std::vector<std::string> &names) {
+  std::vector<MemInfoField> selected;
+  for (const auto &name : names) {
+    if (name == "*") {
+      selected.clear();
+      for (size_t i = 0; i < MEMINFO_FIELD_COUNT; ++i)
+        selected.push_back(static_cast<MemInfoField>(i));
+      return selected;
+    }
+    MemInfoField field;
+    if (meminfo_field_from_name(name, field))
+      selected.push_back(field);
+    else
+      SPDLOG_WARN("Memory: unknown meminfo field '{}'", name);
+  }
+  return selected;
+}
+
+std::string LuaMemory::serialize(unsigned indentation_level) const {
+  LuaConfigGenerator gen("memory", indentation_level);
+  gen.lua_vector("fields", fields);
+  gen.lua_bool("enable_pagetypeinfo", enable_pagetypeinfo);
+  gen.lua_bool("enable_compaction", enable_compaction);
+  return gen.str();
+}
+
+void LuaMemory::deserialize(sol::table memory) {
+  if (!memory.valid())
+    return;
+  fields = memory.get_or("fields", fields);
+  enable_pagetypeinfo =
+      memory.get_or("enable_pagetypeinfo", enable_pagetypeinfo);
+  enable_compaction = memory.get_or("enable_compaction", enable_compaction);
+}
+
+// Each line is "Node 0 MemTotal:       16318312 kB"
+void parse_node_meminfo(const std::string &text, NumaNodeSnapshot &snapshot) {
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos)
+      end = text.size();
+    size_t colon = text.find(':', start);
+    if (colon < end) {
+      size_t key_start = text.rfind(' ', colon);
+      key_start = key_start == std::string::npos || key_start < start
+                      ? start
+                      : key_start + 1;
+      std::string_view key(text.data() + key_start, colon - key_start);
+      long value = std::strtol(text.c_str() + colon + 1, nullptr, 10);
+      if (key == "MemTotal")
+        snapshot.total_kb = value;
+      else if (key == "MemFree")
+        snapshot.free_kb = value;
+      else if (key == "FilePages")
+        snapshot.file_kb = value;
+    }
+    start = end + 1;
+  }
+}
+
+// Each line is "numa_miss 1234"
+void parse_numastat(const std::string &text, NumaNodeSnapshot &snapshot) {
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos)
+      end = text.size();
+    size_t space = text.find(' ', start);
+    if (space < end) {
+      std::string_view key(text.data() + start, space - start);
+      unsigned long long value =
+          std::strtoull(text.c_str() + space + 1, nullptr, 10);
+      if (key == "numa_miss")
+        snapshot.numa_miss = value;
+      else if (key == "numa_foreign")
+        snapshot.numa_foreign = value;
+    }
+    start = end + 1;
+  }
+}
+
+NumaMemoryPollingTask::NumaMemoryPollingTask(DataStreamProvider &provider,
+                                             SystemMetrics &metrics,
+                                             MetricsContext &context)
+    : IPollingTask(provider, metrics, context) {
+  name = "NUMA memory polling";
+  if (context.provider == DataStreamProviders::LocalDataStream)
+    discover();
+}
+
+void NumaMemoryPollingTask::discover(const std::string &node_base) {
+  nodes.clear();
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(node_base, ec)) {
+    std::string dirname = entry.path().filename().string();
+    if (dirname.size() < 5 || dirname.compare(0, 4, "node") != 0 ||
+        !std::isdigit(static_cast<unsigned char>(dirname[4])))
+      continue;
+
+    NodeFiles files;
+    files.node = std::strtoul(dirname.c_str() + 4, nullptr, 10);
+    if (!files.meminfo.open((entry.path() / "meminfo").string()))
+      continue;
+    files.numastat.open((entry.path() / "numastat").string());
+    nodes.push_back(std::move(files));
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const NodeFiles &a, const NodeFiles &b) {
+              return a.node < b.node;
+            });
+  SPDLOG_DEBUG("NUMA memory: {} nodes", nodes.size());
+}
+
+std::vector<NumaNodeSnapshot> NumaMemoryPollingTask::read_snapshot() {
+  std::vector<NumaNodeSnapshot> snapshots(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (nodes[i].meminfo.read(buffer))
+      parse_node_meminfo(buffer, snapshots[i]);
+    if (nodes[i].numastat.read(buffer))
+      parse_numastat(buffer, snapshots[i]);
+  }
+  return snapshots;
+}
+
+void NumaMemoryPollingTask::take_initial_snapshot() {
+  set_timestamp();
+  prev_snapshots = read_snapshot();
+}
+
+void NumaMemoryPollingTask::take_new_snapshot() {
+  set_delta_time();
+  current_snapshots = read_snapshot();
+}
+
+void NumaMemoryPollingTask::calculate() {
+  bool have_rates = prev_snapshots.size() == current_snapshots.size() &&
+                    time_delta_seconds > 0.0;
+  metrics.numa_memory.resize(current_snapshots.size());
+  for (size_t i = 0; i < current_snapshots.size(); ++i) {
+    const NumaNodeSnapshot &curr = current_snapshots[i];
+    NumaNodeMemory &node = metrics.numa_memory[i];
+    node.node = nodes[i].node;
+    node.total_kb = curr.total_kb;
+    node.free_kb = curr.free_kb;
+    node.used_kb = curr.total_kb - curr.free_kb;
+    node.file_kb = curr.file_kb;
+    node.percent = curr.total_kb == 0
+                       ? 0
+                       : static_cast<int>(100 * node.used_kb / curr.total_kb);
+
+    node.numa_miss_per_sec = 0.0;
+    node.numa_foreign_per_sec = 0.0;
+    if (!have_rates)
+      continue;
+    const NumaNodeSnapshot &prev = prev_snapshots[i];
+    if (curr.numa_miss >= prev.numa_miss)
+      node.numa_miss_per_sec =
+          (curr.numa_miss - prev.numa_miss) / time_delta_seconds;
+    if (curr.numa_foreign >= prev.numa_foreign)
+      node.numa_foreign_per_sec =
+          (curr.numa_foreign - prev.numa_foreign) / time_delta_seconds;
+  }
+}
+
+void NumaMemoryPollingTask::commit() { prev_snapshots = current_snapshots; }
+
 }; // namespace telemetry
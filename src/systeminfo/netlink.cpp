@@ -0,0 +1,120 @@
+// netlink.cpp
+#include "netlink.hpp"
+
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "log.hpp"
+
+namespace telemetry {
+
+// Large enough for a full page of dump messages from the kernel
+constexpr size_t NETLINK_BUFFER_SIZE = 32768;
+
+NetlinkSocket::~NetlinkSocket() { close(); }
+
+NetlinkSocket::NetlinkSocket(NetlinkSocket &&other) noexcept
+    : fd(other.fd), sequence(other.sequence) {
+  other.fd = -1;
+}
+
+NetlinkSocket &NetlinkSocket::operator=(NetlinkSocket &&other) noexcept {
+  if (this != &other) {
+    close();
+    fd = other.fd;
+    sequence = other.sequence;
+    other.fd = -1;
+  }
+  return *this;
+}
+
+bool NetlinkSocket::open(int protocol, uint32_t groups, bool nonblocking) {
+  close();
+
+  int flags = SOCK_RAW | SOCK_CLOEXEC;
+  if (nonblocking)
+    flags |= SOCK_NONBLOCK;
+
+  fd = ::socket(AF_NETLINK, flags, protocol);
+  if (fd < 0) {
+    SPDLOG_WARN("Netlink: socket(protocol {}) failed: {}", protocol,
+                std::strerror(errno));
+    return false;
+  }
+
+  sockaddr_nl addr{};
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = groups;
+  if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+    SPDLOG_WARN("Netlink: bind(groups {:#x}) failed: {}", groups,
+                std::strerror(errno));
+    close();
+    return false;
+  }
+  return true;
+}
+
+void NetlinkSocket::close() {
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+bool NetlinkSocket::set_receive_timeout(int milliseconds) {
+  if (fd < 0)
+    return false;
+
+  timeval tv{};
+  tv.tv_sec = milliseconds / 1000;
+  tv.tv_usec = (milliseconds % 1000) * 1000;
+  return ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0;
+}
+
+bool NetlinkSocket::set_receive_buffer(int bytes) {
+  if (fd < 0)
+    return false;
+
+  // SO_RCVBUFFORCE ignores net.core.rmem_max but needs CAP_NET_ADMIN
+  if (::setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &bytes, sizeof(bytes)) ==
+      0)
+    return true;
+  return ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes)) == 0;
+}
+
+bool NetlinkSocket::send(const void *message, size_t length) {
+  if (fd < 0)
+    return false;
+
+  sockaddr_nl kernel{};
+  kernel.nl_family = AF_NETLINK;
+  ssize_t sent =
+      ::sendto(fd, message, length, 0, reinterpret_cast<sockaddr *>(&kernel),
+               sizeof(kernel));
+  return sent == static_cast<ssize_t>(length);
+}
+
+ssize_t NetlinkSocket::receive(std::vector<char> &buffer) {
+  if (fd < 0)
+    return -1;
+
+  if (buffer.size() < NETLINK_BUFFER_SIZE)
+    buffer.resize(NETLINK_BUFFER_SIZE);
+
+  ssize_t len = ::recv(fd, buffer.data(), buffer.size(), 0);
+  if (len < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      return 0;
+    // ENOBUFS means notifications were dropped; callers treat any error as
+    // "state unknown" and resynchronize.
+    return -1;
+  }
+  return len;
+}
+
+}; // namespace telemetry
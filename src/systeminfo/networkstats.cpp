@@ -2,11 +2,16 @@
 #include "networkstats.hpp"
 
 #include <arpa/inet.h>
+#include <fnmatch.h>
 #include <ifaddrs.h>
-#include <netdb.h>
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
 
+#include "context.hpp"
 #include "data_local.hpp"
 #include "data_ssh.hpp"
+#include "log.hpp"
 #include "lua_generator.hpp"
 #include "metrics.hpp"
 #include "pcn.hpp"
@@ -15,6 +20,9 @@
 
 namespace telemetry {
 
+// Consecutive failed RTM_GETLINK reads before /proc/net/dev is used for good
+constexpr unsigned LINK_STATS_MAX_FAILURES = 3;
+
 std::istream &LocalDataStreams::get_net_dev_stream() {
   return create_stream_from_file(net_dev, "/proc/net/dev");
 }
@@ -28,16 +36,54 @@ NetworkPollingTask::NetworkPollingTask(DataStreamProvider &provider,
                                        MetricsContext &context)
     : IPollingTask(provider, metrics, context) {
   name = "Network polling";
+  // Addresses come from the local kernel, so they only describe the
+  // interfaces being polled when the provider is local as well.
+  resolve_addresses =
+      context.provider == DataStreamProviders::LocalDataStream;
+  filter = InterfaceFilter(context.interfaces);
+  top_k = context.settings.network.top_k;
 }
 
 void NetworkPollingTask::take_initial_snapshot() {
+  if (resolve_addresses) {
+    address_cache.open();
+    link_stats.open();
+  }
   set_timestamp();
-  prev_snapshot = read_data(provider.get_net_dev_stream());
+  prev_snapshot = read_snapshot();
 }
 
 void NetworkPollingTask::take_new_snapshot() {
   set_delta_time();
-  current_snapshot = read_data(provider.get_net_dev_stream());
+  current_snapshot = read_snapshot();
+}
+
+NetworkSnapshotMap NetworkPollingTask::read_snapshot() {
+  if (link_stats.is_open()) {
+    NetworkSnapshotMap snapshots;
+    if (link_stats.read(filter, snapshots)) {
+      link_stats_failures = 0;
+      counter_width = CounterWidth::Bits64;
+      return snapshots;
+    }
+    // A timeout or dropped reply can be transient; this tick is read from
+    // /proc/net/dev and netlink is only given up after repeated failures.
+    if (++link_stats_failures < LINK_STATS_MAX_FAILURES) {
+      SPDLOG_DEBUG("Network: RTM_GETLINK failed ({} in a row)",
+                   link_stats_failures);
+    } else {
+      SPDLOG_WARN("Network: RTM_GETLINK failed {} times, falling back to "
+                  "/proc/net/dev",
+                  link_stats_failures);
+      link_stats = LinkStatsReader();
+    }
+  }
+  // /proc/net/dev prints the drivers' unsigned long counters, which only
+  // wrap at 2^32 on a 32-bit kernel. The width of a remote host is unknown.
+  counter_width = resolve_addresses && sizeof(unsigned long) == 4
+                      ? CounterWidth::Bits32
+                      : CounterWidth::Bits64;
+  return read_data(provider.get_net_dev_stream());
 }
 void NetworkPollingTask::commit() {
   prev_snapshot = current_snapshot; // Note: singular 'snapshot' based on your
@@ -65,16 +111,17 @@ NetworkSnapshotMap NetworkPollingTask::read_data(std::istream &net_dev_stream) {
       continue; // Invalid line format
     }
 
+    if (!filter.matches(interface_part.c_str()))
+      continue;
+
     NetworkSnapshot snap;
     snap.interface_name = interface_part;
 
-    // Read received stats
-    unsigned long long temp_val;
-    ss >> snap.rx_bytes >> snap.rx_packets >> temp_val >> temp_val >>
-        temp_val >> temp_val >> temp_val >> temp_val; // Skip errs, drop, etc.
-
-    // Read transmitted stats
-    ss >> snap.tx_bytes >> snap.tx_packets; // Only need these two
+    ss >> snap.rx_bytes >> snap.rx_packets >> snap.rx_errs >> snap.rx_drop >>
+        snap.rx_fifo >> snap.rx_frame >> snap.rx_compressed >>
+        snap.rx_multicast;
+    ss >> snap.tx_bytes >> snap.tx_packets >> snap.tx_errs >> snap.tx_drop >>
+        snap.tx_fifo >> snap.tx_colls >> snap.tx_carrier >> snap.tx_compressed;
 
     snapshots[snap.interface_name] = snap;
   }
@@ -82,13 +129,19 @@ NetworkSnapshotMap NetworkPollingTask::read_data(std::istream &net_dev_stream) {
 }
 
 void NetworkPollingTask::calculate() {
-  std::vector<NetworkInterfaceStats> rates;
+  rates.clear();
 
   if (time_delta_seconds <= 0.0) {
-    metrics.network_interfaces = rates; // Avoid division by zero
+    metrics.network_interfaces.clear(); // Avoid division by zero
     return;
   }
 
+  auto rate = [this](unsigned long long current,
+                     unsigned long long previous) {
+    return counter_delta(current, previous, counter_width) /
+           time_delta_seconds;
+  };
+
   for (const auto &[name, current] : current_snapshot) {
     auto prev_it = prev_snapshot.find(name);
     if (prev_it != prev_snapshot.end()) {
@@ -96,46 +149,339 @@ void NetworkPollingTask::calculate() {
 
       NetworkInterfaceStats stats;
       stats.interface_name = name;
-      stats.ip_address = get_ip_address(name);
+      stats.rx_bytes_per_sec = rate(current.rx_bytes, prev.rx_bytes);
+      stats.tx_bytes_per_sec = rate(current.tx_bytes, prev.tx_bytes);
+      stats.rx_packets_per_sec = rate(current.rx_packets, prev.rx_packets);
+      stats.tx_packets_per_sec = rate(current.tx_packets, prev.tx_packets);
+      stats.rx_errors_per_sec = rate(current.rx_errs, prev.rx_errs);
+      stats.tx_errors_per_sec = rate(current.tx_errs, prev.tx_errs);
+      stats.rx_dropped_per_sec = rate(current.rx_drop, prev.rx_drop);
+      stats.tx_dropped_per_sec = rate(current.tx_drop, prev.tx_drop);
+      stats.rx_fifo_per_sec = rate(current.rx_fifo, prev.rx_fifo);
+      stats.tx_fifo_per_sec = rate(current.tx_fifo, prev.tx_fifo);
+      stats.rx_frame_per_sec = rate(current.rx_frame, prev.rx_frame);
+      stats.rx_compressed_per_sec =
+          rate(current.rx_compressed, prev.rx_compressed);
+      stats.tx_compressed_per_sec =
+          rate(current.tx_compressed, prev.tx_compressed);
+      stats.multicast_per_sec = rate(current.rx_multicast, prev.rx_multicast);
+      stats.collisions_per_sec = rate(current.tx_colls, prev.tx_colls);
+      stats.carrier_per_sec = rate(current.tx_carrier, prev.tx_carrier);
+
+      rates.push_back(std::move(stats));
+    }
+  }
 
-      // Check for counter reset (less likely but possible)
-      if (current.rx_bytes >= prev.rx_bytes) {
-        stats.rx_bytes_per_sec =
-            (current.rx_bytes - prev.rx_bytes) / time_delta_seconds;
-      }
-      if (current.tx_bytes >= prev.tx_bytes) {
-        stats.tx_bytes_per_sec =
-            (current.tx_bytes - prev.tx_bytes) / time_delta_seconds;
+  select_top_k();
+
+  // Only the interfaces that are actually emitted need their addresses
+  if (resolve_addresses) {
+    address_cache.poll();
+    for (auto &stats : rates) {
+      if (const auto *addr = address_cache.find(stats.interface_name)) {
+        stats.ip_address = addr->ipv4;
+        stats.ipv6_addresses = addr->ipv6;
       }
+    }
+  }
+  metrics.network_interfaces.swap(rates);
+}
+
+void NetworkPollingTask::select_top_k() {
+  if (top_k == 0 || rates.size() <= top_k)
+    return;
+
+  auto busier = [](const NetworkInterfaceStats &a,
+                   const NetworkInterfaceStats &b) {
+    double ta = a.rx_bytes_per_sec + a.tx_bytes_per_sec;
+    double tb = b.rx_bytes_per_sec + b.tx_bytes_per_sec;
+    if (ta != tb)
+      return ta > tb;
+    return a.interface_name < b.interface_name; // Stable output on ties
+  };
+  std::partial_sort(rates.begin(), rates.begin() + top_k, rates.end(),
+                    busier);
+
+  NetworkInterfaceStats other;
+  other.interface_name = "other";
+  for (auto it = rates.begin() + top_k; it != rates.end(); ++it)
+    other.accumulate(*it);
+
+  rates.resize(top_k);
+  rates.push_back(std::move(other));
+}
+
+void NetworkInterfaceStats::accumulate(const NetworkInterfaceStats &other) {
+  rx_bytes_per_sec += other.rx_bytes_per_sec;
+  tx_bytes_per_sec += other.tx_bytes_per_sec;
+  rx_packets_per_sec += other.rx_packets_per_sec;
+  tx_packets_per_sec += other.tx_packets_per_sec;
+  rx_errors_per_sec += other.rx_errors_per_sec;
+  tx_errors_per_sec += other.tx_errors_per_sec;
+  rx_dropped_per_sec += other.rx_dropped_per_sec;
+  tx_dropped_per_sec += other.tx_dropped_per_sec;
+  rx_fifo_per_sec += other.rx_fifo_per_sec;
+  tx_fifo_per_sec += other.tx_fifo_per_sec;
+  rx_frame_per_sec += other.rx_frame_per_sec;
+  rx_compressed_per_sec += other.rx_compressed_per_sec;
+  tx_compressed_per_sec += other.tx_compressed_per_sec;
+  multicast_per_sec += other.multicast_per_sec;
+  collisions_per_sec += other.collisions_per_sec;
+  carrier_per_sec += other.carrier_per_sec;
+  aggregated_interfaces += std::max<uint32_t>(other.aggregated_interfaces, 1);
+}
+
+InterfaceFilter::InterfaceFilter(const std::set<std::string> &entries) {
+  for (const auto &entry : entries) {
+    if (entry.find_first_of("*?[") != std::string::npos)
+      patterns.push_back(entry);
+    else
+      names.insert(entry);
+  }
+}
+
+bool InterfaceFilter::matches(const char *interface_name) const {
+  if (empty())
+    return true;
+  if (names.count(interface_name))
+    return true;
+  for (const auto &pattern : patterns) {
+    if (fnmatch(pattern.c_str(), interface_name, 0) == 0)
+      return true;
+  }
+  return false;
+}
+// Named requests per send(). Each RTM_NEWLINK reply carries every link
+// attribute (a few KiB), so this keeps one batch of replies well inside
+// LINK_STATS_RECEIVE_BUFFER.
+constexpr size_t LINK_STATS_BATCH = 64;
+constexpr int LINK_STATS_RECEIVE_BUFFER = 1 << 20;
+
+bool LinkStatsReader::open() {
+  if (!socket.open(NETLINK_ROUTE, 0, false))
+    return false;
+  // Replies are immediate; the timeout only guards against a wedged socket
+  socket.set_receive_timeout(1000);
+  if (!socket.set_receive_buffer(LINK_STATS_RECEIVE_BUFFER))
+    SPDLOG_DEBUG("Network: could not raise the RTM_GETLINK receive buffer");
+  return true;
+}
+
+void LinkStatsReader::append_request(const std::string *name,
+                                     uint16_t flags) {
+  size_t payload = NLMSG_LENGTH(sizeof(ifinfomsg));
+  size_t length = payload + (name ? RTA_SPACE(name->size() + 1) : 0);
+  size_t offset = request.size();
+  request.resize(offset + NLMSG_ALIGN(length), 0);
+
+  auto *nh = reinterpret_cast<nlmsghdr *>(request.data() + offset);
+  nh->nlmsg_len = static_cast<uint32_t>(length);
+  nh->nlmsg_type = RTM_GETLINK;
+  nh->nlmsg_flags = flags;
+  nh->nlmsg_seq = socket.next_sequence();
+
+  auto *ifi = static_cast<ifinfomsg *>(NLMSG_DATA(nh));
+  ifi->ifi_family = AF_UNSPEC;
+
+  if (name) {
+    auto *rta = reinterpret_cast<rtattr *>(request.data() + offset +
+                                           NLMSG_ALIGN(payload));
+    rta->rta_type = IFLA_IFNAME;
+    rta->rta_len = static_cast<unsigned short>(RTA_LENGTH(name->size() + 1));
+    std::memcpy(RTA_DATA(rta), name->c_str(), name->size() + 1);
+  }
+}
 
-      rates.push_back(stats);
+bool LinkStatsReader::read(const InterfaceFilter &filter,
+                           NetworkSnapshotMap &out) {
+  if (!socket.is_open())
+    return false;
+
+  // Globs cannot be resolved by the kernel, so they need a full dump
+  ReplyBatch batch;
+  request.clear();
+  if (filter.empty() || filter.has_patterns()) {
+    batch.dump = true;
+    append_request(nullptr, NLM_F_REQUEST | NLM_F_DUMP);
+    return send_batch(batch, filter, out);
+  }
+
+  for (const auto &name : filter.exact_names()) {
+    if (name.size() >= IFNAMSIZ)
+      continue;
+    append_request(&name, NLM_F_REQUEST);
+    if (++batch.pending == LINK_STATS_BATCH) {
+      if (!send_batch(batch, filter, out))
+        return false;
+      batch = ReplyBatch();
+      request.clear();
     }
   }
-  metrics.network_interfaces = rates;
+  return batch.pending == 0 || send_batch(batch, filter, out);
 }
-std::string get_ip_address(const std::string &interface_name) {
-  struct ifaddrs *ifaddr, *ifa;
-  std::string ip = "";
 
+bool LinkStatsReader::send_batch(ReplyBatch &batch,
+                                 const InterfaceFilter &filter,
+                                 NetworkSnapshotMap &out) {
+  batch.first_seq = reinterpret_cast<nlmsghdr *>(request.data())->nlmsg_seq;
+  batch.last_seq = batch.first_seq +
+                   static_cast<uint32_t>(batch.dump ? 0 : batch.pending - 1);
+  if (batch.dump)
+    batch.pending = 1;
+
+  if (!socket.send(request.data(), request.size()))
+    return false;
+  while (batch.pending > 0) {
+    ssize_t len = socket.receive(buffer);
+    if (len <= 0 || !parse_replies(buffer.data(), static_cast<size_t>(len),
+                                   batch, filter, out))
+      return false;
+  }
+  return true;
+}
+
+bool LinkStatsReader::parse_replies(const char *data, size_t length,
+                                    ReplyBatch &batch,
+                                    const InterfaceFilter &filter,
+                                    NetworkSnapshotMap &out) {
+  // A dump ends with NLMSG_DONE; each named request gets exactly one
+  // RTM_NEWLINK or, for an unknown interface, one NLMSG_ERROR.
+  auto remaining = static_cast<unsigned int>(length);
+  for (auto *nh = reinterpret_cast<const nlmsghdr *>(data);
+       NLMSG_OK(nh, remaining); nh = NLMSG_NEXT(nh, remaining)) {
+    if (nh->nlmsg_seq < batch.first_seq || nh->nlmsg_seq > batch.last_seq)
+      continue; // Stale reply from an earlier, abandoned read
+
+    if (nh->nlmsg_type == NLMSG_DONE) {
+      batch.pending = 0;
+    } else if (nh->nlmsg_type == NLMSG_ERROR) {
+      if (batch.dump)
+        return false;
+      if (batch.pending > 0)
+        --batch.pending;
+    } else if (nh->nlmsg_type == RTM_NEWLINK) {
+      parse_link(nh, filter, out);
+      if (!batch.dump && batch.pending > 0)
+        --batch.pending;
+    }
+  }
+  return true;
+}
+
+void LinkStatsReader::parse_link(const nlmsghdr *nh,
+                                 const InterfaceFilter &filter,
+                                 NetworkSnapshotMap &out) {
+  auto *ifi = static_cast<const ifinfomsg *>(NLMSG_DATA(nh));
+  int attr_len = IFLA_PAYLOAD(nh);
+  const char *name = nullptr;
+  rtattr *stats = nullptr;
+
+  for (auto *rta = IFLA_RTA(ifi); RTA_OK(rta, attr_len);
+       rta = RTA_NEXT(rta, attr_len)) {
+    if (rta->rta_type == IFLA_IFNAME)
+      name = static_cast<const char *>(RTA_DATA(rta));
+    else if (rta->rta_type == IFLA_STATS64)
+      stats = rta;
+  }
+  if (!name || !stats || RTA_PAYLOAD(stats) < sizeof(rtnl_link_stats64))
+    return;
+  if (!filter.matches(name))
+    return;
+
+  // Attribute payloads are only 4-byte aligned
+  rtnl_link_stats64 link;
+  std::memcpy(&link, RTA_DATA(stats), sizeof(link));
+
+  NetworkSnapshot &snap = out[name];
+  snap.interface_name = name;
+  // Fold the detailed error counters the same way /proc/net/dev does
+  snap.rx_bytes = link.rx_bytes;
+  snap.rx_packets = link.rx_packets;
+  snap.rx_errs = link.rx_errors;
+  snap.rx_drop = link.rx_dropped + link.rx_missed_errors;
+  snap.rx_fifo = link.rx_fifo_errors;
+  snap.rx_frame = link.rx_length_errors + link.rx_over_errors +
+                  link.rx_crc_errors + link.rx_frame_errors;
+  snap.rx_compressed = link.rx_compressed;
+  snap.rx_multicast = link.multicast;
+  snap.tx_bytes = link.tx_bytes;
+  snap.tx_packets = link.tx_packets;
+  snap.tx_errs = link.tx_errors;
+  snap.tx_drop = link.tx_dropped;
+  snap.tx_fifo = link.tx_fifo_errors;
+  snap.tx_colls = link.collisions;
+  snap.tx_carrier = link.tx_carrier_errors + link.tx_aborted_errors +
+                    link.tx_window_errors + link.tx_heartbeat_errors;
+  snap.tx_compressed = link.tx_compressed;
+}
+
+bool InterfaceAddressCache::open() {
+  dirty = true;
+  return socket.open(NETLINK_ROUTE, RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR);
+}
+
+void InterfaceAddressCache::poll() {
+  if (drain_notifications())
+    dirty = true;
+  if (dirty)
+    reload();
+}
+
+bool InterfaceAddressCache::drain_notifications() {
+  if (!socket.is_open())
+    return true;
+
+  bool changed = false;
+  for (;;) {
+    ssize_t len = socket.receive(buffer);
+    if (len == 0)
+      break;
+    if (len < 0)
+      return true; // Overflow or socket error, state is unknown
+
+    auto remaining = static_cast<unsigned int>(len);
+    for (auto *nh = reinterpret_cast<nlmsghdr *>(buffer.data());
+         NLMSG_OK(nh, remaining); nh = NLMSG_NEXT(nh, remaining)) {
+      if (nh->nlmsg_type == RTM_NEWADDR || nh->nlmsg_type == RTM_DELADDR)
+        changed = true;
+    }
+  }
+  return changed;
+}
+
+void InterfaceAddressCache::reload() {
+  struct ifaddrs *ifaddr;
   if (getifaddrs(&ifaddr) == -1)
-    return "";
+    return; // Keep the previous map and retry next poll
 
-  for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
-    if (ifa->ifa_addr == NULL)
+  addresses.clear();
+  char host[INET6_ADDRSTRLEN];
+  for (auto *ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
+    if (ifa->ifa_addr == nullptr)
       continue;
-    if (ifa->ifa_addr->sa_family == AF_INET) { // IPv4
-      if (interface_name == ifa->ifa_name) {
-        char host[NI_MAXHOST];
-        int s = getnameinfo(ifa->ifa_addr, sizeof(struct sockaddr_in), host,
-                            NI_MAXHOST, NULL, 0, NI_NUMERICHOST);
-        if (s == 0)
-          ip = host;
-        break;
-      }
+
+    int family = ifa->ifa_addr->sa_family;
+    if (family == AF_INET) {
+      auto &entry = addresses[ifa->ifa_name];
+      const auto *sin = reinterpret_cast<sockaddr_in *>(ifa->ifa_addr);
+      if (entry.ipv4.empty() &&
+          inet_ntop(AF_INET, &sin->sin_addr, host, sizeof(host)))
+        entry.ipv4 = host;
+    } else if (family == AF_INET6) {
+      auto &entry = addresses[ifa->ifa_name];
+      const auto *sin6 = reinterpret_cast<sockaddr_in6 *>(ifa->ifa_addr);
+      if (inet_ntop(AF_INET6, &sin6->sin6_addr, host, sizeof(host)))
+        entry.ipv6.emplace_back(host);
     }
   }
   freeifaddrs(ifaddr);
-  return ip;
+  dirty = false;
+}
+
+const InterfaceAddresses *
+InterfaceAddressCache::find(const std::string &interface_name) const {
+  auto it = addresses.find(interface_name);
+  return it == addresses.end() ? nullptr : &it->second;
 }
 
 Network::Network() {
@@ -171,16 +517,21 @@ std::string LuaNetwork::serialize(unsigned indentation_level) const {
   gen.lua_vector("interfaces", interfaces);
   gen.lua_string("ping_target", ping_target);
   gen.lua_bool("enable_ping", enable_ping);
+  gen.lua_uint("top_k", top_k);
 
   return gen.str();
 } // End Network::serialize()
 
 void LuaNetwork::deserialize(sol::table net) {
-  // Extract Interface List
-  if (net["interfaces"].valid()) {
-    // Auto-convert Lua array to C++ vector
-    interfaces = net["interfaces"].get<std::vector<std::string>>();
-  }
+  if (!net.valid())
+    return;
+
+  // A config without an interface list means "no filter", not the
+  // discovered physical devices used when generating a config
+  interfaces = net.get_or("interfaces", std::vector<std::string>{});
+  ping_target = net.get_or("ping_target", ping_target);
+  enable_ping = net.get_or("enable_ping", enable_ping);
+  top_k = net.get_or("top_k", top_k);
 }
 
 }; // namespace telemetry
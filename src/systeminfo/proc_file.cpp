@@ -0,0 +1,93 @@
+// proc_file.cpp
+#include "proc_file.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace telemetry {
+
+// Most pseudo-files fit in one page; larger ones grow the buffer
+constexpr size_t PROC_FILE_CHUNK = 4096;
+
+ProcFile::~ProcFile() { close(); }
+
+ProcFile::ProcFile(ProcFile &&other) noexcept
+    : fd(other.fd), file_path(std::move(other.file_path)) {
+  other.fd = -1;
+}
+
+ProcFile &ProcFile::operator=(ProcFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    fd = other.fd;
+    file_path = std::move(other.file_path);
+    other.fd = -1;
+  }
+  return *this;
+}
+
+bool ProcFile::open(const std::string &path) {
+  close();
+  file_path = path;
+  fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  return fd >= 0;
+}
+
+bool ProcFile::open_at(int dirfd, const char *name) {
+  close();
+  file_path = name;
+  fd = ::openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+  return fd >= 0;
+}
+
+void ProcFile::close() {
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+bool ProcFile::read(std::string &buffer) const {
+  if (fd < 0)
+    return false;
+
+  if (buffer.capacity() < PROC_FILE_CHUNK)
+    buffer.reserve(PROC_FILE_CHUNK);
+  buffer.resize(buffer.capacity());
+
+  size_t total = 0;
+  for (;;) {
+    if (total == buffer.size())
+      buffer.resize(buffer.size() * 2);
+
+    ssize_t n = ::pread(fd, &buffer[total], buffer.size() - total,
+                        static_cast<off_t>(total));
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      buffer.clear();
+      return false;
+    }
+    if (n == 0)
+      break;
+    total += static_cast<size_t>(n);
+  }
+  buffer.resize(total);
+  return true;
+}
+
+bool ProcFile::read_counter(std::string &buffer,
+                            unsigned long long &value) const {
+  if (!read(buffer) || buffer.empty())
+    return false;
+  char *end;
+  unsigned long long parsed = std::strtoull(buffer.c_str(), &end, 10);
+  if (end == buffer.c_str())
+    return false;
+  value = parsed;
+  return true;
+}
+
+}; // namespace telemetry
@@ -4,6 +4,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <charconv>
+#include <numeric>
+
 #include "context.hpp"
 #include "data_local.hpp"
 #include "data_ssh.hpp"
@@ -116,6 +120,235 @@ std::pair<long, unsigned long long> read_proc_stat_values(long pid) {
 
   return {utime + stime, starttime};
 }
+namespace {
+
+// Scopes that container runtimes create under systemd: "docker-<id>.scope"
+const std::pair<std::string_view, std::string_view> CONTAINER_SCOPES[] = {
+    {"docker-", "docker"},
+    {"cri-containerd-", "containerd"},
+    {"crio-", "crio"},
+    {"libpod-", "podman"},
+};
+constexpr std::string_view SCOPE_SUFFIX = ".scope";
+// Container ids are shortened the way `docker ps` does
+constexpr size_t CONTAINER_ID_LEN = 12;
+// Smallest per-process cache (cgroups, smaps); lists churn between ticks
+constexpr size_t PROCESS_CACHE_MIN = 256;
+
+bool ends_with(std::string_view text, std::string_view suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+uint32_t clamp_kb(unsigned long long kb) {
+  return static_cast<uint32_t>(
+      std::min<unsigned long long>(kb, std::numeric_limits<uint32_t>::max()));
+}
+
+std::string container_name(std::string_view runtime, std::string_view id) {
+  std::string name(runtime);
+  name += ':';
+  name.append(id.substr(0, CONTAINER_ID_LEN));
+  return name;
+}
+
+} // namespace
+
+std::string cgroup_unit_name(std::string_view path) {
+  std::string_view unit;
+  std::string_view parent;
+  for (size_t start = 0; start < path.size();) {
+    size_t end = path.find('/', start);
+    if (end == std::string_view::npos)
+      end = path.size();
+    std::string_view part = path.substr(start, end - start);
+    start = end + 1;
+    if (part.empty())
+      continue;
+
+    if (ends_with(part, SCOPE_SUFFIX)) {
+      for (const auto &[prefix, runtime] : CONTAINER_SCOPES) {
+        size_t affixes = prefix.size() + SCOPE_SUFFIX.size();
+        if (part.size() > affixes &&
+            part.compare(0, prefix.size(), prefix) == 0)
+          return container_name(
+              runtime, part.substr(prefix.size(), part.size() - affixes));
+      }
+    }
+    // The cgroupfs driver nests the bare id: /docker/<id>
+    if (parent == "docker" && part.size() == 64)
+      return container_name("docker", part);
+    if (ends_with(part, ".service") || ends_with(part, SCOPE_SUFFIX))
+      unit = part;
+    parent = part;
+  }
+  return std::string(unit);
+}
+
+// Each line is "hierarchy-id:controllers:path"; v2 is "0::/path"
+bool parse_proc_cgroup(std::string_view text, ProcessCgroup &cgroup) {
+  std::string_view chosen;
+  bool found = false;
+  for (size_t start = 0; start < text.size() && !found;) {
+    size_t end = text.find('\n', start);
+    if (end == std::string_view::npos)
+      end = text.size();
+    std::string_view line = text.substr(start, end - start);
+    start = end + 1;
+
+    size_t first = line.find(':');
+    size_t second = line.find(':', first + 1);
+    if (first == std::string_view::npos || second == std::string_view::npos)
+      continue;
+    std::string_view path = line.substr(second + 1);
+    // Hybrid setups can list an empty v2 entry next to the v1 ones
+    if (line.compare(0, second + 1, "0::") == 0 && !path.empty()) {
+      chosen = path;
+      found = true;
+    } else if (line.substr(first + 1, second - first - 1) == "name=systemd") {
+      chosen = path;
+    }
+  }
+  if (chosen.empty())
+    return false;
+  cgroup.path.assign(chosen.data(), chosen.size());
+  cgroup.unit = cgroup_unit_name(chosen);
+  return true;
+}
+
+// After a header naming the range, each line is "Pss:      123 kB"
+bool parse_smaps_rollup(std::string_view text, SmapsRollup &rollup) {
+  rollup = SmapsRollup();
+  bool found = false;
+  unsigned long long private_kb = 0;
+  for (size_t start = 0; start < text.size();) {
+    size_t end = text.find('\n', start);
+    if (end == std::string_view::npos)
+      end = text.size();
+    std::string_view line = text.substr(start, end - start);
+    start = end + 1;
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+      continue;
+    std::string_view key = line.substr(0, colon);
+    uint32_t *target = nullptr;
+    if (key == "Rss")
+      target = &rollup.rss_kb;
+    else if (key == "Pss")
+      target = &rollup.pss_kb;
+    else if (key == "Swap")
+      target = &rollup.swap_kb;
+    else if (key != "Private_Clean" && key != "Private_Dirty")
+      continue;
+
+    const char *pos = line.data() + colon + 1;
+    const char *line_end = line.data() + line.size();
+    while (pos < line_end && *pos == ' ')
+      ++pos;
+    unsigned long long value = 0;
+    std::from_chars(pos, line_end, value);
+    if (target != nullptr)
+      *target = clamp_kb(value);
+    else
+      private_kb += value;
+    found = true;
+  }
+  rollup.uss_kb = clamp_kb(private_kb);
+  return found;
+}
+
+bool smaps_rss_moved(uint32_t read_rss_kb, uint32_t rss_kb, unsigned percent) {
+  uint64_t change =
+      read_rss_kb > rss_kb ? read_rss_kb - rss_kb : rss_kb - read_rss_kb;
+  return change * 100 > uint64_t(read_rss_kb) * percent;
+}
+
+SmapsRefresher::~SmapsRefresher() { stop(); }
+
+void SmapsRefresher::start(std::chrono::milliseconds interval,
+                           unsigned rss_change_percent, size_t capacity) {
+  stop();
+  this->interval = interval;
+  this->rss_change_percent = rss_change_percent;
+  results.set_capacity(capacity);
+  stopping = false;
+  thread = std::thread(&SmapsRefresher::run, this);
+}
+
+void SmapsRefresher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  if (thread.joinable())
+    thread.join();
+}
+
+void SmapsRefresher::set_processes(const std::vector<SmapsRequest> &processes) {
+  bool unknown = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->processes = processes;
+    for (const SmapsRequest &request : processes)
+      unknown = unknown || !results.contains(request.key);
+    has_new = has_new || unknown;
+  }
+  if (unknown)
+    wake.notify_all();
+}
+
+bool SmapsRefresher::get(const ProcessKey &key, SmapsRollup &rollup) {
+  std::lock_guard<std::mutex> lock(mutex);
+  const Entry *entry = results.get(key);
+  if (entry == nullptr || !entry->valid)
+    return false;
+  rollup = entry->rollup;
+  return true;
+}
+
+// Called with the mutex held
+bool SmapsRefresher::needs_read(const SmapsRequest &request) {
+  const Entry *entry = results.get(request.key);
+  if (entry == nullptr)
+    return true;
+  // Unreadable (another user's process, or gone); not retried
+  if (!entry->valid)
+    return false;
+  return smaps_rss_moved(entry->rollup.rss_kb, request.rss_kb,
+                         rss_change_percent);
+}
+
+void SmapsRefresher::run() {
+  std::vector<ProcessKey> due;
+  std::string buffer;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopping) {
+    has_new = false;
+    due.clear();
+    for (const SmapsRequest &request : processes) {
+      if (needs_read(request))
+        due.push_back(request.key);
+    }
+    lock.unlock();
+
+    for (const ProcessKey &key : due) {
+      Entry entry;
+      ProcFile file("/proc/" + std::to_string(key.pid) + "/smaps_rollup");
+      entry.valid =
+          file.read(buffer) && parse_smaps_rollup(buffer, entry.rollup);
+      std::lock_guard<std::mutex> guard(mutex);
+      if (stopping)
+        break;
+      results.put(key, entry);
+    }
+
+    lock.lock();
+    wake.wait_for(lock, interval, [this] { return stopping || has_new; });
+  }
+}
+
 long get_system_uptime_jiffies() {
   std::ifstream uptime_file("/proc/uptime");
   double uptime_seconds;
@@ -229,6 +462,17 @@ ProcessPollingTask::ProcessPollingTask(DataStreamProvider &p, SystemMetrics &m,
   process_count = settings.features.processes.count;
   ignore_list = settings.features.processes.ignore_list;
   only_user_processes = settings.features.processes.only_user_processes;
+  bool is_local = context.provider == DataStreamProviders::LocalDataStream;
+  annotate_cgroups = is_local;
+  // Room for every list's entries, plus the ones that drop in and out
+  cgroup_cache.set_capacity(std::max(PROCESS_CACHE_MIN, 8 * process_count));
+  collect_smaps = is_local && settings.features.processes.enable_smaps &&
+                  (settings.features.processes.enable_realtime_mem ||
+                   settings.features.processes.enable_avg_mem);
+  smaps_interval =
+      std::chrono::milliseconds(settings.features.processes.smaps_interval_ms);
+  smaps_rss_change_percent =
+      settings.features.processes.smaps_rss_change_percent;
 
   // 1. CPU Configuration
   if (settings.features.processes.enable_realtime_cpu ||
@@ -238,7 +482,7 @@ ProcessPollingTask::ProcessPollingTask(DataStreamProvider &p, SystemMetrics &m,
     DEBUG_PTR("Pipeline vector", output_pipeline);
 
     output_pipeline.emplace_back(
-        [this, need_real, need_avg](std::vector<ProcessInfo> &data) {
+        [this, need_real, need_avg](const std::vector<ProcessInfo> &data) {
           DEBUG_PTR("ProcessPollingTask lambda this", this);
           DEBUG_PTR("ProcessPollingTask lambda metrics", metrics);
           if (need_real) {
@@ -248,7 +492,8 @@ ProcessPollingTask::ProcessPollingTask(DataStreamProvider &p, SystemMetrics &m,
 
             if (need_avg) {
               // If we have both, usually we want the list to match the Realtime
-              // list, just with Avg data filled in. So we copy.
+              // list, just with Avg data filled in. Both lists index the same
+              // records, so only the indices are copied.
               this->metrics.top_processes_avg_cpu =
                   this->metrics.top_processes_real_cpu;
             }
@@ -268,7 +513,7 @@ ProcessPollingTask::ProcessPollingTask(DataStreamProvider &p, SystemMetrics &m,
     bool need_avg = settings.features.processes.enable_avg_mem;
 
     output_pipeline.emplace_back(
-        [this, need_real, need_avg](std::vector<ProcessInfo> &data) {
+        [this, need_real, need_avg](const std::vector<ProcessInfo> &data) {
           DEBUG_PTR("ProcessPollingTask lambda this", this);
           DEBUG_PTR("ProcessPollingTask lambda metrics", metrics);
           // Always sort by Memory (RSS)
@@ -309,38 +554,61 @@ void ProcessPollingTask::commit() {
   prev_snapshots = std::move(current_snapshots);
 }
 
-// Helper lambda for sorting and assigning top 10
-void ProcessPollingTask::populate_top_ps(std::vector<ProcessInfo> &source,
-                                         std::vector<ProcessInfo> &dest,
+// Selects the top N candidates for a sort mode. Only indices are sorted; the
+// records themselves stay where they are.
+void ProcessPollingTask::populate_top_ps(const std::vector<ProcessInfo> &source,
+                                         ProcessIndexList &dest,
                                          SortMode mode) {
   SPDLOG_TRACE("  Sort: Start. Size: {}", source.size());
-  dest.reserve(process_count);
 
   // Define the comparator based on the mode
-  auto sorter = [mode](const ProcessInfo &a, const ProcessInfo &b) {
+  auto sorter = [&source, mode](uint32_t lhs, uint32_t rhs) {
+    const ProcessInfo &a = source[lhs];
+    const ProcessInfo &b = source[rhs];
     switch (mode) {
     case SortMode::MEM:
       return a.vmRssKb > b.vmRssKb;
     case SortMode::CPU_REAL:
-      return a.cpu_percent > b.cpu_percent;
+      return a.cpu_percent_fp > b.cpu_percent_fp;
     case SortMode::CPU_AVG:
-      return a.cpu_avg_percent > b.cpu_avg_percent;
+      return a.cpu_avg_percent_fp > b.cpu_avg_percent_fp;
     }
     return false;
   };
 
-  if (source.size() > process_count) {
-    std::partial_sort(source.begin(), source.begin() + process_count,
-                      source.end(), sorter);
-    dest.assign(source.begin(), source.begin() + process_count);
-  } else {
-    std::sort(source.begin(), source.end(), sorter);
-    dest = source;
-  }
+  sort_order.resize(source.size());
+  std::iota(sort_order.begin(), sort_order.end(), 0);
+
+  size_t count = std::min<size_t>(process_count, sort_order.size());
+  std::partial_sort(sort_order.begin(), sort_order.begin() + count,
+                    sort_order.end(), sorter);
+  dest.assign(sort_order.begin(), sort_order.begin() + count);
   SPDLOG_TRACE("  Sort: Finished.");
 }
+
+// Copies every candidate referenced by a top-N list into the shared record
+// array once, and rewrites the lists to index that array instead.
+void ProcessPollingTask::build_process_records() {
+  constexpr uint32_t UNASSIGNED = std::numeric_limits<uint32_t>::max();
+  record_slots.assign(candidates.size(), UNASSIGNED);
+
+  for (ProcessIndexList *list :
+       {&metrics.top_processes_real_cpu, &metrics.top_processes_avg_cpu,
+        &metrics.top_processes_real_mem, &metrics.top_processes_avg_mem}) {
+    for (uint32_t &index : *list) {
+      uint32_t &slot = record_slots[index];
+      if (slot == UNASSIGNED) {
+        slot = static_cast<uint32_t>(metrics.process_records.size());
+        metrics.process_records.push_back(candidates[index]);
+      }
+      index = slot;
+    }
+  }
+}
 void ProcessPollingTask::calculate() {
   // 1. Clear all destination vectors
+  metrics.process_records.clear();
+  metrics.process_cgroups.clear();
   metrics.top_processes_avg_mem.clear();
   metrics.top_processes_avg_cpu.clear();
   metrics.top_processes_real_mem.clear();
@@ -357,8 +625,8 @@ void ProcessPollingTask::calculate() {
 
   long system_uptime_jiffies = get_system_uptime_jiffies();
 
-  std::vector<ProcessInfo> all_procs;
-  all_procs.reserve(current_snapshots.size());
+  candidates.clear();
+  candidates.reserve(current_snapshots.size());
 
   // 2. Calculate Real-Time Delta for ALL processes
   for (const auto &[pid, current_snap] : current_snapshots) {
@@ -372,9 +640,9 @@ void ProcessPollingTask::calculate() {
       const auto &prev_snap = prev_it->second;
 
       ProcessInfo info;
-      info.pid = pid;
-      info.name = current_snap.name;
-      info.vmRssKb = current_snap.vmRssKb;
+      info.pid = static_cast<int32_t>(pid);
+      info.set_name(current_snap.name);
+      info.vmRssKb = static_cast<uint32_t>(current_snap.vmRssKb);
 
       // --- CPU Calculation (Real-Time / Interval) ---
       // This calculates usage strictly for the window between Snapshot 1 and 2
@@ -385,9 +653,9 @@ void ProcessPollingTask::calculate() {
         double usage =
             (static_cast<double>(jiffies_delta) / total_jiffies_available) *
             100.0;
-        info.cpu_percent = std::min(usage, 100.0);
+        info.set_cpu_percent(usage);
       } else {
-        info.cpu_percent = 0.0;
+        info.set_cpu_percent(0.0);
       }
       // A safe heuristic:
       double lifetime_usage = 0.0;
@@ -409,16 +677,16 @@ void ProcessPollingTask::calculate() {
         lifetime_usage = (cpu_sec / (double)current_snap.start_time) * 100.0;
       }
 
-      info.cpu_avg_percent = std::min(lifetime_usage, 100.0);
+      info.set_cpu_avg_percent(lifetime_usage);
 
       // --- Memory Calculation ---
       if (metrics.meminfo.total_kb > 0) {
-        info.mem_percent =
+        info.set_mem_percent(
             (static_cast<double>(info.vmRssKb) / metrics.meminfo.total_kb) *
-            100.0;
+            100.0);
       }
 
-      all_procs.push_back(std::move(info));
+      candidates.push_back(info);
     }
   }
   SPDLOG_TRACE("Starting pipeline execution. Steps: {}",
@@ -429,19 +697,87 @@ void ProcessPollingTask::calculate() {
     SPDLOG_TRACE(" [Step {}] Invoking task...", step_index);
 
     // EXECUTE
-    task(all_procs);
+    task(candidates);
 
     SPDLOG_TRACE(" [Step {}] Task finished.", step_index);
     step_index++;
   }
 
-  audit_process_list(metrics.top_processes_avg_mem);
-  audit_process_list(metrics.top_processes_avg_cpu);
-  audit_process_list(metrics.top_processes_real_mem);
-  audit_process_list(metrics.top_processes_real_cpu);
+  // Each process is audited once, however many lists it appears in
+  build_process_records();
+  audit_process_list(metrics.process_records);
+  if (annotate_cgroups)
+    annotate_process_records();
+  if (collect_smaps)
+    update_smaps();
 
   SPDLOG_TRACE("Pipeline complete with IO/FD audit.");
 }
+
+ProcessKey ProcessPollingTask::record_key(const ProcessInfo &record) const {
+  ProcessKey key{record.pid, 0};
+  auto snapshot = current_snapshots.find(record.pid);
+  if (snapshot != current_snapshots.end())
+    key.start_time = snapshot->second.start_time;
+  return key;
+}
+
+// Looks up each record's cgroup by (pid, start time), so a reused pid is
+// never given the cgroup of the process that had it before
+void ProcessPollingTask::annotate_process_records() {
+  const auto &records = metrics.process_records;
+  metrics.process_cgroups.resize(records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    ProcessKey key = record_key(records[i]);
+    const ProcessCgroup *cgroup = cgroup_cache.get(key);
+    if (cgroup == nullptr) {
+      // A process that already exited is cached empty; its key won't recur
+      ProcessCgroup entry;
+      ProcFile file("/proc/" + std::to_string(key.pid) + "/cgroup");
+      if (file.read(cgroup_buffer))
+        parse_proc_cgroup(cgroup_buffer, entry);
+      cgroup = &cgroup_cache.put(key, std::move(entry));
+    }
+    metrics.process_cgroups[i] = *cgroup;
+  }
+}
+
+// Hands the processes of both memory lists to the smaps helper and copies
+// back whatever it has read so far
+void ProcessPollingTask::update_smaps() {
+  // Both lists index process_records, so a process in both is one record
+  smaps_records.assign(metrics.top_processes_real_mem.begin(),
+                       metrics.top_processes_real_mem.end());
+  smaps_records.insert(smaps_records.end(),
+                       metrics.top_processes_avg_mem.begin(),
+                       metrics.top_processes_avg_mem.end());
+  std::sort(smaps_records.begin(), smaps_records.end());
+  smaps_records.erase(std::unique(smaps_records.begin(), smaps_records.end()),
+                      smaps_records.end());
+
+  smaps_requests.clear();
+  for (uint32_t index : smaps_records) {
+    const ProcessInfo &record = metrics.process_records[index];
+    smaps_requests.push_back({record_key(record), record.vmRssKb});
+  }
+  if (!smaps_refresher.is_running()) {
+    if (smaps_requests.empty())
+      return;
+    smaps_refresher.start(smaps_interval, smaps_rss_change_percent,
+                          std::max(PROCESS_CACHE_MIN, 4 * process_count));
+  }
+  smaps_refresher.set_processes(smaps_requests);
+
+  for (size_t i = 0; i < smaps_requests.size(); ++i) {
+    SmapsRollup rollup;
+    if (!smaps_refresher.get(smaps_requests[i].key, rollup))
+      continue;
+    ProcessInfo &record = metrics.process_records[smaps_records[i]];
+    record.pss_kb = rollup.pss_kb;
+    record.uss_kb = rollup.uss_kb;
+    record.swap_kb = rollup.swap_kb;
+  }
+}
 void ProcessPollingTask::set_process_count(int count) { process_count = count; }
 void ProcessPollingTask::audit_process_list(std::vector<ProcessInfo> &list) {
   for (auto &proc : list) {
@@ -487,6 +823,9 @@ LuaProcesses ::serialize(unsigned const int indentation_level) const {
   processes.lua_bool("enable_realtime_mem", enable_realtime_mem);
   processes.lua_uint("count", count);
   processes.lua_vector("ignore_list", ignore_list); // fixme
+  processes.lua_bool("enable_smaps", enable_smaps);
+  processes.lua_uint("smaps_interval_ms", smaps_interval_ms);
+  processes.lua_uint("smaps_rss_change_percent", smaps_rss_change_percent);
   return processes.str();
 }
 
@@ -507,6 +846,11 @@ void LuaProcesses::deserialize(sol::table procs) {
     ignore_list =
         procs.get<sol::optional<std::vector<std::string>>>("ignore_list")
             .value_or(std::vector<std::string>{});
+    enable_smaps =
+        procs.get<sol::optional<bool>>("enable_smaps").value_or(true);
+    smaps_interval_ms = procs.get_or("smaps_interval_ms", smaps_interval_ms);
+    smaps_rss_change_percent =
+        procs.get_or("smaps_rss_change_percent", smaps_rss_change_percent);
   }
 }
 
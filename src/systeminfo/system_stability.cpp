@@ -1,25 +1,69 @@
 // system_stability.cpp
 
+#include <cstring>
+
+#include "context.hpp"
 #include "polling.hpp"
 
 namespace telemetry {
 
-double parse_avg10(const std::string &line) {
-  // Look for "avg10="
-  size_t pos = line.find("avg10=");
-  if (pos == std::string::npos)
-    return 0.0;
-
-  // Move index to the start of the numeric value
-  pos += 6;
-
-  // Find the space or end of string after the number
-  size_t end = line.find(' ', pos);
-  try {
-    return std::stod(line.substr(pos, end - pos));
-  } catch (...) {
-    return 0.0;
+const char *psi_kind_name(PsiKind kind) {
+  switch (kind) {
+  case PsiKind::Cpu:
+    return "cpu";
+  case PsiKind::Memory:
+    return "memory";
+  case PsiKind::Io:
+    return "io";
+  case PsiKind::Irq:
+    return "irq";
+  }
+  return "unknown";
+}
+
+// Format: some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+bool parse_psi(const std::string &text, PsiResource &resource) {
+  bool found = false;
+  const char *pos = text.c_str();
+  const char *end = pos + text.size();
+  while (pos < end) {
+    const char *eol =
+        static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+    if (eol == nullptr)
+      eol = end;
+
+    PsiLine *line = nullptr;
+    if (eol - pos > 5 && std::strncmp(pos, "some ", 5) == 0)
+      line = &resource.some;
+    else if (eol - pos > 5 && std::strncmp(pos, "full ", 5) == 0)
+      line = &resource.full;
+
+    for (const char *field = pos + 5; line != nullptr && field < eol;) {
+      const char *equals =
+          static_cast<const char *>(std::memchr(field, '=', eol - field));
+      if (equals == nullptr)
+        break;
+      std::string_view key(field, equals - field);
+      char *value_end;
+      if (key == "total") {
+        line->total_us = std::strtoull(equals + 1, &value_end, 10);
+      } else {
+        double value = std::strtod(equals + 1, &value_end);
+        if (key == "avg10")
+          line->avg10 = value;
+        else if (key == "avg60")
+          line->avg60 = value;
+        else if (key == "avg300")
+          line->avg300 = value;
+      }
+      field = value_end;
+      while (field < eol && *field == ' ')
+        ++field;
+      found = true;
+    }
+    pos = eol + 1;
   }
+  return found;
 }
 
 SystemStabilityPollingTask::SystemStabilityPollingTask(DataStreamProvider &p,
@@ -27,49 +71,66 @@ SystemStabilityPollingTask::SystemStabilityPollingTask(DataStreamProvider &p,
                                                        MetricsContext &ctx)
     : IPollingTask(p, m, ctx) {
   name = "System Stability";
+  if (ctx.provider != DataStreamProviders::LocalDataStream)
+    return;
+  file_nr.open("/proc/sys/fs/file-nr");
+  // Kernels without PSI (or irq pressure, before 6.1) just lack the file
+  for (size_t i = 0; i < PSI_KIND_COUNT; ++i)
+    pressure_files[i].open(std::string("/proc/pressure/") +
+                           psi_kind_name(static_cast<PsiKind>(i)));
 }
 
 void SystemStabilityPollingTask::configure() {}
+
+void SystemStabilityPollingTask::read_pressure(
+    std::array<PsiResource, PSI_KIND_COUNT> &pressure,
+    std::array<bool, PSI_KIND_COUNT> &valid) {
+  for (size_t i = 0; i < PSI_KIND_COUNT; ++i) {
+    pressure[i] = PsiResource();
+    valid[i] = pressure_files[i].read(buffer) && parse_psi(buffer, pressure[i]);
+  }
+}
+
 void SystemStabilityPollingTask::take_initial_snapshot() {
-  take_new_snapshot();
+  set_timestamp();
+  read_pressure(prev_pressure, prev_valid);
 }
+
 void SystemStabilityPollingTask::take_new_snapshot() {
-  // 1. Monitor File Descriptors
-  std::ifstream file_nr("/proc/sys/fs/file-nr");
-  if (file_nr) {
-    file_nr >> metrics.stability.file_descriptors_allocated;
-    long unused;
-    file_nr >> unused >> metrics.stability.file_descriptors_max;
+  set_delta_time();
+
+  // 1. Monitor File Descriptors: "allocated unused max"
+  if (file_nr.read(buffer)) {
+    char *end;
+    metrics.stability.file_descriptors_allocated =
+        std::strtol(buffer.c_str(), &end, 10);
+    std::strtol(end, &end, 10);
+    metrics.stability.file_descriptors_max = std::strtol(end, &end, 10);
   }
 
-  // 2. Monitor Memory Pressure (PSI)
-  // Format: some avg10=0.00 avg60=0.00 avg300=0.00 total=0
-  std::ifstream psi_mem("/proc/pressure/memory");
-  std::string label, avg10;
-  if (psi_mem >> label >> avg10) {
-    // Parse "avg10=0.00"
-    size_t pos = avg10.find('=');
-    if (pos != std::string::npos) {
-      metrics.stability.memory_pressure_some = std::stod(avg10.substr(pos + 1));
+  // 2. Monitor Pressure (PSI)
+  read_pressure(current_pressure, current_valid);
+}
+
+void SystemStabilityPollingTask::calculate() {
+  for (size_t i = 0; i < PSI_KIND_COUNT; ++i) {
+    // Against a failed read the delta would be the stall time since boot
+    bool valid = prev_valid[i] && current_valid[i] && time_delta_seconds > 0.0;
+    for (PsiLine PsiResource::*member :
+         {&PsiResource::some, &PsiResource::full}) {
+      const PsiLine &prev = prev_pressure[i].*member;
+      PsiLine &curr = current_pressure[i].*member;
+      curr.stall_us_per_sec =
+          valid ? counter_delta(curr.total_us, prev.total_us) /
+                      time_delta_seconds
+                : 0.0;
     }
   }
+  metrics.stability.pressure = current_pressure;
+}
 
-  auto parse_psi = [](const std::string &path, double &some, double &full) {
-    std::ifstream f(path);
-    std::string line;
-    while (std::getline(f, line)) {
-      if (line.rfind("some", 0) == 0)
-        some = parse_avg10(line);
-      else if (line.rfind("full", 0) == 0)
-        full = parse_avg10(line);
-    }
-  };
-  parse_psi("/proc/pressure/memory", metrics.stability.memory_pressure_some,
-            metrics.stability.memory_pressure_full);
-  parse_psi("/proc/pressure/io", metrics.stability.io_pressure_some,
-            metrics.stability.io_pressure_full);
+void SystemStabilityPollingTask::commit() {
+  prev_pressure = current_pressure;
+  prev_valid = current_valid;
 }
-void SystemStabilityPollingTask::calculate() {
-} // Direct read is sufficient here
-void SystemStabilityPollingTask::commit() {}
 }; // namespace telemetry
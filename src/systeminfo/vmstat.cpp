@@ -0,0 +1,174 @@
+// vmstat.cpp
+#include "vmstat.hpp"
+
+#include <charconv>
+#include <cstring>
+
+#include "context.hpp"
+#include "log.hpp"
+#include "lua_generator.hpp"
+#include "polling.hpp"
+
+namespace telemetry {
+
+VmstatTable::VmstatTable(const std::vector<std::string> &wanted) {
+  for (const auto &name : wanted) {
+    if (name == "*")
+      wants_all = true;
+    else if (wanted_slots.emplace(name, wanted_names.size()).second)
+      wanted_names.push_back(name);
+  }
+}
+
+// Each line is "pgmajfault 12345"
+bool VmstatTable::build(std::string_view text) {
+  names.clear();
+  lines.clear();
+  constexpr size_t MISSING = static_cast<size_t>(-1);
+  std::vector<size_t> line_of(wanted_names.size(), MISSING);
+
+  size_t line = 0;
+  for (size_t start = 0; start < text.size(); ++line) {
+    size_t end = text.find('\n', start);
+    if (end == std::string_view::npos)
+      end = text.size();
+    size_t space = text.find(' ', start);
+    if (space < end) {
+      std::string_view name = text.substr(start, space - start);
+      if (wants_all) {
+        lines.push_back({line, names.size()});
+        names.emplace_back(name);
+      } else {
+        auto it = wanted_slots.find(std::string(name));
+        if (it != wanted_slots.end())
+          line_of[it->second] = line;
+      }
+    }
+    start = end + 1;
+  }
+
+  if (!wants_all) {
+    for (size_t i = 0; i < wanted_names.size(); ++i) {
+      if (line_of[i] == MISSING) {
+        SPDLOG_WARN("Vmstat: counter '{}' not in /proc/vmstat",
+                    wanted_names[i]);
+        continue;
+      }
+      lines.push_back({line_of[i], names.size()});
+      names.push_back(wanted_names[i]);
+    }
+    std::sort(lines.begin(), lines.end(),
+              [](const Line &a, const Line &b) { return a.line < b.line; });
+  }
+  built = true;
+  SPDLOG_DEBUG("Vmstat: tracking {} counters", names.size());
+  return !names.empty();
+}
+
+bool VmstatTable::parse(std::string_view text,
+                        std::vector<unsigned long long> &values) const {
+  if (!built)
+    return false;
+  values.assign(names.size(), 0);
+
+  const char *pos = text.data();
+  const char *end = pos + text.size();
+  size_t line = 0;
+  for (const Line &wanted : lines) {
+    for (; line < wanted.line; ++line) {
+      const char *newline =
+          static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+      if (newline == nullptr)
+        return false;
+      pos = newline + 1;
+    }
+    const std::string &name = names[wanted.slot];
+    if (static_cast<size_t>(end - pos) <= name.size() ||
+        std::memcmp(pos, name.data(), name.size()) != 0 ||
+        pos[name.size()] != ' ')
+      return false;
+    std::from_chars(pos + name.size() + 1, end, values[wanted.slot]);
+  }
+  return true;
+}
+
+bool VmstatTable::update(std::string_view text,
+                         std::vector<unsigned long long> &values,
+                         bool &rebuilt) {
+  rebuilt = false;
+  if (parse(text, values))
+    return true;
+  rebuilt = true;
+  build(text);
+  return parse(text, values);
+}
+
+void compute_vmstat_rates(const VmstatTable &table,
+                          const std::vector<unsigned long long> &prev,
+                          const std::vector<unsigned long long> &curr,
+                          double seconds, std::vector<VmstatRate> &out) {
+  const std::vector<std::string> &counters = table.counters();
+  bool have_rates = prev.size() == curr.size() && seconds > 0.0;
+  out.resize(curr.size());
+  for (size_t i = 0; i < curr.size(); ++i) {
+    VmstatRate &rate = out[i];
+    rate.name = counters[i];
+    rate.per_sec = 0.0;
+    if (have_rates && curr[i] >= prev[i])
+      rate.per_sec = (curr[i] - prev[i]) / seconds;
+  }
+}
+
+std::string LuaVmstat::serialize(unsigned indentation_level) const {
+  LuaConfigGenerator gen("vmstat", indentation_level);
+  gen.lua_vector("counters", counters);
+  return gen.str();
+}
+
+void LuaVmstat::deserialize(sol::table vmstat) {
+  if (!vmstat.valid())
+    return;
+  counters = vmstat.get_or("counters", counters);
+}
+
+VmstatPollingTask::VmstatPollingTask(DataStreamProvider &provider,
+                                     SystemMetrics &metrics,
+                                     MetricsContext &context)
+    : IPollingTask(provider, metrics, context),
+      table(context.settings.vmstat.counters) {
+  name = "Vmstat polling";
+  if (context.provider == DataStreamProviders::LocalDataStream)
+    vmstat.open("/proc/vmstat");
+}
+
+bool VmstatPollingTask::read_values(std::vector<unsigned long long> &values,
+                                    bool &rebuilt) {
+  rebuilt = false;
+  return vmstat.read(buffer) && table.update(buffer, values, rebuilt);
+}
+
+void VmstatPollingTask::take_initial_snapshot() {
+  set_timestamp();
+  bool rebuilt;
+  if (!read_values(prev_values, rebuilt))
+    prev_values.clear();
+}
+
+void VmstatPollingTask::take_new_snapshot() {
+  set_delta_time();
+  bool rebuilt;
+  if (!read_values(current_values, rebuilt))
+    current_values.clear();
+  // The counter layout changed; old values use other slots
+  if (rebuilt)
+    prev_values.clear();
+}
+
+void VmstatPollingTask::calculate() {
+  compute_vmstat_rates(table, prev_values, current_values, time_delta_seconds,
+                       metrics.vmstat);
+}
+
+void VmstatPollingTask::commit() { prev_values = current_values; }
+
+}; // namespace telemetry
@@ -36,12 +36,16 @@ void generate_waybar_output(const std::vector<MetricsContext> &all_results) {
     if (result.success) {
       const auto &system_metrics = result.metrics.system;
       const auto &devices = result.metrics.disks;
+      const ProcessListView top_mem =
+          system_metrics.processes(system_metrics.top_processes_avg_mem);
+      const ProcessListView top_cpu =
+          system_metrics.processes(system_metrics.top_processes_avg_cpu);
       tooltip_ss
           << show_system_metrics(result, system_metrics, total_mem_percent,
                                  valid_mem_sources)
 
-          << show_top_mem_procs(result, system_metrics.top_processes_avg_mem)
-          << show_top_cpu_procs(result, system_metrics.top_processes_avg_cpu)
+          << show_top_mem_procs(result, top_mem)
+          << show_top_cpu_procs(result, top_cpu)
           << show_devices(result, devices)
 
           << show_network_interfaces(result, system_metrics.network_interfaces,
@@ -88,7 +92,7 @@ void generate_waybar_output(const std::vector<MetricsContext> &all_results) {
 }
 
 std::string show_top_mem_procs(const MetricsContext &result,
-                               const std::vector<ProcessInfo> &top_procs_mem) {
+                               const ProcessListView &top_procs_mem) {
   std::stringstream tooltip_ss;
   if (!top_procs_mem.empty()) {
     tooltip_ss << "<b>Top Processes (Mem) (" << result.source_name << ")</b>\n";
@@ -117,7 +121,7 @@ std::string show_top_mem_procs(const MetricsContext &result,
                  << vmRssMiB
                  // Add Mem % column
                  << std::right << std::setw(mem_perc_col_width - 1)
-                 << proc.mem_percent << "%"
+                 << proc.mem_percent() << "%"
                  << "  " << proc.name << "\n";
     }
     tooltip_ss << "</tt>\n\n";
@@ -126,7 +130,7 @@ std::string show_top_mem_procs(const MetricsContext &result,
 }
 
 std::string show_top_cpu_procs(const MetricsContext &result,
-                               const std::vector<ProcessInfo> &top_procs_cpu) {
+                               const ProcessListView &top_procs_cpu) {
   std::stringstream tooltip_ss;
   if (!top_procs_cpu.empty()) {
     tooltip_ss << "<b>Top Processes (CPU) (" << result.source_name << ")</b>\n";
@@ -153,11 +157,11 @@ std::string show_top_cpu_procs(const MetricsContext &result,
                  << proc.pid
                  // CPU % column
                  << std::right << std::setw(cpu_col_width - 1)
-                 << proc.cpu_percent
+                 << proc.cpu_percent()
                  << "%"
                  // Add Mem % column
                  << std::right << std::setw(mem_perc_col_width - 1)
-                 << proc.mem_percent << "%"
+                 << proc.mem_percent() << "%"
                  << "  " << proc.name << "\n";
     }
     tooltip_ss << "</tt>\n\n";
@@ -326,7 +330,7 @@ std::string show_system_metrics(const MetricsContext &result,
       if (core.core_id == 0) {
         label = "Avg";
       } else {
-        label = std::to_string(core.core_id - 1);
+        label = std::to_string(core.cpu);
       }
 
       tooltip_ss << "  " << std::setw(4) << std::left << label << std::setw(7)
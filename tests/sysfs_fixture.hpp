@@ -0,0 +1,38 @@
+// tests/sysfs_fixture.hpp
+#ifndef SYSFS_FIXTURE_HPP
+#define SYSFS_FIXTURE_HPP
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace telemetry {
+
+/**
+ * @brief A scratch directory standing in for a sysfs tree.
+ * base is named after the test suite and starts out empty; derived
+ * fixtures call SysfsFixture::SetUp() before writing their files.
+ */
+template <typename Base = ::testing::Test> class SysfsFixture : public Base {
+protected:
+  std::filesystem::path base;
+
+  void SetUp() override {
+    const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+    base = std::filesystem::path(::testing::TempDir()) /
+           info->test_suite_name();
+    std::filesystem::remove_all(base);
+  }
+  void TearDown() override { std::filesystem::remove_all(base); }
+
+  // Creates missing parent directories
+  void write(const std::string &rel, const std::string &content) {
+    auto path = base / rel;
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << content;
+  }
+};
+}; // namespace telemetry
+#endif
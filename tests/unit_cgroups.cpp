@@ -0,0 +1,184 @@
+// tests/unit_cgroups.cpp
+#include "cgroups.hpp"
+#include "mock_context.hpp"
+#include "polling.hpp"
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace telemetry {
+
+namespace fs = std::filesystem;
+
+static bool has_path(const CgroupTree &tree, const std::string &path) {
+  for (const auto &node : tree.nodes()) {
+    if (node.id != 0 && node.path == path)
+      return true;
+  }
+  return false;
+}
+
+static void write_cgroup(const fs::path &dir, unsigned long long usage_usec,
+                         unsigned long long memory_bytes,
+                         unsigned long long rbytes) {
+  fs::create_directories(dir);
+  std::ofstream(dir / "cpu.stat")
+      << "usage_usec " << usage_usec << "\n"
+      << "user_usec 0\nsystem_usec 0\nnr_throttled 0\nthrottled_usec 0\n";
+  std::ofstream(dir / "memory.current") << memory_bytes << "\n";
+  std::ofstream(dir / "memory.pressure")
+      << "some avg10=1.50 avg60=0.00 avg300=0.00 total=100\n"
+      << "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n";
+  std::ofstream(dir / "io.stat") << "8:0 rbytes=" << rbytes
+                                 << " wbytes=0 rios=1 wios=0 dbytes=0 dios=0\n";
+}
+
+class CgroupTest : public MockLocalContext {
+protected:
+  fs::path root;
+
+  void SetUp() override {
+    root = fs::path(testing::TempDir()) / "cgroup_test";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::ofstream(root / "cgroup.controllers") << "cpu io memory\n";
+  }
+  void TearDown() override { fs::remove_all(root); }
+};
+
+TEST(CgroupParse, ReadsCpuStatAndSumsIoStat) {
+  CgroupSample sample;
+  parse_cgroup_cpu_stat("usage_usec 5000\nuser_usec 3000\n"
+                        "system_usec 2000\nnr_periods 4\n"
+                        "throttled_usec 700\n",
+                        sample);
+  EXPECT_EQ(sample.usage_usec, 5000u);
+  EXPECT_EQ(sample.throttled_usec, 700u);
+
+  parse_cgroup_io_stat("8:0 rbytes=100 wbytes=20 rios=1 wios=2 dbytes=0\n"
+                       "259:0 rbytes=5 wbytes=7 rios=1 wios=1 dbytes=9\n",
+                       sample);
+  EXPECT_EQ(sample.io_read_bytes, 105u);
+  EXPECT_EQ(sample.io_write_bytes, 27u);
+}
+
+TEST_F(CgroupTest, TreeFollowsCreatedAndRemovedDirectories) {
+  fs::create_directories(root / "system.slice" / "sshd.service");
+  fs::create_directories(root / "user.slice");
+
+  CgroupTree tree;
+  ASSERT_TRUE(tree.open(root.string()));
+  EXPECT_EQ(tree.size(), 4u);
+  EXPECT_TRUE(has_path(tree, "/system.slice/sshd.service"));
+  EXPECT_FALSE(tree.refresh());
+
+  fs::create_directories(root / "user.slice" / "session-1.scope");
+  fs::remove(root / "system.slice" / "sshd.service");
+  EXPECT_TRUE(tree.refresh());
+  EXPECT_EQ(tree.size(), 4u);
+  EXPECT_TRUE(has_path(tree, "/user.slice/session-1.scope"));
+  EXPECT_FALSE(has_path(tree, "/system.slice/sshd.service"));
+
+  fs::remove_all(root / "user.slice");
+  EXPECT_TRUE(tree.refresh());
+  EXPECT_EQ(tree.size(), 2u);
+}
+
+TEST_F(CgroupTest, ReportsTopCgroupsFromDeltas) {
+  write_cgroup(root / "a", 1000000, 4096 * 1024, 0);
+  write_cgroup(root / "b", 0, 1024 * 1024, 0);
+  context.settings.cgroups.root = root.string();
+  context.settings.cgroups.top_k = 1;
+
+  CgroupPollingTask task(provider, metrics, context);
+  task.take_initial_snapshot();
+  write_cgroup(root / "a", 1500000, 4096 * 1024, 0);
+  write_cgroup(root / "b", 1000000, 1024 * 1024, 8192);
+  // Appears between ticks; it has no previous values to diff against
+  write_cgroup(root / "c", 9000000, 0, 0);
+  task.take_new_snapshot();
+  task.time_delta_seconds = 2.0;
+  task.calculate();
+
+  ASSERT_EQ(task.stats.size(), 3u);
+  ASSERT_EQ(metrics.top_cgroups_cpu.size(), 1u);
+  EXPECT_EQ(metrics.top_cgroups_cpu[0].path, "/b");
+  EXPECT_DOUBLE_EQ(metrics.top_cgroups_cpu[0].cpu_percent, 50.0);
+  ASSERT_EQ(metrics.top_cgroups_mem.size(), 1u);
+  EXPECT_EQ(metrics.top_cgroups_mem[0].path, "/a");
+  EXPECT_EQ(metrics.top_cgroups_mem[0].memory_kb, 4096u);
+  EXPECT_DOUBLE_EQ(metrics.top_cgroups_mem[0].memory_pressure.some.avg10,
+                   1.5);
+  ASSERT_EQ(metrics.top_cgroups_io.size(), 1u);
+  EXPECT_EQ(metrics.top_cgroups_io[0].path, "/b");
+  EXPECT_DOUBLE_EQ(metrics.top_cgroups_io[0].io_read_bytes_per_sec, 4096.0);
+}
+
+TEST_F(CgroupTest, ReadsCgroupsPastTheDirfdLimitByPath) {
+  write_cgroup(root / "a", 1000000, 0, 0);
+  write_cgroup(root / "a" / "b", 1000000, 0, 0);
+  write_cgroup(root / "c", 1000000, 0, 0);
+  context.settings.cgroups.root = root.string();
+  context.settings.cgroups.top_k = 3;
+
+  CgroupPollingTask task(provider, metrics, context);
+  // Only the root and one child keep a directory open
+  ASSERT_TRUE(task.tree.open(root.string(), 2));
+  ASSERT_EQ(task.tree.size(), 4u);
+  size_t by_path = 0;
+  for (const CgroupTree::Node &node : task.tree.nodes())
+    by_path += node.id != 0 && node.dirfd < 0;
+  EXPECT_EQ(by_path, 2u);
+
+  task.take_initial_snapshot();
+  write_cgroup(root / "a", 2000000, 0, 0);
+  write_cgroup(root / "a" / "b", 2000000, 0, 0);
+  write_cgroup(root / "c", 2000000, 0, 0);
+  fs::create_directories(root / "a" / "b" / "d");
+  task.take_new_snapshot();
+  task.time_delta_seconds = 1.0;
+  task.calculate();
+
+  EXPECT_TRUE(has_path(task.tree, "/a/b/d"));
+  ASSERT_EQ(metrics.top_cgroups_cpu.size(), 3u);
+  for (const auto &cgroup : metrics.top_cgroups_cpu)
+    EXPECT_DOUBLE_EQ(cgroup.cpu_percent, 100.0) << cgroup.path;
+}
+
+TEST_F(CgroupTest, TreeFallsBackToPathsOnEmfile) {
+  fs::create_directories(root / "a");
+  fs::create_directories(root / "c" / "d");
+
+  // Room for the root, the inotify fd and one more: listing the root,
+  // then holding /a. /c is opened by path and cannot be listed yet.
+  int probe = ::open("/", O_RDONLY | O_CLOEXEC);
+  ASSERT_GE(probe, 0);
+  ::close(probe);
+  rlimit saved{};
+  ASSERT_EQ(::getrlimit(RLIMIT_NOFILE, &saved), 0);
+  rlimit lowered = saved;
+  lowered.rlim_cur = static_cast<rlim_t>(probe) + 3;
+  ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &lowered), 0);
+
+  CgroupTree tree;
+  bool opened = tree.open(root.string(), 100);
+  ::setrlimit(RLIMIT_NOFILE, &saved);
+
+  ASSERT_TRUE(opened);
+  EXPECT_EQ(tree.size(), 3u);
+  for (const CgroupTree::Node &node : tree.nodes()) {
+    if (node.path == "/c") {
+      EXPECT_LT(node.dirfd, 0);
+    }
+  }
+  // The failed listing is retried once descriptors are available again
+  EXPECT_TRUE(tree.refresh());
+  EXPECT_TRUE(has_path(tree, "/c/d"));
+}
+
+}; // namespace telemetry
@@ -2,6 +2,7 @@
 #include "corestat.hpp"
 #include "mock_context.hpp"
 #include "polling.hpp"
+#include "sysfs_fixture.hpp"
 #include <gtest/gtest.h>
 
 namespace telemetry {
@@ -44,6 +45,32 @@ TEST_F(CpuCoverageTest, CounterWrapHandling) {
   EXPECT_FLOAT_EQ(metrics.cores[0].idle_percent, 100.0f);
 }
 
+// Enough rows for a vector body plus a scalar tail, each lane different
+TEST(CpuUsageKernel, MasksWrappedAndIdleRowsPerLane) {
+  CpuSnapshotList prev, curr;
+  for (int row = 0; row < 7; ++row) {
+    CpuSnapshot before{1000, 0, 1000, 1000, 0, 0, 0, 0};
+    CpuSnapshot after{1100, 0, 1100, 1200, 0, 0, 0, 0}; // 50% busy
+    if (row == 2)
+      before.steal = 5; // One column went backwards
+    if (row == 4)
+      after = before; // Did not advance
+    if (row == 6)
+      after.idle = before.idle + (1ull << 32); // Too large for a lane
+    prev.push_back(before);
+    curr.push_back(after);
+  }
+
+  CpuUsageArrays usage;
+  compute_cpu_usage(prev, curr, prev.size(), usage);
+  for (size_t row = 0; row < 7; ++row) {
+    bool valid = row != 2 && row != 4 && row != 6;
+    EXPECT_FLOAT_EQ(usage.total[row], valid ? 50.0f : 0.0f) << row;
+    EXPECT_FLOAT_EQ(usage.idle[row], valid ? 50.0f : 100.0f) << row;
+    EXPECT_FLOAT_EQ(usage.steal[row], 0.0f) << row;
+  }
+}
+
 // Test: Aggregate Accuracy (Index 0)
 TEST_F(CpuCoverageTest, AggregateAccuracy) {
   CpuPollingTask task(provider, metrics, context);
@@ -58,6 +85,26 @@ TEST_F(CpuCoverageTest, AggregateAccuracy) {
   EXPECT_NEAR(metrics.cores[0].total_usage_percent, 50.0f, 0.01f);
 }
 
+TEST_F(CpuCoverageTest, IrqSoftirqAndStealReported) {
+  CpuPollingTask task(provider, metrics, context);
+
+  // user nice system idle iowait irq softirq steal
+  CpuSnapshot t1{0, 0, 0, 0, 0, 0, 0, 0};
+  CpuSnapshot t2{40, 0, 20, 100, 0, 10, 10, 20}; // 200 total
+  task.prev_snapshots = {t1, t1, t2};
+  task.current_snapshots = {t2, t2, t1}; // Row 2 went backwards
+
+  task.calculate();
+  ASSERT_EQ(metrics.cores.size(), 3u);
+  EXPECT_NEAR(metrics.cores[1].irq_percent, 5.0f, 0.01f);
+  EXPECT_NEAR(metrics.cores[1].softirq_percent, 5.0f, 0.01f);
+  EXPECT_NEAR(metrics.cores[1].steal_percent, 10.0f, 0.01f);
+  EXPECT_NEAR(metrics.cores[1].total_usage_percent, 30.0f, 0.01f);
+  EXPECT_FLOAT_EQ(metrics.cores[2].idle_percent, 100.0f);
+  EXPECT_FLOAT_EQ(metrics.cores[2].steal_percent, 0.0f);
+  EXPECT_EQ(metrics.cores[2].core_id, 2u);
+}
+
 TEST_F(CpuCoverageTest, AggregateIsZeroIndex) {
   CpuPollingTask task(provider, metrics, context);
   std::string mock_stat =
@@ -75,4 +122,251 @@ TEST_F(CpuCoverageTest, AggregateIsZeroIndex) {
   EXPECT_EQ(metrics.cores[0].core_id, 0); // Must be 0
 }
 
+class CpuIdleTest : public SysfsFixture<MockLocalContext> {
+protected:
+  void SetUp() override {
+    SysfsFixture::SetUp();
+    // Created out of order; discovery sorts by CPU number
+    for (int cpu : {1, 0}) {
+      std::string dir = "cpu" + std::to_string(cpu) + "/cpuidle/";
+      write(dir + "state0/name", "POLL\n");
+      write(dir + "state0/time", "0\n");
+      write(dir + "state0/usage", "0\n");
+      write(dir + "state1/name", "C6\n");
+      write(dir + "state1/time", "1000000\n");
+      write(dir + "state1/usage", "50\n");
+    }
+  }
+};
+
+TEST_F(CpuIdleTest, DiscoversStatesInOrder) {
+  CpuIdlePollingTask task(provider, metrics, context);
+  task.discover(base.string());
+
+  ASSERT_EQ(task.cpus.size(), 2u);
+  EXPECT_EQ(task.cpus[0].cpu, 0u);
+  EXPECT_EQ(task.cpus[1].cpu, 1u);
+  EXPECT_EQ(task.cpus[1].first, 2u);
+  ASSERT_EQ(task.cpus[0].names.size(), 2u);
+  EXPECT_EQ(task.cpus[0].names[1], "C6");
+
+  auto snapshots = task.read_snapshot();
+  ASSERT_EQ(snapshots.size(), 4u);
+  EXPECT_EQ(snapshots[3].time_us, 1000000u);
+  EXPECT_EQ(snapshots[3].usage, 50u);
+}
+
+TEST_F(CpuIdleTest, ResidencyAndWakeupsFromDeltas) {
+  CpuIdlePollingTask task(provider, metrics, context);
+  task.discover(base.string());
+  task.prev_snapshots = task.read_snapshot();
+
+  // Over two seconds cpu0 spends 1.5s in C6, cpu1 0.5s, with 0.1s polling
+  write("cpu0/cpuidle/state0/time", "100000\n");
+  write("cpu0/cpuidle/state0/usage", "10\n");
+  write("cpu0/cpuidle/state1/time", "2500000\n");
+  write("cpu0/cpuidle/state1/usage", "250\n");
+  write("cpu1/cpuidle/state1/time", "1500000\n");
+  write("cpu1/cpuidle/state1/usage", "70\n");
+  task.current_snapshots = task.read_snapshot();
+  task.time_delta_seconds = 2.0;
+
+  metrics.cores.resize(3);
+  for (size_t i = 0; i < metrics.cores.size(); ++i) {
+    metrics.cores[i].core_id = i;
+    metrics.cores[i].cpu = i ? i - 1 : 0;
+  }
+  task.calculate();
+
+  const auto &cpu0 = metrics.cores[1];
+  ASSERT_EQ(cpu0.idle_states.size(), 2u);
+  EXPECT_EQ(cpu0.idle_states[0].name, "POLL");
+  EXPECT_NEAR(cpu0.idle_states[0].residency_percent, 5.0f, 0.01f);
+  EXPECT_NEAR(cpu0.idle_states[1].residency_percent, 75.0f, 0.01f);
+  EXPECT_DOUBLE_EQ(cpu0.wakeups_per_sec, 105.0);
+
+  const auto &cpu1 = metrics.cores[2];
+  EXPECT_NEAR(cpu1.idle_states[1].residency_percent, 25.0f, 0.01f);
+  EXPECT_DOUBLE_EQ(cpu1.wakeups_per_sec, 10.0);
+
+  const auto &aggregate = metrics.cores[0];
+  ASSERT_EQ(aggregate.idle_states.size(), 2u);
+  EXPECT_EQ(aggregate.idle_states[1].name, "C6");
+  EXPECT_NEAR(aggregate.idle_states[1].residency_percent, 50.0f, 0.01f);
+  EXPECT_DOUBLE_EQ(aggregate.wakeups_per_sec, 115.0);
+}
+
+TEST_F(CpuIdleTest, MatchesCoresByCpuNumber) {
+  CpuIdlePollingTask task(provider, metrics, context);
+  task.discover(base.string());
+  task.prev_snapshots = task.read_snapshot();
+  write("cpu1/cpuidle/state1/time", "2000000\n");
+  task.current_snapshots = task.read_snapshot();
+  task.time_delta_seconds = 2.0;
+
+  // cpu0 is offline, so the only per-core entry is cpu1
+  metrics.cores.resize(2);
+  metrics.cores[1].core_id = 1;
+  metrics.cores[1].cpu = 1;
+  task.calculate();
+
+  ASSERT_EQ(metrics.cores[1].idle_states.size(), 2u);
+  EXPECT_NEAR(metrics.cores[1].idle_states[1].residency_percent, 50.0f,
+              0.01f);
+}
+
+class CpuTopologyTest : public SysfsFixture<MockLocalContext> {
+protected:
+  void SetUp() override {
+    SysfsFixture::SetUp();
+    // Two packages with one SMT core each: cpu0/cpu2 and cpu1/cpu3
+    for (int cpu = 0; cpu < 4; ++cpu) {
+      std::string dir = "cpu" + std::to_string(cpu) + "/";
+      std::string package = std::to_string(cpu % 2);
+      write(dir + "topology/physical_package_id", package + "\n");
+      write(dir + "topology/core_id", "0\n");
+      std::filesystem::create_directories(base / (dir + "node" + package));
+    }
+    // Offline CPUs have no topology
+    std::filesystem::create_directories(base / "cpu4");
+  }
+};
+
+TEST_F(CpuTopologyTest, LoadsPackagesCoresAndNodes) {
+  CpuTopology topology;
+  topology.load(base.string());
+
+  ASSERT_EQ(topology.packages.size(), 2u);
+  EXPECT_EQ(topology.packages[1].id, 1u);
+  EXPECT_EQ(topology.packages[1].cpus, (std::vector<size_t>{1, 3}));
+  ASSERT_EQ(topology.physical_cores.size(), 2u);
+  EXPECT_EQ(topology.physical_cores[0].id, 0u); // First sibling
+  EXPECT_EQ(topology.physical_cores[0].cpus, (std::vector<size_t>{0, 2}));
+  EXPECT_EQ(topology.physical_cores[1].id, 1u);
+  ASSERT_EQ(topology.numa_nodes.size(), 2u);
+  EXPECT_EQ(topology.numa_nodes[0].cpus, (std::vector<size_t>{0, 2}));
+}
+
+TEST_F(CpuTopologyTest, GroupsSumDeltasBeforeDividing) {
+  CpuPollingTask task(provider, metrics, context);
+  task.topology.load(base.string());
+
+  // user nice system idle iowait irq softirq steal cpu
+  auto zero = [](size_t cpu) {
+    return CpuSnapshot{0, 0, 0, 0, 0, 0, 0, 0, cpu};
+  };
+  CpuSnapshot busy{100, 0, 0, 0, 0, 0, 0, 0, 0};
+  CpuSnapshot half{50, 0, 0, 50, 0, 0, 0, 0, 1};
+  CpuSnapshot idle{0, 0, 0, 300, 0, 0, 0, 0, 2};
+  CpuSnapshot half3{50, 0, 0, 50, 0, 0, 0, 0, 3};
+  // Rows: aggregate, cpu0, cpu1, cpu2, cpu3
+  task.prev_snapshots = {zero(0), zero(0), zero(1), zero(2), zero(3)};
+  task.current_snapshots = {zero(0), busy, half, idle, half3};
+  task.calculate();
+
+  // cpu0 + cpu2 = 100 busy out of 400, not the 50% mean of the two cores
+  ASSERT_EQ(metrics.cpu_packages.size(), 2u);
+  EXPECT_EQ(metrics.cpu_packages[0].cpu_count, 2u);
+  EXPECT_NEAR(metrics.cpu_packages[0].total_usage_percent, 25.0f, 0.01f);
+  EXPECT_NEAR(metrics.cpu_packages[1].total_usage_percent, 50.0f, 0.01f);
+  ASSERT_EQ(metrics.cpu_physical_cores.size(), 2u);
+  EXPECT_NEAR(metrics.cpu_physical_cores[0].idle_percent, 75.0f, 0.01f);
+  ASSERT_EQ(metrics.numa_nodes.size(), 2u);
+  EXPECT_EQ(metrics.numa_nodes[1].id, 1u);
+  EXPECT_NEAR(metrics.numa_nodes[1].user_percent, 50.0f, 0.01f);
+}
+
+TEST_F(CpuTopologyTest, GroupsFollowCpuNumbersWhenOneIsOffline) {
+  CpuPollingTask task(provider, metrics, context);
+  task.topology.load(base.string());
+
+  // cpu1 is offline, so /proc/stat skips it and cpu2 is row 2
+  std::istringstream prev("cpu  0 0 0 0 0 0 0 0\n"
+                          "cpu0 0 0 0 0 0 0 0 0\n"
+                          "cpu2 0 0 0 0 0 0 0 0\n"
+                          "cpu3 0 0 0 0 0 0 0 0\n");
+  std::istringstream curr("cpu  150 0 0 450 0 0 0 0\n"
+                          "cpu0 100 0 0 0 0 0 0 0\n"
+                          "cpu2 0 0 0 300 0 0 0 0\n"
+                          "cpu3 50 0 0 150 0 0 0 0\n");
+  task.prev_snapshots = task.read_data(prev);
+  task.current_snapshots = task.read_data(curr);
+  EXPECT_EQ(task.current_snapshots.cpu, (std::vector<size_t>{0, 0, 2, 3}));
+  EXPECT_EQ(task.current_snapshots.find_row(1), 4u);
+  task.calculate();
+
+  ASSERT_EQ(metrics.cores.size(), 4u);
+  EXPECT_EQ(metrics.cores[2].cpu, 2u);
+  EXPECT_EQ(metrics.cores[3].cpu, 3u);
+  // Package 0 is cpu0 + cpu2; package 1 only has cpu3 online
+  ASSERT_EQ(metrics.cpu_packages.size(), 2u);
+  EXPECT_NEAR(metrics.cpu_packages[0].total_usage_percent, 25.0f, 0.01f);
+  EXPECT_NEAR(metrics.cpu_packages[1].total_usage_percent, 25.0f, 0.01f);
+}
+
+TEST(SchedstatParse, TakesTheLastThreeFieldsPerCpu) {
+  SchedstatSnapshotList rows;
+  ASSERT_TRUE(parse_schedstat("version 15\n"
+                              "timestamp 4295000000\n"
+                              "cpu0 0 0 10 5 8 2 1000 200 40\n"
+                              "domain0 00000003 1 2 3 4 5 6 7 8 9\n"
+                              "cpu2 0 0 10 5 8 2 3000 600 20\n",
+                              rows));
+  ASSERT_EQ(rows.size(), 3u);
+  EXPECT_EQ(rows[0].wait_ns, 800u); // Aggregate
+  EXPECT_EQ(rows[0].timeslices, 60u);
+  EXPECT_EQ(rows[2].cpu, 2u);
+  EXPECT_EQ(rows[2].run_ns, 3000u);
+  EXPECT_EQ(rows[2].wait_ns, 600u);
+  EXPECT_EQ(rows[2].timeslices, 20u);
+}
+
+class SchedstatTest : public MockLocalContext {};
+
+TEST_F(SchedstatTest, LatencyFromWaitAndTimesliceDeltas) {
+  SchedstatPollingTask task(provider, metrics, context);
+  ASSERT_TRUE(parse_schedstat("cpu0 0 0 0 0 0 0 0 0 0\n"
+                              "cpu1 0 0 0 0 0 0 0 0 0\n",
+                              task.prev_snapshots));
+  // cpu0 waited 4 ms over 100 slices, cpu1 12 ms over 100 slices
+  ASSERT_TRUE(parse_schedstat("cpu0 0 0 0 0 0 0 9000000 4000000 100\n"
+                              "cpu1 0 0 0 0 0 0 9000000 12000000 100\n",
+                              task.current_snapshots));
+  metrics.cores.resize(3);
+  for (size_t i = 0; i < metrics.cores.size(); ++i) {
+    metrics.cores[i].core_id = i;
+    metrics.cores[i].cpu = i ? i - 1 : 0;
+  }
+  task.time_delta_seconds = 2.0;
+  task.calculate();
+
+  EXPECT_DOUBLE_EQ(metrics.cores[1].runqueue_wait_ms_per_sec, 2.0);
+  EXPECT_DOUBLE_EQ(metrics.cores[1].timeslices_per_sec, 50.0);
+  EXPECT_DOUBLE_EQ(metrics.cores[1].sched_latency_us, 40.0);
+  EXPECT_DOUBLE_EQ(metrics.cores[2].sched_latency_us, 120.0);
+  // The aggregate divides summed deltas: 16 ms over 200 slices
+  EXPECT_DOUBLE_EQ(metrics.cores[0].runqueue_wait_ms_per_sec, 8.0);
+  EXPECT_DOUBLE_EQ(metrics.cores[0].sched_latency_us, 80.0);
+}
+
+TEST_F(SchedstatTest, MatchesCoresByCpuNumber) {
+  SchedstatPollingTask task(provider, metrics, context);
+  // cpu1 is offline: the second per-core entry is cpu2
+  ASSERT_TRUE(parse_schedstat("cpu0 0 0 0 0 0 0 0 0 0\n"
+                              "cpu2 0 0 0 0 0 0 0 0 0\n",
+                              task.prev_snapshots));
+  ASSERT_TRUE(parse_schedstat("cpu0 0 0 0 0 0 0 0 2000000 100\n"
+                              "cpu2 0 0 0 0 0 0 0 6000000 100\n",
+                              task.current_snapshots));
+  metrics.cores.resize(3);
+  for (size_t i = 0; i < metrics.cores.size(); ++i)
+    metrics.cores[i].core_id = i;
+  metrics.cores[2].cpu = 2;
+  task.time_delta_seconds = 1.0;
+  task.calculate();
+
+  EXPECT_DOUBLE_EQ(metrics.cores[1].sched_latency_us, 20.0);
+  EXPECT_DOUBLE_EQ(metrics.cores[2].sched_latency_us, 60.0);
+}
+
 }; // namespace telemetry
@@ -0,0 +1,109 @@
+// tests/unit_cpufreq.cpp
+#include "cpuinfo.hpp"
+#include "mock_context.hpp"
+#include "polling.hpp"
+#include "sysfs_fixture.hpp"
+#include <gtest/gtest.h>
+
+namespace telemetry {
+
+class CpuFrequencyTest : public SysfsFixture<MockLocalContext> {
+protected:
+  void SetUp() override {
+    SysfsFixture::SetUp();
+    for (int cpu = 0; cpu < 2; ++cpu) {
+      std::string dir = "cpu" + std::to_string(cpu) + "/";
+      write(dir + "cpufreq/scaling_cur_freq", cpu ? "1800000\n" : "3600000\n");
+      write(dir + "thermal_throttle/core_throttle_count", "10\n");
+      write(dir + "thermal_throttle/package_throttle_count", "100\n");
+      write(dir + "topology/physical_package_id", "0\n");
+    }
+    // Not CPUs
+    write("cpufreq/boost", "1\n");
+    write("cpuidle/current_driver", "intel_idle\n");
+  }
+};
+
+TEST_F(CpuFrequencyTest, ReadsSysfsFrequencyAndThrottles) {
+  CpuFrequencyPollingTask task(provider, metrics, context);
+  task.discover(base.string());
+  ASSERT_EQ(task.cpus.size(), 2u);
+  EXPECT_TRUE(task.has_cpufreq);
+
+  auto snapshots = task.read_snapshot();
+  ASSERT_EQ(snapshots.size(), 2u);
+  EXPECT_DOUBLE_EQ(snapshots[0].frequency_mhz, 3600.0);
+  EXPECT_DOUBLE_EQ(snapshots[1].frequency_mhz, 1800.0);
+  EXPECT_EQ(snapshots[1].core_throttles, 10u);
+  EXPECT_EQ(snapshots[1].package_throttles, 100u);
+}
+
+TEST_F(CpuFrequencyTest, AnnotatesCoresWithDeltas) {
+  CpuFrequencyPollingTask task(provider, metrics, context);
+  task.discover(base.string());
+  task.take_initial_snapshot();
+
+  // The open fds pick up new values without rediscovery
+  write("cpu1/thermal_throttle/core_throttle_count", "13\n");
+  write("cpu0/thermal_throttle/package_throttle_count", "105\n");
+  write("cpu1/thermal_throttle/package_throttle_count", "105\n");
+  task.take_new_snapshot();
+
+  metrics.cores.resize(3);
+  for (size_t i = 0; i < metrics.cores.size(); ++i) {
+    metrics.cores[i].core_id = i;
+    metrics.cores[i].cpu = i ? i - 1 : 0;
+  }
+  task.calculate();
+
+  EXPECT_DOUBLE_EQ(metrics.cpu_frequency_ghz, 2.7);
+  EXPECT_DOUBLE_EQ(metrics.cores[0].frequency_mhz, 2700.0);
+  EXPECT_EQ(metrics.cores[0].core_throttle_events, 3u);
+  // Both CPUs share package 0, so its events are counted once
+  EXPECT_EQ(metrics.cores[0].package_throttle_events, 5u);
+
+  EXPECT_DOUBLE_EQ(metrics.cores[1].frequency_mhz, 3600.0);
+  EXPECT_EQ(metrics.cores[1].core_throttle_events, 0u);
+  EXPECT_EQ(metrics.cores[2].core_throttle_events, 3u);
+  EXPECT_EQ(metrics.cores[2].package_throttle_events, 5u);
+}
+
+TEST_F(CpuFrequencyTest, MapsCoresByCpuNumber) {
+  CpuFrequencyPollingTask task(provider, metrics, context);
+  task.discover(base.string());
+  task.take_initial_snapshot();
+  write("cpu1/thermal_throttle/core_throttle_count", "12\n");
+  task.take_new_snapshot();
+
+  // cpu0 is offline, so the first per-core entry is cpu1
+  metrics.cores.resize(2);
+  metrics.cores[1].core_id = 1;
+  metrics.cores[1].cpu = 1;
+  task.calculate();
+
+  EXPECT_DOUBLE_EQ(metrics.cores[1].frequency_mhz, 1800.0);
+  EXPECT_EQ(metrics.cores[1].core_throttle_events, 2u);
+}
+
+TEST_F(CpuFrequencyTest, FallsBackToCpuinfo) {
+  std::istringstream cpuinfo("processor\t: 0\n"
+                             "model name\t: Test CPU\n"
+                             "cpu MHz\t\t: 2400.500\n"
+                             "\n"
+                             "processor\t: 1\n"
+                             "cpu MHz\t\t: 1200.000\n");
+  auto freqs = get_core_freqs_mhz(cpuinfo);
+  ASSERT_EQ(freqs.size(), 2u);
+  EXPECT_DOUBLE_EQ(freqs[0], 2400.5);
+  EXPECT_DOUBLE_EQ(freqs[1], 1200.0);
+
+  // Throttle counters without cpufreq still come from sysfs
+  std::filesystem::remove_all(base / "cpu0/cpufreq");
+  std::filesystem::remove_all(base / "cpu1/cpufreq");
+  CpuFrequencyPollingTask task(provider, metrics, context);
+  task.discover(base.string());
+  EXPECT_FALSE(task.has_cpufreq);
+  EXPECT_EQ(task.read_snapshot()[0].core_throttles, 10u);
+}
+
+}; // namespace telemetry
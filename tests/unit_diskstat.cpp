@@ -0,0 +1,221 @@
+// tests/unit_diskstat.cpp
+#include "diskstat.hpp"
+#include "filesystems.hpp"
+#include "mock_context.hpp"
+#include "polling.hpp"
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+namespace telemetry {
+
+class DiskStatTest : public MockLocalContext {};
+
+TEST_F(DiskStatTest, ParsesExtendedFields) {
+  DiskPollingTask task(provider, metrics, context);
+  std::istringstream in(
+      "   8 16 sdb 100 2 800 50 200 4 1600 70 3 90 130 5 0 40 6 7 8\n"
+      "   8 0 sda 10 0 80 5 20 0 160 7 0 9 12\n");
+
+  auto snapshots = task.read_data(in);
+  ASSERT_EQ(snapshots.size(), 2u);
+
+  const auto &full = snapshots["sdb"];
+  EXPECT_EQ(full.bytes_read, 800u * 512);
+  EXPECT_EQ(full.writes_completed, 200u);
+  EXPECT_EQ(full.ios_in_progress, 3u);
+  EXPECT_EQ(full.weighted_io_ms, 130u);
+  EXPECT_EQ(full.discards_completed, 5u);
+  EXPECT_EQ(full.flushes_completed, 7u);
+  EXPECT_EQ(full.time_flushing_ms, 8u);
+
+  // Pre-4.18 line: discard/flush fields default to zero
+  const auto &sda = snapshots["sda"];
+  EXPECT_EQ(sda.io_ticks_ms, 9u);
+  EXPECT_EQ(sda.discards_completed, 0u);
+}
+
+TEST_F(DiskStatTest, TopKWithOtherBucket) {
+  context.settings.storage.top_k = 2;
+  DiskPollingTask task(provider, metrics, context);
+
+  DiskIoSnapshotMap t1, t2;
+  const std::vector<std::pair<std::string, uint64_t>> traffic = {
+      {"sda", 4000}, {"sdb", 100}, {"sdc", 9000}, {"sdd", 300}};
+  for (const auto &[name, bytes] : traffic) {
+    t1[name];
+    t2[name].bytes_read = bytes;
+    t2[name].reads_completed = bytes / 100;
+    t2[name].time_reading_ms = bytes / 100;
+  }
+
+  task.prev_snapshots = t1;
+  task.current_snapshots = t2;
+  task.time_delta_seconds = 1.0;
+  task.calculate();
+
+  const auto &out = metrics.disk_io;
+  ASSERT_EQ(out.size(), 3u);
+  EXPECT_EQ(out[0].device_name, "sdc");
+  EXPECT_EQ(out[1].device_name, "sda");
+  EXPECT_EQ(out[2].device_name, "other");
+  EXPECT_EQ(out[2].read_bytes_per_sec, 400u);
+  EXPECT_DOUBLE_EQ(out[2].read_iops, 4.0);
+  EXPECT_DOUBLE_EQ(out[2].read_await_ms, 1.0);
+  EXPECT_EQ(out[2].aggregated_devices, 2u);
+}
+
+TEST_F(DiskStatTest, ReopensMissingStatFiles) {
+  auto base = std::filesystem::path(testing::TempDir()) / "block_class_test";
+  std::filesystem::remove_all(base);
+  std::filesystem::create_directories(base / "sda");
+  std::ofstream(base / "sda/stat") << "1 0 8 0 2 0 16 0 0 0 0\n";
+
+  context.io_devices = {"sda", "sdb"};
+  DiskPollingTask task(provider, metrics, context);
+  task.block_class_dir = base.string();
+  task.open_stat_files();
+  ASSERT_EQ(task.stat_files.size(), 2u);
+
+  // sdb is missing, but sda still uses its own stat file
+  auto snapshots = task.read_snapshot();
+  EXPECT_EQ(snapshots.size(), 1u);
+  EXPECT_EQ(snapshots["sda"].reads_completed, 1u);
+
+  std::filesystem::create_directories(base / "sdb");
+  std::ofstream(base / "sdb/stat") << "5 0 40 0 0 0 0 0 0 0 0\n";
+  snapshots = task.read_snapshot();
+  EXPECT_EQ(snapshots["sdb"].reads_completed, 5u);
+
+  std::filesystem::remove_all(base);
+}
+
+TEST_F(DiskStatTest, MapsDevicesThatAppearLater) {
+  struct stat st;
+  if (::stat("/dev/loop1", &st) != 0 || !S_ISBLK(st.st_mode))
+    GTEST_SKIP() << "needs /dev/loop1";
+  auto base = std::filesystem::path(testing::TempDir()) / "late_device_test";
+  std::filesystem::remove_all(base);
+  std::filesystem::create_directories(base);
+  auto link = base / "backup";
+
+  context.filesystems = {link.string()};
+  DiskPollingTask task(provider, metrics, context);
+  ASSERT_EQ(metrics.disks.size(), 1u);
+  EXPECT_TRUE(task.kernel_to_device_map.empty());
+
+  // Plugged in and mounted after startup
+  std::filesystem::create_symlink("/dev/loop1", link);
+  task.mount_table.load("40 1 " + std::to_string(major(st.st_rdev)) + ":" +
+                        std::to_string(minor(st.st_rdev)) +
+                        " / /mnt/backup rw - ext4 /dev/loop1 rw\n");
+  task.refresh_mount_points();
+  EXPECT_EQ(task.kernel_to_device_map["loop1"], &metrics.disks[0]);
+  EXPECT_EQ(metrics.disks[0].mount_point, "/mnt/backup");
+  EXPECT_TRUE(task.unmapped_devices.empty());
+
+  std::filesystem::remove_all(base);
+}
+
+TEST(DiskIoDerived, ParsesSysfsStatLayout) {
+  // /sys/class/block/<dev>/stat: no major/minor/name, padded columns
+  DiskIoSnapshot snap;
+  parse_disk_counters("     120        3     960       44      80        1 "
+                      "     640       21        0       55       65\n",
+                      snap);
+  EXPECT_EQ(snap.reads_completed, 120u);
+  EXPECT_EQ(snap.bytes_written, 640u * 512);
+  EXPECT_EQ(snap.weighted_io_ms, 65u);
+  EXPECT_EQ(snap.flushes_completed, 0u);
+}
+
+TEST(DiskIoDerived, IopsUtilAwaitQueue) {
+  DiskIoSnapshot t1, t2;
+  t2.reads_completed = 100;
+  t2.time_reading_ms = 200;
+  t2.writes_completed = 50;
+  t2.time_writing_ms = 400;
+  t2.io_ticks_ms = 500;
+  t2.weighted_io_ms = 1500;
+  t2.ios_in_progress = 4;
+
+  DiskIoStats io = calculate_disk_io(t1, t2, 1.0);
+  EXPECT_DOUBLE_EQ(io.read_iops, 100.0);
+  EXPECT_DOUBLE_EQ(io.write_iops, 50.0);
+  EXPECT_DOUBLE_EQ(io.util_percent, 50.0);
+  EXPECT_DOUBLE_EQ(io.read_await_ms, 2.0);
+  EXPECT_DOUBLE_EQ(io.write_await_ms, 8.0);
+  EXPECT_DOUBLE_EQ(io.await_ms, 4.0);
+  EXPECT_DOUBLE_EQ(io.avg_queue_size, 1.5);
+  EXPECT_EQ(io.in_flight, 4u);
+}
+
+TEST(DiskIoDerived, ResetCountersYieldZero) {
+  DiskIoSnapshot t1, t2;
+  t1.reads_completed = 1000;
+  t1.io_ticks_ms = 1000;
+
+  DiskIoStats io = calculate_disk_io(t1, t2, 1.0);
+  EXPECT_DOUBLE_EQ(io.read_iops, 0.0);
+  EXPECT_DOUBLE_EQ(io.util_percent, 0.0);
+  EXPECT_DOUBLE_EQ(io.await_ms, 0.0);
+}
+
+TEST(MountTableTest, KeyedByDeviceNumber) {
+  MountTable table;
+  table.load(
+      "22 1 0:21 / /proc rw,nosuid - proc proc rw\n"
+      "30 1 8:2 /srv/data /data rw,relatime - ext4 /dev/sda2 rw\n"
+      "31 1 8:2 / /srv rw,relatime - ext4 /dev/sda2 rw\n"
+      "32 1 8:17 / /mnt/my\\040disk rw - xfs /dev/sdb1 rw\n"
+      "33 1 8:33 / /mnt/not\\890octal rw - xfs /dev/sdc1 rw\n");
+
+  // The filesystem root wins over an earlier bind mount of a subtree
+  EXPECT_EQ(table.find(makedev(8, 2)), "/srv");
+  EXPECT_EQ(table.find(makedev(8, 17)), "/mnt/my disk");
+  EXPECT_EQ(table.find(makedev(8, 33)), "/mnt/not\\890octal");
+  EXPECT_EQ(table.find(makedev(8, 99)), "");
+}
+
+TEST(MountTableTest, AnonymousDevicesMatchBySource) {
+  MountTable table;
+  // btrfs reports an anonymous device; subvolumes are not the fs root
+  table.load("40 1 0:45 /@ / rw,relatime - btrfs /dev/sda3 rw,subvol=/@\n"
+             "41 1 0:45 /@home /home rw - btrfs /dev/sda3 rw,subvol=/@home\n"
+             "42 1 0:46 / /data rw shared:5 - btrfs /dev/sdb1 rw\n");
+
+  EXPECT_EQ(table.find(makedev(8, 3), "/dev/sda3"), "/");
+  EXPECT_EQ(table.find(makedev(8, 17), "/dev/sdb1"), "/data");
+  EXPECT_EQ(table.find(makedev(8, 17)), "");
+  EXPECT_EQ(table.find(makedev(8, 33), "/dev/sdc1"), "");
+}
+
+TEST(UsageRefresherTest, ReportsUsageAndInodes) {
+  UsageRefresher refresher;
+  refresher.start(std::chrono::seconds(60), std::chrono::seconds(2));
+  refresher.set_mount_points({"/"});
+
+  DiskUsage usage;
+  for (int i = 0; i < 200 && !refresher.get("/", usage); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  EXPECT_GT(usage.size_bytes, 0u);
+  EXPECT_GT(usage.inodes_total, 0u);
+  EXPECT_FALSE(usage.stale);
+  EXPECT_FALSE(refresher.get("/not-watched", usage));
+}
+
+TEST(UsageRefresherTest, PrunesProbesOfUnwatchedMounts) {
+  UsageRefresher refresher;
+  std::promise<DiskUsage> hung, finished, kept;
+  finished.set_value(DiskUsage());
+  refresher.pending.emplace("/hung", hung.get_future());
+  refresher.pending.emplace("/finished", finished.get_future());
+  refresher.pending.emplace("/kept", kept.get_future());
+
+  refresher.prune_pending({"/kept"});
+  ASSERT_EQ(refresher.pending.size(), 1u);
+  EXPECT_EQ(refresher.pending.begin()->first, "/kept");
+}
+
+}; // namespace telemetry
@@ -1,13 +1,34 @@
 // tests/unit_frag.cpp
 #include "frag_stats.cpp"
+#include "mock_context.hpp"
 #include <gtest/gtest.h>
 
 namespace telemetry {
 
+static const char *BUDDYINFO_SAMPLE =
+    "Node 0, zone      DMA      0      0      0      0      0      0      0 "
+    "     0      1      1      2\n"
+    "Node 0, zone   Normal   1000      0      0      0      0      0      0 "
+    "     0      0      0      0\n"
+    "Node 1, zone   Normal      4      2      1      0      0      0      0 "
+    "     0      0      0      0\n";
+
+static const char *PAGETYPEINFO_SAMPLE =
+    "Page block order: 9\n"
+    "Pages per block:  512\n"
+    "\n"
+    "Free pages count per migrate type at order       0      1      2\n"
+    "Node    0, zone      DMA, type    Unmovable      0      0      0\n"
+    "Node    0, zone      DMA, type      Movable      1      1      1\n"
+    "Node    1, zone   Normal, type      Movable      4      2      1\n"
+    "\n"
+    "Number of blocks type     Unmovable      Movable\n"
+    "Node 0, zone      DMA            1            7\n";
+
 TEST(FragmentationTest, ContiguousMemory) {
   // Large blocks available at order 10
-  std::vector<int> contiguous = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 10};
-  double index = calculate_fragmentation_index(contiguous);
+  BuddyOrders contiguous = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 10};
+  double index = fragmentation_index(contiguous.data(), 11);
 
   // Contiguous memory should result in a low index (near 0)
   EXPECT_LT(index, 0.1);
@@ -15,18 +36,85 @@ TEST(FragmentationTest, ContiguousMemory) {
 
 TEST(FragmentationTest, HighlyFragmentedMemory) {
   // Only small 4K pages available (Order 0)
-  std::vector<int> fragmented = {1000, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  double index = calculate_fragmentation_index(fragmented);
+  BuddyOrders fragmented = {1000, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  double index = fragmentation_index(fragmented.data(), 11);
 
   // Fully fragmented memory should result in index 1.0
   EXPECT_NEAR(index, 1.0, 0.001);
 }
 
 TEST(FragmentationTest, EmptyBuddyInfo) {
-  std::vector<int> empty = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  double index = calculate_fragmentation_index(empty);
+  BuddyOrders empty = {};
+  double index = fragmentation_index(empty.data(), 11);
 
   EXPECT_EQ(index, 0.0); // Should handle division by zero safely
 }
 
+TEST(FragmentationTest, ParsesBuddyinfoIntoMatrix) {
+  BuddyMatrix matrix;
+  ASSERT_TRUE(parse_buddyinfo(BUDDYINFO_SAMPLE, matrix));
+  ASSERT_EQ(matrix.zones.size(), 3u);
+  EXPECT_EQ(matrix.orders, 11u);
+  EXPECT_EQ(matrix.zones[0].name, "DMA");
+  EXPECT_EQ(matrix.zones[2].node, 1u);
+  EXPECT_EQ(matrix.free_blocks[0][10], 2u);
+  EXPECT_EQ(matrix.free_blocks[1][0], 1000u);
+
+  // Re-parsing the same layout keeps the zone names' storage
+  const char *name = matrix.zones[1].name.data();
+  ASSERT_TRUE(parse_buddyinfo(BUDDYINFO_SAMPLE, matrix));
+  EXPECT_EQ(matrix.zones[1].name.data(), name);
+
+  EXPECT_FALSE(parse_buddyinfo("", matrix));
+  EXPECT_TRUE(matrix.zones.empty());
+}
+
+TEST(FragmentationTest, SumsPagetypeinfoPerMigrateType) {
+  std::vector<ZoneFragmentation> zones(2);
+  zones[0].zone = "DMA";
+  zones[1].node = 1;
+  zones[1].zone = "Normal";
+  parse_pagetypeinfo(PAGETYPEINFO_SAMPLE, zones);
+
+  ASSERT_EQ(zones[0].migrate_types.size(), 2u);
+  EXPECT_EQ(zones[0].migrate_types[1].type, "Movable");
+  EXPECT_EQ(zones[0].migrate_types[1].free_pages, 1u + 2u + 4u);
+  ASSERT_EQ(zones[1].migrate_types.size(), 1u);
+  EXPECT_EQ(zones[1].migrate_types[0].free_pages, 4u + 4u + 4u);
+}
+
+class MemoryFragmentationTaskTest : public MockLocalContext {};
+
+TEST_F(MemoryFragmentationTaskTest, ReportsZonesAndCompaction) {
+  MemoryFragmentationTask task(provider, metrics, context);
+  ASSERT_TRUE(parse_buddyinfo(BUDDYINFO_SAMPLE, task.buddy));
+  task.pagetypeinfo_text = PAGETYPEINFO_SAMPLE;
+
+  bool rebuilt;
+  ASSERT_TRUE(task.compaction.update("compact_stall 10\ncompact_fail 4\n",
+                                     task.prev_compaction, rebuilt));
+  ASSERT_TRUE(task.compaction.update("compact_stall 30\ncompact_fail 4\n",
+                                     task.current_compaction, rebuilt));
+  task.time_delta_seconds = 2.0;
+  task.calculate();
+
+  const auto &zones = metrics.memory_zones;
+  ASSERT_EQ(zones.size(), 3u);
+  EXPECT_EQ(zones[0].free_pages_by_order[10], 2048u);
+  EXPECT_EQ(zones[0].free_pages, 256u + 512u + 2048u);
+  EXPECT_NEAR(zones[1].fragmentation_index, 1.0, 0.001);
+  EXPECT_EQ(zones[2].free_pages, 4u + 4u + 4u);
+  EXPECT_EQ(zones[2].migrate_types.size(), 1u);
+  EXPECT_NEAR(metrics.stability.memory_fragmentation_index,
+              (zones[0].fragmentation_index + zones[1].fragmentation_index +
+               zones[2].fragmentation_index) /
+                  3,
+              1e-9);
+
+  ASSERT_EQ(metrics.compaction.size(), 2u);
+  EXPECT_EQ(metrics.compaction[0].name, "compact_stall");
+  EXPECT_DOUBLE_EQ(metrics.compaction[0].per_sec, 10.0);
+  EXPECT_DOUBLE_EQ(metrics.compaction[1].per_sec, 0.0);
+}
+
 }; // namespace telemetry
@@ -0,0 +1,54 @@
+// tests/unit_hwmon.cpp
+#include "hwmonitor.hpp"
+#include "sysfs_fixture.hpp"
+#include <gtest/gtest.h>
+
+namespace telemetry {
+
+class HwmonTest : public SysfsFixture<> {
+protected:
+  void SetUp() override {
+    SysfsFixture::SetUp();
+    write("hwmon0/name", "coretemp\n");
+    write("hwmon0/temp2_input", "41000\n");
+    write("hwmon0/temp2_label", "Core 0\n");
+    write("hwmon0/temp1_input", "45500\n");
+    write("hwmon0/temp1_label", "Package id 0\n");
+    write("hwmon1/name", "nct6775\n");
+    write("hwmon1/fan1_input", "1200\n");
+    write("hwmon1/in0_input", "1050\n");
+    write("hwmon1/pwm1", "128\n");
+  }
+};
+
+TEST_F(HwmonTest, DiscoversAndScalesChannels) {
+  HwmonSensors sensors;
+  sensors.discover(base.string());
+
+  std::vector<SensorReading> out;
+  sensors.read(out);
+  ASSERT_EQ(out.size(), 4u);
+
+  EXPECT_EQ(out[0].chip, "coretemp");
+  EXPECT_EQ(out[0].label, "Package id 0");
+  EXPECT_DOUBLE_EQ(out[0].value, 45.5);
+  EXPECT_EQ(out[1].label, "Core 0");
+
+  EXPECT_EQ(out[2].kind, SensorKind::Fan);
+  EXPECT_DOUBLE_EQ(out[2].value, 1200.0);
+  EXPECT_EQ(out[3].kind, SensorKind::Voltage);
+  EXPECT_EQ(out[3].label, "in0");
+  EXPECT_DOUBLE_EQ(out[3].value, 1.05);
+}
+
+TEST_F(HwmonTest, CpuTemperatureUsesCachedPackageSensor) {
+  HwmonSensors sensors;
+  sensors.discover(base.string());
+  EXPECT_DOUBLE_EQ(sensors.read_cpu_temperature(), 45.5);
+
+  // The fd stays open; new values are picked up without rediscovery
+  write("hwmon0/temp1_input", "50000\n");
+  EXPECT_DOUBLE_EQ(sensors.read_cpu_temperature(), 50.0);
+}
+
+}; // namespace telemetry
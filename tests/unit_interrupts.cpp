@@ -0,0 +1,92 @@
+// tests/unit_interrupts.cpp
+#include "interrupts.hpp"
+#include "mock_context.hpp"
+#include "polling.hpp"
+#include <gtest/gtest.h>
+
+namespace telemetry {
+
+static const char *INTERRUPTS_SAMPLE =
+    "           CPU0       CPU2       \n"
+    "  0:         36          0   IO-APIC   2-edge      timer\n"
+    " 24:       1000       2000  IR-PCI-MSI 524288-edge      eth0-TxRx-0\n"
+    " 25:         10         10  IR-PCI-MSI 524289-edge      eth0-TxRx-1\n"
+    "LOC:        500        700   Local timer interrupts\n"
+    "ERR:          3\n";
+
+static const char *SOFTIRQS_SAMPLE = "                    CPU0       CPU2\n"
+                                     "          HI:          0          0\n"
+                                     "      NET_RX:        100        400\n";
+
+TEST(CounterMatrixParse, ReadsRowsColumnsAndDescriptions) {
+  CounterMatrix matrix;
+  ASSERT_TRUE(parse_counter_matrix(INTERRUPTS_SAMPLE, matrix));
+  ASSERT_EQ(matrix.columns(), 2u);
+  EXPECT_EQ(matrix.cpus[1], 2u);
+  ASSERT_EQ(matrix.rows(), 5u);
+  EXPECT_EQ(matrix.names[1], "24");
+  EXPECT_EQ(matrix.descriptions[1], "IR-PCI-MSI 524288-edge      eth0-TxRx-0");
+  EXPECT_EQ(matrix.counts[1 * 2 + 1], 2000u);
+  EXPECT_EQ(matrix.names[4], "ERR");
+  EXPECT_EQ(matrix.counts[4 * 2], 3u);
+  EXPECT_EQ(matrix.counts[4 * 2 + 1], 0u);
+
+  // Re-parsing the same layout keeps the labels' storage
+  const char *label = matrix.names[1].data();
+  ASSERT_TRUE(parse_counter_matrix(INTERRUPTS_SAMPLE, matrix));
+  EXPECT_EQ(matrix.names[1].data(), label);
+
+  CounterMatrix softirqs;
+  ASSERT_TRUE(parse_counter_matrix(SOFTIRQS_SAMPLE, softirqs));
+  EXPECT_EQ(softirqs.names[1], "NET_RX");
+  EXPECT_TRUE(softirqs.descriptions[1].empty());
+  EXPECT_FALSE(softirqs.same_layout(matrix));
+}
+
+class InterruptsTest : public MockLocalContext {};
+
+TEST_F(InterruptsTest, ReportsTopIrqsAndSoftirqsPerCpu) {
+  context.settings.interrupts.top_k = 2;
+  InterruptsPollingTask task(provider, metrics, context);
+  ASSERT_TRUE(parse_counter_matrix(INTERRUPTS_SAMPLE, task.prev_irqs));
+  ASSERT_TRUE(parse_counter_matrix(SOFTIRQS_SAMPLE, task.prev_softirqs));
+
+  ASSERT_TRUE(parse_counter_matrix(
+      "           CPU0       CPU2       \n"
+      "  0:         38          0   IO-APIC   2-edge      timer\n"
+      " 24:       1000       4000  IR-PCI-MSI 524288-edge      eth0-TxRx-0\n"
+      " 25:         10         10  IR-PCI-MSI 524289-edge      eth0-TxRx-1\n"
+      "LOC:        700        900   Local timer interrupts\n"
+      "ERR:          3\n",
+      task.current_irqs));
+  ASSERT_TRUE(parse_counter_matrix("                    CPU0       CPU2\n"
+                                   "          HI:          0          0\n"
+                                   "      NET_RX:        300        400\n",
+                                   task.current_softirqs));
+  task.time_delta_seconds = 2.0;
+  task.calculate();
+
+  ASSERT_EQ(metrics.interrupt_cpus.size(), 2u);
+  EXPECT_EQ(metrics.interrupt_cpus[1], 2u);
+
+  // Top two IRQ lines, then the remaining three folded into "other"
+  ASSERT_EQ(metrics.interrupts.size(), 3u);
+  EXPECT_EQ(metrics.interrupts[0].name, "24");
+  EXPECT_EQ(metrics.interrupts[0].description,
+            "IR-PCI-MSI 524288-edge eth0-TxRx-0");
+  EXPECT_DOUBLE_EQ(metrics.interrupts[0].per_sec, 1000.0);
+  EXPECT_FLOAT_EQ(metrics.interrupts[0].per_cpu[1], 1000.0f);
+  EXPECT_EQ(metrics.interrupts[1].name, "LOC");
+  EXPECT_DOUBLE_EQ(metrics.interrupts[1].per_sec, 200.0);
+  EXPECT_EQ(metrics.interrupts[2].name, "other");
+  EXPECT_FLOAT_EQ(metrics.interrupts[2].per_cpu[0], 1.0f);
+  EXPECT_DOUBLE_EQ(metrics.interrupts[2].per_sec, 1.0);
+
+  ASSERT_EQ(metrics.softirq_cpus.size(), 2u);
+  ASSERT_EQ(metrics.softirqs.size(), 2u);
+  EXPECT_EQ(metrics.softirqs[1].name, "NET_RX");
+  EXPECT_FLOAT_EQ(metrics.softirqs[1].per_cpu[0], 100.0f);
+  EXPECT_FLOAT_EQ(metrics.softirqs[1].per_cpu[1], 0.0f);
+}
+
+}; // namespace telemetry
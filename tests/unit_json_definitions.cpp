@@ -13,6 +13,8 @@ class StabilityValidation : public MockLocalContext {};
 TEST_F(StabilityValidation, JsonRoundTrip) {
   metrics.stability.memory_fragmentation_index = 0.45;
   metrics.stability.file_descriptors_allocated = 5000;
+  metrics.stability.psi(PsiKind::Memory).some.avg10 = 7.5;
+  metrics.stability.psi(PsiKind::Io).full.stall_us_per_sec = 1200.0;
 
   // 1. Serialize to JSON object
   nlohmann::json j = metrics;
@@ -29,6 +31,11 @@ TEST_F(StabilityValidation, JsonRoundTrip) {
 
   EXPECT_NEAR(restored.stability.memory_fragmentation_index, 0.45, 0.001);
   EXPECT_EQ(restored.stability.file_descriptors_allocated, 5000);
+  // The UI reads pressure.<kind>.some as a plain number
+  EXPECT_DOUBLE_EQ(j["stability"]["pressure"]["memory"]["some"].get<double>(),
+                   7.5);
+  EXPECT_DOUBLE_EQ(
+      restored.stability.psi(PsiKind::Io).full.stall_us_per_sec, 1200.0);
 }
 
 }; // namespace telemetry
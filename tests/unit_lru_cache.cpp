@@ -0,0 +1,39 @@
+// tests/unit_lru_cache.cpp
+#include "lru_cache.hpp"
+#include <gtest/gtest.h>
+
+namespace telemetry {
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+  LruCache<int, std::string> cache(2);
+  cache.put(1, "one");
+  cache.put(2, "two");
+  ASSERT_NE(cache.get(1), nullptr); // 2 is now the oldest
+  cache.put(3, "three");
+
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_FALSE(cache.contains(2));
+  EXPECT_EQ(*cache.get(1), "one");
+  EXPECT_EQ(*cache.get(3), "three");
+}
+
+TEST(LruCacheTest, PutReplacesAndCapacityShrinks) {
+  LruCache<int, int> cache(3);
+  cache.put(1, 10);
+  cache.put(2, 20);
+  cache.put(3, 30);
+  EXPECT_EQ(cache.put(1, 11), 11); // 2 is now the oldest
+  EXPECT_EQ(cache.size(), 3u);
+
+  cache.set_capacity(1);
+  EXPECT_EQ(cache.size(), 1u);
+  ASSERT_NE(cache.get(1), nullptr);
+  EXPECT_EQ(*cache.get(1), 11);
+  EXPECT_EQ(cache.get(2), nullptr);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.capacity(), 1u);
+}
+
+}; // namespace telemetry
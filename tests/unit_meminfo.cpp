@@ -0,0 +1,131 @@
+// tests/unit_meminfo.cpp
+#include "meminfo.hpp"
+#include "mock_context.hpp"
+#include "polling.hpp"
+#include "sysfs_fixture.hpp"
+#include <gtest/gtest.h>
+
+namespace telemetry {
+
+static const char *MEMINFO_SAMPLE = "MemTotal:       16318312 kB\n"
+                                    "MemFree:         1200000 kB\n"
+                                    "MemAvailable:    8159156 kB\n"
+                                    "Buffers:          100000 kB\n"
+                                    "Cached:          5000000 kB\n"
+                                    "SwapCached:            0 kB\n"
+                                    "Active(anon):     700000 kB\n"
+                                    "Inactive(file):   300000 kB\n"
+                                    "SwapTotal:       2000000 kB\n"
+                                    "SwapFree:        1500000 kB\n"
+                                    "Dirty:              1234 kB\n"
+                                    "FutureField:          42 kB\n"
+                                    "HugePages_Total:       8\n"
+                                    "Hugepagesize:       2048 kB\n"
+                                    "DirectMap1G:     4194304 kB";
+
+TEST(MemInfoParse, ParsesEveryKnownLabel) {
+  MemInfoFields fields;
+  parse_meminfo(MEMINFO_SAMPLE, fields);
+
+  EXPECT_EQ(fields[MemInfoField::MemTotal], 16318312u);
+  EXPECT_EQ(fields[MemInfoField::Cached], 5000000u);
+  EXPECT_EQ(fields[MemInfoField::ActiveAnon], 700000u);
+  EXPECT_EQ(fields[MemInfoField::InactiveFile], 300000u);
+  EXPECT_EQ(fields[MemInfoField::Dirty], 1234u);
+  EXPECT_EQ(fields[MemInfoField::HugePagesTotal], 8u);
+  EXPECT_EQ(fields[MemInfoField::Hugepagesize], 2048u);
+  // The last line has no trailing newline
+  EXPECT_EQ(fields[MemInfoField::DirectMap1G], 4194304u);
+  // Not in the sample
+  EXPECT_EQ(fields[MemInfoField::Shmem], 0u);
+}
+
+TEST(MemInfoParse, LabelsRoundTripThroughTheHash) {
+  for (size_t i = 0; i < MEMINFO_FIELD_COUNT; ++i) {
+    auto field = static_cast<MemInfoField>(i);
+    MemInfoField found;
+    ASSERT_TRUE(meminfo_field_from_name(meminfo_field_name(field), found))
+        << meminfo_field_name(field);
+    EXPECT_EQ(found, field);
+  }
+  MemInfoField found;
+  EXPECT_FALSE(meminfo_field_from_name("FutureField", found));
+  EXPECT_FALSE(meminfo_field_from_name("", found));
+}
+
+TEST(MemInfoParse, SummaryAndFieldSelection) {
+  std::istringstream in(MEMINFO_SAMPLE);
+  MemInfo meminfo, swapinfo;
+  get_mem_usage(in, meminfo, swapinfo);
+  EXPECT_EQ(meminfo.total_kb, 16318312);
+  EXPECT_EQ(meminfo.used_kb, 16318312 - 8159156);
+  EXPECT_EQ(meminfo.percent, 50);
+  EXPECT_EQ(swapinfo.used_kb, 500000);
+  EXPECT_EQ(swapinfo.percent, 25);
+
+  auto selected = select_meminfo_fields({"Dirty", "Bogus", "Active(anon)"});
+  ASSERT_EQ(selected.size(), 2u);
+  EXPECT_EQ(selected[0], MemInfoField::Dirty);
+  EXPECT_EQ(selected[1], MemInfoField::ActiveAnon);
+  EXPECT_EQ(select_meminfo_fields({"*"}).size(), MEMINFO_FIELD_COUNT);
+}
+
+class NumaMemoryTest : public SysfsFixture<MockLocalContext> {
+protected:
+  void SetUp() override {
+    SysfsFixture::SetUp();
+    for (int node : {1, 0}) {
+      std::string prefix = "Node " + std::to_string(node) + " ";
+      write("node" + std::to_string(node) + "/meminfo",
+            prefix + "MemTotal:        8000000 kB\n" + prefix +
+                "MemFree:         2000000 kB\n" + prefix +
+                "MemUsed:         6000000 kB\n" + prefix +
+                "FilePages:       1500000 kB\n");
+      write("node" + std::to_string(node) + "/numastat",
+            "numa_hit 1000\nnuma_miss 100\nnuma_foreign 50\n");
+    }
+    // Not a node directory
+    write("possible", "0-1\n");
+  }
+};
+
+TEST(NumaMemoryParse, NodeMeminfoAndNumastat) {
+  NumaNodeSnapshot snapshot;
+  parse_node_meminfo("Node 3 MemTotal:       16318312 kB\n"
+                     "Node 3 MemFree:         1234 kB\n"
+                     "Node 3 FilePages:        99 kB\n",
+                     snapshot);
+  EXPECT_EQ(snapshot.total_kb, 16318312);
+  EXPECT_EQ(snapshot.free_kb, 1234);
+  EXPECT_EQ(snapshot.file_kb, 99);
+
+  parse_numastat("numa_hit 5\nnuma_miss 7\nnuma_foreign 9\nlocal_node 5\n",
+                 snapshot);
+  EXPECT_EQ(snapshot.numa_miss, 7u);
+  EXPECT_EQ(snapshot.numa_foreign, 9u);
+}
+
+TEST_F(NumaMemoryTest, ReportsNodeUsageAndMissRates) {
+  NumaMemoryPollingTask task(provider, metrics, context);
+  task.discover(base.string());
+  ASSERT_EQ(task.nodes.size(), 2u);
+  EXPECT_EQ(task.nodes[0].node, 0u);
+  task.take_initial_snapshot();
+
+  write("node1/numastat", "numa_hit 1000\nnuma_miss 300\nnuma_foreign 70\n");
+  task.current_snapshots = task.read_snapshot();
+  task.time_delta_seconds = 2.0;
+  task.calculate();
+
+  ASSERT_EQ(metrics.numa_memory.size(), 2u);
+  const auto &node1 = metrics.numa_memory[1];
+  EXPECT_EQ(node1.node, 1u);
+  EXPECT_EQ(node1.used_kb, 6000000);
+  EXPECT_EQ(node1.file_kb, 1500000);
+  EXPECT_EQ(node1.percent, 75);
+  EXPECT_DOUBLE_EQ(node1.numa_miss_per_sec, 100.0);
+  EXPECT_DOUBLE_EQ(node1.numa_foreign_per_sec, 10.0);
+  EXPECT_DOUBLE_EQ(metrics.numa_memory[0].numa_miss_per_sec, 0.0);
+}
+
+}; // namespace telemetry
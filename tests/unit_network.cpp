@@ -0,0 +1,308 @@
+// tests/unit_network.cpp
+#include "mock_context.hpp"
+#include "networkstats.hpp"
+#include "polling.hpp"
+#include <gtest/gtest.h>
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace telemetry {
+
+class NetworkCounterTest : public MockLocalContext {};
+
+static const char *NET_DEV_SAMPLE =
+    "Inter-|   Receive                                                |  "
+    "Transmit\n"
+    " face |bytes    packets errs drop fifo frame compressed multicast|bytes "
+    "   packets errs drop fifo colls carrier compressed\n"
+    "  eth0: 1000 10 1 2 3 4 5 6 2000 20 7 8 9 10 11 12\n";
+
+TEST_F(NetworkCounterTest, ParsesFullCounterSet) {
+  NetworkPollingTask task(provider, metrics, context);
+  std::istringstream in(NET_DEV_SAMPLE);
+
+  auto snapshots = task.read_data(in);
+  ASSERT_EQ(snapshots.count("eth0"), 1u);
+  const auto &s = snapshots["eth0"];
+  EXPECT_EQ(s.rx_bytes, 1000u);
+  EXPECT_EQ(s.rx_errs, 1u);
+  EXPECT_EQ(s.rx_drop, 2u);
+  EXPECT_EQ(s.rx_multicast, 6u);
+  EXPECT_EQ(s.tx_bytes, 2000u);
+  EXPECT_EQ(s.tx_drop, 8u);
+  EXPECT_EQ(s.tx_colls, 10u);
+  EXPECT_EQ(s.tx_compressed, 12u);
+}
+
+TEST_F(NetworkCounterTest, RatesIncludeErrorsAndDrops) {
+  NetworkPollingTask task(provider, metrics, context);
+
+  NetworkSnapshot t1, t2;
+  t1.interface_name = t2.interface_name = "eth0";
+  t2.rx_packets = 200;
+  t2.rx_errs = 4;
+  t2.rx_drop = 10;
+  t2.tx_drop = 6;
+
+  task.prev_snapshot = {{"eth0", t1}};
+  task.current_snapshot = {{"eth0", t2}};
+  task.time_delta_seconds = 2.0;
+  task.calculate();
+
+  ASSERT_EQ(metrics.network_interfaces.size(), 1u);
+  const auto &r = metrics.network_interfaces[0];
+  EXPECT_DOUBLE_EQ(r.rx_packets_per_sec, 100.0);
+  EXPECT_DOUBLE_EQ(r.rx_errors_per_sec, 2.0);
+  EXPECT_DOUBLE_EQ(r.rx_dropped_per_sec, 5.0);
+  EXPECT_DOUBLE_EQ(r.tx_dropped_per_sec, 3.0);
+}
+
+TEST_F(NetworkCounterTest, ThirtyTwoBitWrap) {
+  NetworkPollingTask task(provider, metrics, context);
+
+  NetworkSnapshot t1, t2;
+  t1.rx_bytes = UINT32_MAX - 99;
+  t2.rx_bytes = 100;
+
+  task.prev_snapshot = {{"eth0", t1}};
+  task.current_snapshot = {{"eth0", t2}};
+  task.counter_width = CounterWidth::Bits32;
+  task.time_delta_seconds = 1.0;
+  task.calculate();
+
+  ASSERT_EQ(metrics.network_interfaces.size(), 1u);
+  EXPECT_DOUBLE_EQ(metrics.network_interfaces[0].rx_bytes_per_sec, 200.0);
+}
+
+TEST_F(NetworkCounterTest, SixtyFourBitResetBelowFourGiB) {
+  NetworkPollingTask task(provider, metrics, context);
+
+  // A recreated veth restarts its 64-bit counters from zero
+  NetworkSnapshot t1, t2;
+  t1.rx_bytes = 3000000000ULL;
+  t2.rx_bytes = 100;
+
+  task.prev_snapshot = {{"veth0", t1}};
+  task.current_snapshot = {{"veth0", t2}};
+  task.time_delta_seconds = 1.0;
+  task.calculate();
+
+  ASSERT_EQ(metrics.network_interfaces.size(), 1u);
+  EXPECT_DOUBLE_EQ(metrics.network_interfaces[0].rx_bytes_per_sec, 100.0);
+}
+
+TEST_F(NetworkCounterTest, FilterAppliedAtParseTime) {
+  context.interfaces = {"eth*", "lo"};
+  NetworkPollingTask task(provider, metrics, context);
+  std::istringstream in(std::string(NET_DEV_SAMPLE) +
+                        "  eth1: 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0\n"
+                        "  veth9: 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0\n"
+                        "    lo: 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0\n");
+
+  auto snapshots = task.read_data(in);
+  EXPECT_EQ(snapshots.size(), 3u);
+  EXPECT_EQ(snapshots.count("veth9"), 0u);
+}
+
+TEST_F(NetworkCounterTest, TopKWithOtherBucket) {
+  context.settings.network.top_k = 2;
+  NetworkPollingTask task(provider, metrics, context);
+
+  NetworkSnapshotMap t1, t2;
+  const std::vector<std::pair<std::string, unsigned long long>> traffic = {
+      {"eth0", 500}, {"veth1", 10}, {"veth2", 900}, {"veth3", 30}};
+  for (const auto &[name, bytes] : traffic) {
+    t1[name].interface_name = t2[name].interface_name = name;
+    t2[name].rx_bytes = bytes;
+  }
+
+  task.prev_snapshot = t1;
+  task.current_snapshot = t2;
+  task.time_delta_seconds = 1.0;
+  task.calculate();
+
+  const auto &out = metrics.network_interfaces;
+  ASSERT_EQ(out.size(), 3u);
+  EXPECT_EQ(out[0].interface_name, "veth2");
+  EXPECT_EQ(out[1].interface_name, "eth0");
+  EXPECT_EQ(out[2].interface_name, "other");
+  EXPECT_DOUBLE_EQ(out[2].rx_bytes_per_sec, 40.0);
+  EXPECT_EQ(out[2].aggregated_interfaces, 2u);
+}
+
+// Appends one netlink message, as the kernel would pack it in a datagram
+static void append_message(std::vector<char> &buffer, uint16_t type,
+                           uint32_t seq, const void *payload, size_t length) {
+  size_t offset = buffer.size();
+  buffer.resize(offset + NLMSG_SPACE(length), 0);
+  auto *nh = reinterpret_cast<nlmsghdr *>(buffer.data() + offset);
+  nh->nlmsg_len = NLMSG_LENGTH(length);
+  nh->nlmsg_type = type;
+  nh->nlmsg_seq = seq;
+  std::memcpy(NLMSG_DATA(nh), payload, length);
+}
+
+static void append_link(std::vector<char> &buffer, uint32_t seq,
+                        const std::string &name,
+                        const rtnl_link_stats64 &stats) {
+  std::vector<char> payload(NLMSG_ALIGN(sizeof(ifinfomsg)), 0);
+  auto append_attr = [&](unsigned short type, const void *data, size_t len) {
+    size_t offset = payload.size();
+    payload.resize(offset + RTA_SPACE(len), 0);
+    auto *rta = reinterpret_cast<rtattr *>(payload.data() + offset);
+    rta->rta_type = type;
+    rta->rta_len = static_cast<unsigned short>(RTA_LENGTH(len));
+    std::memcpy(RTA_DATA(rta), data, len);
+  };
+  append_attr(IFLA_IFNAME, name.c_str(), name.size() + 1);
+  append_attr(IFLA_STATS64, &stats, sizeof(stats));
+  append_message(buffer, RTM_NEWLINK, seq, payload.data(), payload.size());
+}
+
+TEST(LinkStatsReplies, NamedRequestsCountDownAndSkipStaleReplies) {
+  rtnl_link_stats64 eth0{};
+  eth0.rx_bytes = 1000;
+  eth0.rx_dropped = 2;
+  eth0.rx_missed_errors = 3;
+  eth0.rx_crc_errors = 1;
+  eth0.rx_frame_errors = 1;
+  eth0.tx_carrier_errors = 1;
+  eth0.tx_aborted_errors = 1;
+  rtnl_link_stats64 eth1{};
+  eth1.tx_bytes = 42;
+
+  std::vector<char> buffer;
+  append_link(buffer, 5, "old0", eth1); // Left over from a timed-out read
+  append_link(buffer, 10, "eth0", eth0);
+  nlmsgerr unknown{};
+  unknown.error = -ENODEV;
+  append_message(buffer, NLMSG_ERROR, 11, &unknown, sizeof(unknown));
+  append_link(buffer, 12, "eth1", eth1);
+
+  LinkStatsReader::ReplyBatch batch;
+  batch.first_seq = 10;
+  batch.last_seq = 12;
+  batch.pending = 3;
+  NetworkSnapshotMap out;
+  ASSERT_TRUE(LinkStatsReader::parse_replies(buffer.data(), buffer.size(),
+                                             batch, InterfaceFilter(), out));
+  EXPECT_EQ(batch.pending, 0u);
+  ASSERT_EQ(out.size(), 2u);
+  EXPECT_EQ(out["eth0"].rx_bytes, 1000u);
+  // Detailed errors are folded like /proc/net/dev
+  EXPECT_EQ(out["eth0"].rx_drop, 5u);
+  EXPECT_EQ(out["eth0"].rx_frame, 2u);
+  EXPECT_EQ(out["eth0"].tx_carrier, 2u);
+  EXPECT_EQ(out["eth1"].tx_bytes, 42u);
+}
+
+TEST(LinkStatsReplies, DumpIsFilteredAndEndsWithDone) {
+  std::vector<char> buffer;
+  rtnl_link_stats64 stats{};
+  append_link(buffer, 20, "eth0", stats);
+  append_link(buffer, 20, "veth1", stats);
+  int done = 0;
+  append_message(buffer, NLMSG_DONE, 20, &done, sizeof(done));
+
+  LinkStatsReader::ReplyBatch batch;
+  batch.first_seq = batch.last_seq = 20;
+  batch.pending = 1;
+  batch.dump = true;
+  NetworkSnapshotMap out;
+  ASSERT_TRUE(LinkStatsReader::parse_replies(buffer.data(), buffer.size(),
+                                             batch, InterfaceFilter({"eth*"}),
+                                             out));
+  EXPECT_EQ(batch.pending, 0u);
+  EXPECT_EQ(out.size(), 1u);
+  EXPECT_EQ(out.count("eth0"), 1u);
+}
+
+TEST(LinkStatsReplies, RejectedDumpFails) {
+  std::vector<char> buffer;
+  nlmsgerr error{};
+  error.error = -EPERM;
+  append_message(buffer, NLMSG_ERROR, 30, &error, sizeof(error));
+
+  LinkStatsReader::ReplyBatch batch;
+  batch.first_seq = batch.last_seq = 30;
+  batch.pending = 1;
+  batch.dump = true;
+  NetworkSnapshotMap out;
+  EXPECT_FALSE(LinkStatsReader::parse_replies(buffer.data(), buffer.size(),
+                                              batch, InterfaceFilter(), out));
+}
+
+// Replaces a netlink socket fd with one end of a local datagram pair so the
+// test controls which notifications arrive. Returns the sending end.
+static int fake_notification_socket(int netlink_fd) {
+  int pair[2];
+  if (::socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0, pair) != 0)
+    return -1;
+  ::dup2(pair[0], netlink_fd);
+  ::close(pair[0]);
+  return pair[1];
+}
+
+static void send_notification(int fd, uint16_t type) {
+  std::vector<char> message;
+  ifaddrmsg ifa{};
+  append_message(message, type, 0, &ifa, sizeof(ifa));
+  ASSERT_EQ(::send(fd, message.data(), message.size(), 0),
+            static_cast<ssize_t>(message.size()));
+}
+
+TEST(InterfaceAddressCacheTest, DrainsAddressNotifications) {
+  InterfaceAddressCache cache;
+  if (!cache.open())
+    GTEST_SKIP() << "NETLINK_ROUTE unavailable";
+  int peer = fake_notification_socket(cache.socket.get_fd());
+  ASSERT_GE(peer, 0);
+
+  EXPECT_FALSE(cache.drain_notifications()); // Nothing queued
+  send_notification(peer, RTM_NEWLINK);
+  EXPECT_FALSE(cache.drain_notifications()); // Not an address change
+  send_notification(peer, RTM_NEWLINK);
+  send_notification(peer, RTM_DELADDR);
+  EXPECT_TRUE(cache.drain_notifications());
+  EXPECT_FALSE(cache.drain_notifications()); // Fully drained
+  ::close(peer);
+}
+
+TEST(InterfaceAddressCacheTest, ReloadsOnlyAfterNotifications) {
+  InterfaceAddressCache cache;
+  if (!cache.open())
+    GTEST_SKIP() << "NETLINK_ROUTE unavailable";
+  int peer = fake_notification_socket(cache.socket.get_fd());
+  ASSERT_GE(peer, 0);
+
+  cache.poll(); // Initial load
+  ASSERT_NE(cache.find("lo"), nullptr);
+  EXPECT_EQ(cache.find("lo")->ipv4, "127.0.0.1");
+
+  cache.addresses.clear();
+  cache.poll();
+  EXPECT_EQ(cache.find("lo"), nullptr); // No change reported, no reload
+
+  send_notification(peer, RTM_NEWADDR);
+  cache.poll();
+  EXPECT_NE(cache.find("lo"), nullptr);
+  ::close(peer);
+}
+
+TEST(InterfaceAddressCacheTest, ReloadsEveryPollWithoutSocket) {
+  // open() was never called or failed: getifaddrs() runs on every poll
+  InterfaceAddressCache cache;
+  EXPECT_TRUE(cache.drain_notifications());
+  cache.poll();
+  ASSERT_NE(cache.find("lo"), nullptr);
+
+  cache.addresses.clear();
+  cache.poll();
+  EXPECT_NE(cache.find("lo"), nullptr);
+}
+
+}; // namespace telemetry
@@ -0,0 +1,56 @@
+// tests/unit_proc_file.cpp
+#include "proc_file.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+namespace telemetry {
+
+TEST(ProcFileTest, RereadsFromStartOnEveryCall) {
+  std::string path = testing::TempDir() + "proc_file_test";
+  std::ofstream(path) << "first";
+
+  ProcFile file(path);
+  ASSERT_TRUE(file.is_open());
+  std::string buffer;
+  ASSERT_TRUE(file.read(buffer));
+  EXPECT_EQ(buffer, "first");
+
+  std::ofstream(path, std::ios::trunc) << "second value";
+  ASSERT_TRUE(file.read(buffer));
+  EXPECT_EQ(buffer, "second value");
+
+  std::remove(path.c_str());
+}
+
+TEST(ProcFileTest, GrowsPastOnePage) {
+  std::string path = testing::TempDir() + "proc_file_large";
+  std::string content(10000, 'x');
+  std::ofstream(path) << content;
+
+  ProcFile file(path);
+  std::string buffer;
+  ASSERT_TRUE(file.read(buffer));
+  EXPECT_EQ(buffer.size(), content.size());
+
+  std::remove(path.c_str());
+}
+
+TEST(ProcFileTest, MissingFileFailsCleanly) {
+  ProcFile file("/nonexistent/telemetry/stat");
+  std::string buffer = "stale";
+  EXPECT_FALSE(file.is_open());
+  EXPECT_FALSE(file.read(buffer));
+}
+
+TEST(CounterDelta, HandlesWrapAndReset) {
+  EXPECT_EQ(counter_delta(150, 100), 50u);
+  // 32-bit counter wrapped past 2^32
+  EXPECT_EQ(counter_delta(5, UINT32_MAX - 4, CounterWidth::Bits32), 10u);
+  // 64-bit counter going backwards is a reset, even below 2^32
+  EXPECT_EQ(counter_delta(5, UINT32_MAX - 4), 5u);
+  EXPECT_EQ(counter_delta(7, 1ULL << 40, CounterWidth::Bits32), 7u);
+}
+
+}; // namespace telemetry
@@ -23,4 +23,153 @@ TEST_F(ProcessIOTest, AuditSelfProcess) {
   EXPECT_GE(list[0].io_read_bytes, 0);
 }
 
+TEST_F(ProcessIOTest, CompactRecordFixedPoint) {
+  ProcessInfo proc;
+  proc.set_cpu_percent(12.345);
+  proc.set_mem_percent(250.0); // Clamped to 100%
+  proc.set_name("a-very-long-process-name");
+
+  EXPECT_NEAR(proc.cpu_percent(), 12.35, 0.001);
+  EXPECT_DOUBLE_EQ(proc.mem_percent(), 100.0);
+  EXPECT_STREQ(proc.name, "a-very-long-pro"); // Truncated to TASK_COMM_LEN
+}
+
+TEST_F(ProcessIOTest, ListViewsShareRecords) {
+  ProcessInfo first, second;
+  first.pid = 1;
+  second.pid = 2;
+  metrics.process_records = {first, second};
+  metrics.top_processes_real_cpu = {1, 0};
+  metrics.top_processes_real_mem = {1};
+
+  ProcessListView cpu = metrics.processes(metrics.top_processes_real_cpu);
+  ProcessListView mem = metrics.processes(metrics.top_processes_real_mem);
+
+  ASSERT_EQ(cpu.size(), 2u);
+  EXPECT_EQ(cpu[0].pid, 2);
+  EXPECT_EQ(cpu[1].pid, 1);
+  EXPECT_EQ(&mem[0], &cpu[0]); // Same record, not a copy
+  EXPECT_EQ(cpu.cgroup(0), nullptr); // Not annotated
+}
+
+TEST(ProcessCgroupParse, PrefersUnifiedHierarchyAndNamesUnits) {
+  ProcessCgroup cgroup;
+  ASSERT_TRUE(parse_proc_cgroup("12:cpu,cpuacct:/system.slice/a.service\n"
+                                "1:name=systemd:/system.slice/b.service\n"
+                                "0::/system.slice/sshd.service\n",
+                                cgroup));
+  EXPECT_EQ(cgroup.path, "/system.slice/sshd.service");
+  EXPECT_EQ(cgroup.unit, "sshd.service");
+
+  ASSERT_TRUE(parse_proc_cgroup("1:name=systemd:/user.slice/session-2.scope\n"
+                                "0::\n",
+                                cgroup));
+  EXPECT_EQ(cgroup.path, "/user.slice/session-2.scope");
+  EXPECT_FALSE(parse_proc_cgroup("", cgroup));
+
+  EXPECT_EQ(cgroup_unit_name("/user.slice/user-1000.slice/user@1000.service/"
+                             "app.slice/app-firefox@1.service"),
+            "app-firefox@1.service");
+  EXPECT_EQ(cgroup_unit_name("/system.slice/docker-0123456789abcdef0123.scope"),
+            "docker:0123456789ab");
+  EXPECT_EQ(cgroup_unit_name("/docker/" + std::string(64, 'f')),
+            "docker:ffffffffffff");
+  EXPECT_EQ(cgroup_unit_name("/"), "");
+}
+
+TEST(SmapsRollupParse, SumsPrivatePagesIntoUss) {
+  SmapsRollup rollup;
+  ASSERT_TRUE(parse_smaps_rollup(
+      "55d0c0a00000-7ffd1b3fe000 ---p 00000000 00:00 0    [rollup]\n"
+      "Rss:                5000 kB\n"
+      "Pss:                3000 kB\n"
+      "Shared_Clean:       2500 kB\n"
+      "Private_Clean:       500 kB\n"
+      "Private_Dirty:      2000 kB\n"
+      "Swap:                 64 kB\n"
+      "SwapPss:              32 kB\n",
+      rollup));
+  EXPECT_EQ(rollup.rss_kb, 5000u);
+  EXPECT_EQ(rollup.pss_kb, 3000u);
+  EXPECT_EQ(rollup.uss_kb, 2500u);
+  EXPECT_EQ(rollup.swap_kb, 64u);
+  EXPECT_FALSE(parse_smaps_rollup("", rollup));
+
+  EXPECT_FALSE(smaps_rss_moved(1000, 1100, 10));
+  EXPECT_TRUE(smaps_rss_moved(1000, 1101, 10));
+  EXPECT_TRUE(smaps_rss_moved(1000, 800, 10));
+}
+
+TEST_F(ProcessIOTest, ReadsSmapsForTopMemoryProcesses) {
+  ProcessPollingTask task(provider, metrics, context);
+  ASSERT_TRUE(task.collect_smaps);
+  ProcessInfo self;
+  self.pid = getpid();
+  self.vmRssKb = 1000;
+  task.current_snapshots[self.pid].start_time = 7;
+
+  // The helper reads new processes right away; wait for its first result
+  for (int attempt = 0; attempt < 200; ++attempt) {
+    metrics.process_records = {self};
+    metrics.top_processes_real_mem = {0};
+    task.update_smaps();
+    if (metrics.process_records[0].pss_kb != 0)
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  const ProcessInfo &record = metrics.process_records[0];
+  EXPECT_GT(record.pss_kb, 0u);
+  EXPECT_GT(record.uss_kb, 0u);
+  EXPECT_LE(record.uss_kb, record.pss_kb);
+  task.smaps_refresher.stop();
+}
+
+TEST_F(ProcessIOTest, ReadsSmapsForTheAverageMemoryList) {
+  ProcessPollingTask task(provider, metrics, context);
+  ASSERT_TRUE(task.collect_smaps);
+  ProcessInfo self;
+  self.pid = getpid();
+  self.vmRssKb = 1000;
+  task.current_snapshots[self.pid].start_time = 7;
+
+  for (int attempt = 0; attempt < 200; ++attempt) {
+    metrics.process_records = {self};
+    metrics.top_processes_real_mem.clear();
+    metrics.top_processes_avg_mem = {0};
+    task.update_smaps();
+    if (metrics.process_records[0].pss_kb != 0)
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_GT(metrics.process_records[0].pss_kb, 0u);
+  // A process in both lists is requested once
+  metrics.top_processes_real_mem = {0};
+  task.update_smaps();
+  EXPECT_EQ(task.smaps_requests.size(), 1u);
+  task.smaps_refresher.stop();
+}
+
+TEST_F(ProcessIOTest, AnnotatesRecordsThroughCache) {
+  ProcessPollingTask task(provider, metrics, context);
+  ASSERT_TRUE(task.annotate_cgroups);
+  ProcessInfo self;
+  self.pid = getpid();
+  metrics.process_records = {self};
+  task.current_snapshots[self.pid].start_time = 42;
+
+  task.annotate_process_records();
+  ASSERT_EQ(metrics.process_cgroups.size(), 1u);
+  EXPECT_FALSE(metrics.process_cgroups[0].path.empty());
+
+  // Same (pid, start time): served from the cache, not re-read
+  task.cgroup_cache.put({self.pid, 42}, {"/cached", "cached.service"});
+  task.annotate_process_records();
+  EXPECT_EQ(metrics.process_cgroups[0].unit, "cached.service");
+
+  // A new start time means a new process behind the same pid
+  task.current_snapshots[self.pid].start_time = 43;
+  task.annotate_process_records();
+  EXPECT_NE(metrics.process_cgroups[0].path, "/cached");
+}
+
 }; // namespace telemetry
@@ -13,10 +13,75 @@ TEST_F(StabilityValidation, PSIRangesAreSane) {
   task.take_new_snapshot();
   task.calculate();
 
-  EXPECT_GE(metrics.stability.memory_pressure_some, 0.0);
-  EXPECT_LE(metrics.stability.memory_pressure_some, 100.0);
-  EXPECT_GE(metrics.stability.io_pressure_full, 0.0);
-  EXPECT_LE(metrics.stability.io_pressure_full, 100.0);
+  for (const PsiResource &resource : metrics.stability.pressure) {
+    EXPECT_GE(resource.some.avg10, 0.0);
+    EXPECT_LE(resource.some.avg10, 100.0);
+    EXPECT_GE(resource.full.avg300, 0.0);
+    EXPECT_LE(resource.full.avg300, 100.0);
+  }
+}
+
+TEST(PsiParse, ReadsEveryField) {
+  PsiResource resource;
+  ASSERT_TRUE(
+      parse_psi("some avg10=1.38 avg60=2.53 avg300=2.34 total=248213905\n"
+                "full avg10=0.07 avg60=0.18 avg300=0.05 total=16253230\n",
+                resource));
+  EXPECT_DOUBLE_EQ(resource.some.avg10, 1.38);
+  EXPECT_DOUBLE_EQ(resource.some.avg60, 2.53);
+  EXPECT_DOUBLE_EQ(resource.some.avg300, 2.34);
+  EXPECT_EQ(resource.some.total_us, 248213905u);
+  EXPECT_DOUBLE_EQ(resource.full.avg60, 0.18);
+  EXPECT_EQ(resource.full.total_us, 16253230u);
+
+  // /proc/pressure/irq only reports "full"
+  PsiResource irq;
+  ASSERT_TRUE(
+      parse_psi("full avg10=0.00 avg60=0.00 avg300=0.00 total=42\n", irq));
+  EXPECT_EQ(irq.full.total_us, 42u);
+  EXPECT_EQ(irq.some.total_us, 0u);
+  EXPECT_FALSE(parse_psi("", irq));
+}
+
+TEST_F(StabilityValidation, StallRateFromTotalDeltas) {
+  SystemStabilityPollingTask task(provider, metrics, context);
+  auto &prev = task.prev_pressure[static_cast<size_t>(PsiKind::Cpu)];
+  auto &curr = task.current_pressure[static_cast<size_t>(PsiKind::Cpu)];
+  parse_psi("some avg10=0.00 avg60=0.00 avg300=0.00 total=1000000\n", prev);
+  parse_psi("some avg10=5.00 avg60=1.00 avg300=0.50 total=1300000\n", curr);
+  task.prev_valid[static_cast<size_t>(PsiKind::Cpu)] = true;
+  task.current_valid[static_cast<size_t>(PsiKind::Cpu)] = true;
+  task.time_delta_seconds = 2.0;
+  task.calculate();
+
+  const PsiResource &cpu = metrics.stability.psi(PsiKind::Cpu);
+  EXPECT_DOUBLE_EQ(cpu.some.avg10, 5.0);
+  // 300 ms stalled over 2 s
+  EXPECT_DOUBLE_EQ(cpu.some.stall_us_per_sec, 150000.0);
+  EXPECT_DOUBLE_EQ(cpu.full.stall_us_per_sec, 0.0);
+}
+
+TEST_F(StabilityValidation, NoStallRateAcrossAFailedRead) {
+  SystemStabilityPollingTask task(provider, metrics, context);
+  size_t io = static_cast<size_t>(PsiKind::Io);
+  // The previous read failed and left zero totals
+  task.prev_valid[io] = false;
+  parse_psi("some avg10=1.00 avg60=1.00 avg300=1.00 total=90000000000\n",
+            task.current_pressure[io]);
+  task.current_valid[io] = true;
+  task.time_delta_seconds = 1.0;
+  task.calculate();
+  EXPECT_DOUBLE_EQ(metrics.stability.psi(PsiKind::Io).some.stall_us_per_sec,
+                   0.0);
+  EXPECT_DOUBLE_EQ(metrics.stability.psi(PsiKind::Io).some.avg10, 1.0);
+
+  // One tick later both sides are valid again
+  task.commit();
+  parse_psi("some avg10=1.00 avg60=1.00 avg300=1.00 total=90000500000\n",
+            task.current_pressure[io]);
+  task.calculate();
+  EXPECT_DOUBLE_EQ(metrics.stability.psi(PsiKind::Io).some.stall_us_per_sec,
+                   500000.0);
 }
 
 // Ensure File Descriptor allocation does not exceed system max
@@ -34,8 +99,9 @@ TEST_F(StabilityValidation, ProcessIOPopulated) {
   // 1. MANUALLY populate the list with the current process
   ProcessInfo mock_proc;
   mock_proc.pid = getpid(); // Audit ourselves
-  mock_proc.name = "unit_tests";
-  metrics.top_processes_real_cpu.push_back(mock_proc);
+  mock_proc.set_name("unit_tests");
+  metrics.process_records.push_back(mock_proc);
+  metrics.top_processes_real_cpu.push_back(0);
 
   // 2. Run the IO expansion logic
   // Ensure you use the specific class name you implemented for IO/FD auditing
@@ -47,7 +113,7 @@ TEST_F(StabilityValidation, ProcessIOPopulated) {
   ASSERT_FALSE(metrics.top_processes_real_cpu.empty());
 
   // Check that open_fds is now > 0 (it was 0 in your JSON output)
-  EXPECT_GT(metrics.top_processes_real_cpu[0].open_fds, 0);
+  EXPECT_GT(metrics.processes(metrics.top_processes_real_cpu)[0].open_fds, 0);
 }
 
 }; // namespace telemetry
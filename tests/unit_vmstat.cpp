@@ -0,0 +1,78 @@
+// tests/unit_vmstat.cpp
+#include "mock_context.hpp"
+#include "polling.hpp"
+#include "vmstat.hpp"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace telemetry {
+
+static const char *VMSTAT_SAMPLE = "nr_free_pages 123456\n"
+                                   "pgfault 1000\n"
+                                   "pgmajfault 10\n"
+                                   "pswpin 0\n"
+                                   "pswpout 4\n"
+                                   "oom_kill 1";
+
+TEST(VmstatTable, ResolvesCountersInConfiguredOrder) {
+  VmstatTable table({"oom_kill", "pgmajfault", "not_a_counter", "pgmajfault"});
+  std::vector<unsigned long long> values;
+  EXPECT_FALSE(table.parse(VMSTAT_SAMPLE, values));
+
+  ASSERT_TRUE(table.build(VMSTAT_SAMPLE));
+  ASSERT_EQ(table.counters().size(), 2u);
+  EXPECT_EQ(table.counters()[0], "oom_kill");
+  EXPECT_EQ(table.counters()[1], "pgmajfault");
+
+  ASSERT_TRUE(table.parse(VMSTAT_SAMPLE, values));
+  EXPECT_EQ(values[0], 1u);
+  EXPECT_EQ(values[1], 10u);
+
+  // A counter that moved to another line forces a rebuild
+  EXPECT_FALSE(table.parse("pgfault 1\npgmajfault 2\noom_kill 3\n", values));
+
+  VmstatTable all({"*"});
+  ASSERT_TRUE(all.build(VMSTAT_SAMPLE));
+  EXPECT_EQ(all.counters().size(), 6u);
+  ASSERT_TRUE(all.parse(VMSTAT_SAMPLE, values));
+  EXPECT_EQ(values[0], 123456u);
+}
+
+class VmstatTest : public MockLocalContext {
+protected:
+  std::filesystem::path path;
+
+  void SetUp() override {
+    path = std::filesystem::path(testing::TempDir()) / "vmstat_test";
+    std::ofstream(path) << VMSTAT_SAMPLE;
+  }
+  void TearDown() override { std::filesystem::remove(path); }
+};
+
+TEST_F(VmstatTest, ReportsConfiguredCounterRates) {
+  context.settings.vmstat.counters = {"pgfault", "pswpout", "oom_kill"};
+  VmstatPollingTask task(provider, metrics, context);
+  ASSERT_TRUE(task.vmstat.open(path.string()));
+  task.take_initial_snapshot();
+
+  std::ofstream(path) << "nr_free_pages 100000\n"
+                         "pgfault 3000\n"
+                         "pgmajfault 10\n"
+                         "pswpin 0\n"
+                         "pswpout 4\n"
+                         "oom_kill 3\n";
+  task.take_new_snapshot();
+  task.time_delta_seconds = 2.0;
+  task.calculate();
+
+  ASSERT_EQ(metrics.vmstat.size(), 3u);
+  EXPECT_EQ(metrics.vmstat[0].name, "pgfault");
+  EXPECT_DOUBLE_EQ(metrics.vmstat[0].per_sec, 1000.0);
+  EXPECT_DOUBLE_EQ(metrics.vmstat[1].per_sec, 0.0);
+  EXPECT_EQ(metrics.vmstat[2].name, "oom_kill");
+  EXPECT_DOUBLE_EQ(metrics.vmstat[2].per_sec, 1.0);
+}
+
+}; // namespace telemetry